@@ -0,0 +1,406 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include "benchmark/benchmark.h"
+#include "idstatebuilder.h"
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "pipelined_parser.h"
+#include "incremental_parser.h"
+#include "language.h"
+#include "rgeanalyzier.h"
+#include "perf_counters.h"
+#include "rge/idstatebuilder_factory.h"
+#include "utility/file_reader.h"
+#include "utility/utility_internal.h"
+
+/* Benchmarks for every stage of the pipeline. The results are emitted as JSON by default, so they can be
+ * saved and compared between releases, for example:
+ *     qcompiler_bench --benchmark_out=release.json
+ * Pass --benchmark_format=console to get the human readable table, and --perf_counters to add the
+ * hardware counters(cycles, instructions, cache and branch misses) of every benchmark.
+ */
+
+static bool perf_counters_enabled = false;
+
+/* Hardware counters of the timed part of a benchmark, reported as counters averaged over the iterations
+ * so they come out in the same JSON as the times. It should be created right before the loop, and the
+ * untimed parts of an iteration are paused through it. Events the kernel refuses are left out.
+ */
+class BenchCounters {
+public:
+	explicit BenchCounters(benchmark::State& state) : state_(state) {
+		if(!perf_counters_enabled) return;
+		counters_.reset(new PerfCounters);
+		counters_->Start();
+	}
+	~BenchCounters() {
+		if(!counters_) return;
+		counters_->Stop();
+		PerfSample sample = counters_->Read();
+		for(int i = 0; i < PERF_EVENT_COUNT; i++){
+			PerfEvent e = static_cast<PerfEvent>(i);
+			if(sample.Has(e)) state_.counters[PerfCounters::EventName(e)] = benchmark::Counter(
+				static_cast<double>(sample.value[i]), benchmark::Counter::kAvgIterations);
+		}
+	}
+	void PauseTiming() {
+		state_.PauseTiming();
+		if(counters_) counters_->Stop();
+	}
+	void ResumeTiming() {
+		if(counters_) counters_->Start();
+		state_.ResumeTiming();
+	}
+private:
+	benchmark::State& state_;
+	std::unique_ptr<PerfCounters> counters_;
+};
+
+//file written for a benchmark and removed once the benchmark finishes
+class BenchFile {
+public:
+	BenchFile(const std::string& name, const std::string& contents) : name_(name) {
+		std::ofstream outfile(name_, std::ios::binary);
+		outfile << contents;
+	}
+	~BenchFile() { std::remove(name_.c_str()); }
+	const std::string& Name() const { return name_; }
+private:
+	std::string name_;
+};
+
+//lines of 'id + num * ( id - num )', about 'bytes' bytes
+static std::string TextOfSize(size_t bytes){
+	const std::string line = "id + num * ( id - num ) / id\n";
+	std::string text;
+	text.reserve(bytes + line.size());
+	while(text.size() < bytes) text += line;
+	return text;
+}
+
+/* A left recursive grammar with 'levels' levels of binary operators, level i is
+ * <Li>-><Li>oi<Li+1>|<Li+1> and the last level is the operand. The expression grammar in files/ is
+ * the case of 2 levels.
+ */
+static std::string LayeredGrammar(int levels){
+	std::string syn = "<S>-><L0>\n";
+	for(int i = 0; i < levels; i++){
+		std::string cur = "<L" + intToString(i) + ">";
+		std::string next = i + 1 == levels ? "<P>" : "<L" + intToString(i + 1) + ">";
+		syn += cur + "->" + cur + "o" + intToString(i) + next + "|" + next + "\n";
+	}
+	syn += "<P>->id|num|(<L0>)\n";
+	return syn;
+}
+
+static ContextFreeGrammar LoadGrammar(const std::string& syn){
+	BenchFile file("qcompiler_bench_grammar.syn", syn);
+	std::unique_ptr<GrammarGenerator> gen = CreateGrammarGenerator("QGrammarGeneratorFactory");
+	gen->OpenFile(file.Name());
+	return gen->GrammarGenerate();
+}
+
+//sentence of 'tokens' tokens(about) which uses all the operators of LayeredGrammar(levels)
+static std::vector<std::string> LayeredSentence(int levels, size_t tokens){
+	std::vector<std::string> sen;
+	int op = 0;
+	sen.push_back("id");
+	while(sen.size() + 6 < tokens){
+		sen.push_back("o" + intToString(op++ % levels));
+		sen.push_back("(");
+		sen.push_back("num");
+		sen.push_back("o" + intToString(op++ % levels));
+		sen.push_back("id");
+		sen.push_back(")");
+	}
+	return sen;
+}
+
+//ID regular expression with 'ranges' alternative ranges, like ([a-c]|[d-f])([a-c]|[d-f])*
+static std::string IDRegex(int ranges){
+	std::string alter;
+	for(int i = 0; i < ranges; i++){
+		char beg = static_cast<char>('a' + (i * 3) % 24);
+		if(i >= 8) beg = static_cast<char>('A' + ((i - 8) * 3) % 24);
+		if(!alter.empty()) alter += "|";
+		alter += std::string("[") + beg + "-" + static_cast<char>(beg + 2) + "]";
+	}
+	return "(" + alter + ")(" + alter + ")*";
+}
+
+//reader_name is the name registered by FACTORY_REGISTRAR_DEFINE
+static void BM_FileReaderNextChar(benchmark::State& state, const char* reader_name){
+	BenchFile file("qcompiler_bench_text.txt", TextOfSize(static_cast<size_t>(state.range(0))));
+	size_t total = 0;
+	BenchCounters counters(state);
+	for(auto _ : state){
+		std::unique_ptr<FileReader> reader = CreateFileReader(reader_name);
+		reader->OpenFile(file.Name());
+		while(!reader->IsFileEnd()) benchmark::DoNotOptimize(reader->NextChar()), total++;
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(total));
+}
+BENCHMARK_CAPTURE(BM_FileReaderNextChar, QFileReader, "QFileReader")
+	->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_FileReaderNextChar, MMapFileReader, "MMapFileReader")
+	->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_FileReaderNextChar, AsyncFileReader, "AsyncFileReader")
+	->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+
+static void BM_FileReaderReadLine(benchmark::State& state, const char* reader_name){
+	std::string text = TextOfSize(static_cast<size_t>(state.range(0)));
+	BenchFile file("qcompiler_bench_text.txt", text);
+	BenchCounters counters(state);
+	for(auto _ : state){
+		std::unique_ptr<FileReader> reader = CreateFileReader(reader_name);
+		reader->OpenFile(file.Name());
+		while(!reader->IsFileEnd()) benchmark::DoNotOptimize(reader->ReadLine());
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK_CAPTURE(BM_FileReaderReadLine, QFileReader, "QFileReader")
+	->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_FileReaderReadLine, MMapFileReader, "MMapFileReader")
+	->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_FileReaderReadLine, AsyncFileReader, "AsyncFileReader")
+	->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+
+static void BM_BuildIDState(benchmark::State& state){
+	std::string regex = IDRegex(static_cast<int>(state.range(0)));
+	IDStateBuilderFactory* factory = IDStateBuilderFactoryRegistry::GetFactory("QIDStateBuilderFactory");
+	BenchCounters counters(state);
+	for(auto _ : state){
+		std::unique_ptr<IDStateBuilder> builder = factory->CreateIDStateBuilder();
+		builder->BuildIDState(regex);
+	}
+	state.counters["regex_length"] = static_cast<double>(regex.size());
+}
+BENCHMARK(BM_BuildIDState)->Arg(2)->Arg(4)->Arg(8)->Arg(12)->Unit(benchmark::kMillisecond);
+
+static void BM_GenerateDFA(benchmark::State& state){
+	std::string regex = IDRegex(static_cast<int>(state.range(0)));
+	IDStateBuilderFactory* factory = IDStateBuilderFactoryRegistry::GetFactory("QIDStateBuilderFactory");
+	size_t dfa_states = 0;
+	BenchCounters counters(state);
+	for(auto _ : state){
+		counters.PauseTiming();
+		std::unique_ptr<IDStateBuilder> builder = factory->CreateIDStateBuilder();
+		builder->BuildIDState(regex);
+		counters.ResumeTiming();
+		std::shared_ptr<DFA> dfa = builder->GenerateDFA();
+		dfa_states = dfa->table_.size();
+	}
+	state.counters["dfa_states"] = static_cast<double>(dfa_states);
+}
+BENCHMARK(BM_GenerateDFA)->Arg(2)->Arg(4)->Arg(8)->Arg(12)->Unit(benchmark::kMillisecond);
+
+static void BM_ElimLeftRecur(benchmark::State& state){
+	ContextFreeGrammar origin = LoadGrammar(LayeredGrammar(static_cast<int>(state.range(0))));
+	BenchCounters counters(state);
+	for(auto _ : state){
+		counters.PauseTiming();
+		ContextFreeGrammar gram = origin.CopyProductions();
+		counters.ResumeTiming();
+		gram.ElimLeftRecur();
+	}
+}
+BENCHMARK(BM_ElimLeftRecur)->RangeMultiplier(2)->Range(2, 32)->Unit(benchmark::kMillisecond);
+
+static void BM_GetFirstFollowTable(benchmark::State& state){
+	ContextFreeGrammar origin = LoadGrammar(LayeredGrammar(static_cast<int>(state.range(0))));
+	origin.ElimLeftRecur();
+	BenchCounters counters(state);
+	for(auto _ : state){
+		counters.PauseTiming();
+		ContextFreeGrammar gram = origin.CopyProductions();
+		counters.ResumeTiming();
+		gram.GetFirstTable();
+		gram.GetFollowTable();
+	}
+}
+BENCHMARK(BM_GetFirstFollowTable)->RangeMultiplier(2)->Range(2, 32)->Unit(benchmark::kMillisecond);
+
+static void BM_ConstructLL1Table(benchmark::State& state){
+	ContextFreeGrammar origin = LoadGrammar(LayeredGrammar(static_cast<int>(state.range(0))));
+	origin.ElimLeftRecur();
+	origin.GetFirstTable();
+	origin.GetFollowTable();
+	BenchCounters counters(state);
+	for(auto _ : state){
+		counters.PauseTiming();
+		std::unique_ptr<ContextFreeGrammar> gram(new ContextFreeGrammar(origin.CopyProductions()));
+		counters.ResumeTiming();
+		gram->GetSelectTable(); //SELECT sets are the input of LL(1) table, they are measured together
+		gram->ConstructLL1Table();
+	}
+}
+BENCHMARK(BM_ConstructLL1Table)->RangeMultiplier(2)->Range(2, 32)->Unit(benchmark::kMillisecond);
+
+static void BM_LL1Parsing(benchmark::State& state){
+	const int levels = 4;
+	std::unique_ptr<ContextFreeGrammar> gram(new ContextFreeGrammar(LoadGrammar(LayeredGrammar(levels))));
+	gram->ElimLeftRecur();
+	gram->GetFirstTable();
+	gram->GetFollowTable();
+	gram->GetSelectTable();
+	gram->ConstructLL1Table();
+
+	std::vector<std::string> sen = LayeredSentence(levels, static_cast<size_t>(state.range(0)));
+	BenchCounters counters(state);
+	for(auto _ : state){
+		std::unique_ptr<SyntaxTree> tree = gram->LL1Parsing(sen);
+		if(!tree->IsAccepted()) state.SkipWithError("sentence is not accepted");
+	}
+	state.counters["tokens_per_second"] = benchmark::Counter(static_cast<double>(sen.size()),
+						benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_LL1Parsing)->RangeMultiplier(8)->Range(64, 1 << 18)->Unit(benchmark::kMillisecond);
+
+static void BM_CompiledGrammarParse(benchmark::State& state){
+	const int levels = 4;
+	std::unique_ptr<ContextFreeGrammar> gram(new ContextFreeGrammar(LoadGrammar(LayeredGrammar(levels))));
+	gram->ElimLeftRecur();
+	gram->GetFirstTable();
+	gram->GetFollowTable();
+	gram->GetSelectTable();
+	gram->ConstructLL1Table();
+	CompiledGrammar compiled(*gram);
+
+	std::vector<std::string> sen = LayeredSentence(levels, static_cast<size_t>(state.range(0)));
+	BenchCounters counters(state);
+	for(auto _ : state){
+		std::unique_ptr<SyntaxTree> tree = compiled.Parse(sen);
+		if(!tree->IsAccepted()) state.SkipWithError("sentence is not accepted");
+	}
+	state.counters["tokens_per_second"] = benchmark::Counter(static_cast<double>(sen.size()),
+						benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_CompiledGrammarParse)->RangeMultiplier(8)->Range(64, 1 << 18)->Unit(benchmark::kMillisecond);
+
+/* Reading a file of one long sentence and parsing it: sequentially(all the tokens are collected before
+ * parsing) or pipelined(the scanner thread feeds the parser through a ring of 'ring' tokens).
+ */
+static void BM_ParseFile(benchmark::State& state, bool pipelined){
+	const int levels = 4;
+	std::unique_ptr<ContextFreeGrammar> gram(new ContextFreeGrammar(LoadGrammar(LayeredGrammar(levels))));
+	gram->ElimLeftRecur();
+	gram->GetFirstTable();
+	gram->GetFollowTable();
+	gram->GetSelectTable();
+	gram->ConstructLL1Table();
+	CompiledGrammar compiled(*gram);
+
+	std::vector<std::string> sen = LayeredSentence(levels, static_cast<size_t>(state.range(0)));
+	std::string text;
+	for(const auto& t : sen) text += t + (text.size() % 80 < 70 ? " " : "\n");
+	BenchFile file("qcompiler_bench_sentence.stn", text);
+
+	PipelinedParser parser(compiled, static_cast<size_t>(state.range(1)));
+	const CharClass blanks(" \t\r\n");
+	const CharClass word = blanks.Complement();
+	BenchCounters counters(state);
+	for(auto _ : state){
+		std::unique_ptr<SyntaxTree> tree;
+		if(pipelined) tree = parser.ParseFile(file.Name());
+		else {
+			std::unique_ptr<FileReader> reader = CreateFileReader("QFileReader");
+			reader->OpenFile(file.Name());
+			std::vector<std::string> tokens;
+			while(reader->SkipWhile(blanks), !reader->IsFileEnd()) tokens.push_back(reader->ScanWhile(word));
+			tree = compiled.Parse(tokens);
+		}
+		if(!tree->IsAccepted()) state.SkipWithError("sentence is not accepted");
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK_CAPTURE(BM_ParseFile, Sequential, false)->Args({ 1 << 18, 0 })->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ParseFile, Pipelined, true)->Args({ 1 << 18, 256 })->Args({ 1 << 18, 4096 })
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/* One keystroke in the middle of a long sentence, 'num' becomes 'id' and back: repaired by IncrementalParser,
+ * or the whole text lexed and parsed again. Inserting puts two tokens before it and takes them away again,
+ * so the repairs change the number of tokens covered by the nodes above it too.
+ */
+static void BM_EditSentence(benchmark::State& state, bool incremental, bool inserting){
+	const int levels = 4;
+	std::unique_ptr<ContextFreeGrammar> gram(new ContextFreeGrammar(LoadGrammar(LayeredGrammar(levels))));
+	gram->ElimLeftRecur();
+	gram->GetFirstTable();
+	gram->GetFollowTable();
+	gram->GetSelectTable();
+	gram->ConstructLL1Table();
+	CompiledGrammar compiled(*gram);
+
+	std::string text;
+	for(const auto& t : LayeredSentence(levels, static_cast<size_t>(state.range(0)))) text += t + " ";
+	IncrementalParser parser(compiled);
+	parser.Reset(text);
+	const size_t offset = text.find("num", text.size() / 2);
+	bool edited = false;
+	BenchCounters counters(state);
+	for(auto _ : state){
+		const std::string& word = edited ? "num" : "id";
+		if(inserting) parser.Edit(offset, edited ? 7 : 0, edited ? "" : "num o3 ");
+		else if(incremental) parser.Edit(offset, edited ? 2 : 3, word);
+		else {
+			text.replace(offset, edited ? 2 : 3, word);
+			parser.Reset(text);
+		}
+		edited = !edited;
+		if(!parser.Tree().IsAccepted()) state.SkipWithError("sentence is not accepted");
+	}
+	state.counters["parsed_tokens"] = static_cast<double>(parser.LastEdit().parsedTokens);
+	state.counters["relexed_bytes"] = static_cast<double>(parser.LastEdit().relexedBytes);
+}
+BENCHMARK_CAPTURE(BM_EditSentence, Complete, false, false)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)
+	->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_EditSentence, Incremental, true, false)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)
+	->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_EditSentence, Inserting, true, true)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)
+	->Unit(benchmark::kMicrosecond);
+
+/* Cold start of a language with lexical rules: analysing the rules and building the DFA of ID, then
+ * building the grammar(serial), or the two at the same time as Language::Load() does(parallel).
+ */
+static void BM_LoadLanguage(benchmark::State& state, bool parallel){
+	BenchFile syn("qcompiler_bench_language.syn", LayeredGrammar(static_cast<int>(state.range(0))));
+	BenchFile rge("qcompiler_bench_language.rge", "keywords = {if, else}\noperators = {+, -}\nID = {"
+		+ IDRegex(static_cast<int>(state.range(1))) + "}\n");
+	BenchCounters counters(state);
+	for(auto _ : state){
+		std::unique_ptr<Language> lang;
+		if(parallel) lang = Language::Load(LanguageSpec{ "bench", syn.Name(), rge.Name() });
+		else {
+			std::unique_ptr<RgeAnalyzier> analyzier = CreateRgeAnalyzier("QRgeAnalyzier");
+			analyzier->OpenFile(rge.Name());
+			analyzier->RgeAnalyse();
+			benchmark::DoNotOptimize(analyzier->GetIDStateBuilder()->GenerateDFA());
+			lang = Language::Load("bench", syn.Name());
+		}
+		if(!lang) state.SkipWithError("language cannot be loaded");
+	}
+}
+BENCHMARK_CAPTURE(BM_LoadLanguage, Serial, false)->Args({ 16, 12 })->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_LoadLanguage, Parallel, true)->Args({ 16, 12 })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char* argv[]){
+	std::vector<char*> args(1, argv[0]);
+	std::string json_format = "--benchmark_format=json";
+	bool has_format = false;
+	for(int i = 1; i < argc; i++){
+		if(std::string(argv[i]) == "--perf_counters") { perf_counters_enabled = true; continue; }
+		if(std::string(argv[i]).compare(0, 19, "--benchmark_format=") == 0) has_format = true;
+		args.push_back(argv[i]);
+	}
+	if(!has_format) args.push_back(&json_format[0]);
+
+	int new_argc = static_cast<int>(args.size());
+	benchmark::Initialize(&new_argc, args.data());
+	if(benchmark::ReportUnrecognizedArguments(new_argc, args.data())) return 1;
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct DFA;
+struct ContextFreeGrammar;
+struct SyntaxTree;
+
+/* Allocation accounting by pipeline stage, compiled in only when QCOMPILER_ENABLE_ALLOC_STATS is
+ * defined(cmake -DQCOMPILER_ENABLE_ALLOC_STATS=ON): the global operator new and delete are replaced by
+ * counting ones, and every allocation is charged to the innermost QC_STAGE of the allocating thread
+ * ("(none)" out of any stage). A block freed later, by any thread, is subtracted from the stage which
+ * allocated it, so the peak of a stage is the most memory it held at one time.
+ */
+struct AllocStageStats {
+	std::string name;
+	uint64_t allocations{ 0 };
+	uint64_t bytes{ 0 }; //allocated in total
+	uint64_t live{ 0 };  //allocated and not freed yet
+	uint64_t peak{ 0 };  //the highest 'live'
+};
+
+class AllocStats {
+public:
+	//the id of a stage by name, a stage is registered the first time its name is seen
+	static int StageId(const char* name);
+
+	static bool Enabled();
+	//the stages which have allocated anything
+	static std::vector<AllocStageStats> Stages();
+	static void Report(std::ostream& out);
+	//clears the counts and the peaks, the live bytes are kept
+	static void Reset();
+
+	static const int MAX_STAGES{ 64 };
+};
+
+//charges the allocations of this thread to 'stage' while it is alive, scopes can be nested
+class AllocStageScope {
+public:
+	explicit AllocStageScope(int stage);
+	~AllocStageScope();
+
+	AllocStageScope(const AllocStageScope&) = delete;
+	AllocStageScope& operator=(const AllocStageScope&) = delete;
+
+private:
+	int previous_;
+};
+
+#ifdef QCOMPILER_ENABLE_ALLOC_STATS
+#define QC_STAGE_CONCAT_(a, b) a##b
+#define QC_STAGE_CONCAT(a, b) QC_STAGE_CONCAT_(a, b)
+#define QC_STAGE(name) static const int QC_STAGE_CONCAT(qc_stage_id_, __LINE__) = AllocStats::StageId(name); \
+						AllocStageScope QC_STAGE_CONCAT(qc_stage_scope_, __LINE__)(QC_STAGE_CONCAT(qc_stage_id_, __LINE__))
+#else
+#define QC_STAGE(name) do{}while(0)
+#endif
+
+/* Estimated heap and inline bytes held by an object, by walking its containers. Node based containers
+ * are charged for their nodes, strings only for the heap buffer beyond the small string buffer. They are
+ * available whether the allocation accounting is compiled in or not.
+ */
+size_t ResidentBytes(const DFA& dfa);
+size_t ResidentBytes(const ContextFreeGrammar& grammar);
+size_t ResidentBytes(const SyntaxTree& tree);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "parse_cache.h"
+#include "task_scheduler.h"
+
+/* Diagnostic of a sentence in a file, line begins from 1. */
+struct FileDiagnostic {
+	size_t line;
+	ParseDiagnostic diagnostic;
+};
+
+struct BatchFileResult {
+	std::string file;
+	bool opened{ false };
+	size_t sentences{ 0 }; //every non-empty line is a sentence
+	size_t tokens{ 0 };
+	size_t accepted{ 0 };
+	std::vector<FileDiagnostic> diagnostics;
+};
+
+/* Runs read -> lex -> parse over many files on a TaskScheduler. Files are started from the largest one,
+ * and the sentences of a file are parsed in chunks which are separate tasks, so idle workers steal the
+ * chunks of a long file instead of waiting for it. The results have the same order as the input files.
+ * Lexing splits a line on blanks, the same as QSentenceReader.
+ */
+class BatchDriver {
+public:
+	BatchDriver(const CompiledGrammar& grammar, TaskScheduler& scheduler);
+
+	//the FileReader by its registered name, "QFileReader" by default, returns false if there is no such reader
+	bool SetFileReader(const std::string& name);
+	//the sentences are looked up in cache before being parsed, nullptr(the default) parses all of them
+	void SetParseCache(ParseCache* cache) { cache_ = cache; }
+
+	std::vector<BatchFileResult> Run(const std::vector<std::string>& files);
+
+	/* If path is a directory, all the regular files under it(recursively, sorted by path), otherwise path is
+	 * a list of files, one path on each line.
+	 */
+	static std::vector<std::string> ListInputs(const std::string& path);
+
+	static const size_t CHUNK_SENTENCES{ 64 };
+
+private:
+	struct FileWork;
+
+	void _processFile(FileWork* work);
+	void _parseChunk(FileWork* work, size_t beg, size_t end);
+	void _finishFile(FileWork* work);
+
+	const CompiledGrammar& grammar_;
+	TaskScheduler& scheduler_;
+	std::string readerName_{ "QFileReader" };
+	ParseCache* cache_{ nullptr };
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+
+#include "syntax_specific.h"
+
+struct ParserStatsSlot;
+
+/* CompiledGrammar is an immutable snapshot of a ContextFreeGrammar whose LL(1) table has been constructed.
+ * All the terms are interned as integer ids and the predictive parsing table is flattened into one dense
+ * array, so every lookup is a const index operation. Nothing is inserted on read, no error goes to the
+ * global error vector, thus one CompiledGrammar object can be shared by any number of parsing threads.
+ *
+ * Ids layout: terminals first, then Finish('$'), Epsilon('#'), and nonterminals at last.
+ */
+class CompiledGrammar {
+public:
+	using SymbolId = int;
+	using Sentence = std::vector<std::string>;
+	/* Pull based token source, returns false when there is no more token. */
+	using TokenSource = std::function<bool(SymbolId&)>;
+
+	struct Rule {
+		SymbolId lhs;
+		std::vector<SymbolId> rhs;
+	};
+
+	static const SymbolId InvalidSymbol{ -1 };
+	static const int NoRule{ -1 };
+
+	//grammar should have been called ConstructLL1Table() before
+	explicit CompiledGrammar(const ContextFreeGrammar& grammar);
+
+	SymbolId FindSymbol(const std::string& term) const;
+	const std::string& SymbolName(SymbolId id) const { return names_[id]; }
+	bool IsTerminal(SymbolId id) const { return id >= 0 && id < finish_; }
+	bool IsNonTerminal(SymbolId id) const { return id > epsilon_ && id < static_cast<SymbolId>(names_.size()); }
+
+	SymbolId StartSymbol() const { return start_; }
+	SymbolId FinishSymbol() const { return finish_; }
+	SymbolId EpsilonSymbol() const { return epsilon_; }
+	size_t SymbolCount() const { return names_.size(); }
+
+	//prefix of the nonterminals generated by grammar transformations, see SyntaxTree::Compact()
+	const std::string& InnerPrefix() const { return innerPrefix_; }
+	//unique among the grammars compiled by this process, so a reloaded grammar never has an old version
+	uint64_t Version() const { return version_; }
+
+	size_t RuleCount() const { return rules_.size(); }
+	const Rule& GetRule(int ind) const { return rules_[ind]; }
+
+	//returns NoRule if there is no entry in the table
+	int Predict(SymbolId nonTerm, SymbolId termi) const {
+		if (!IsNonTerminal(nonTerm) || termi < 0 || termi > finish_) return NoRule;
+		return table_[(nonTerm - epsilon_ - 1) * columns_ + termi];
+	}
+
+	//synchronization set for error recovery, that is Follow(nonTerm)
+	bool IsSync(SymbolId nonTerm, SymbolId termi) const {
+		if (!IsNonTerminal(nonTerm) || termi < 0 || termi > finish_) return false;
+		return sync_[(nonTerm - epsilon_ - 1) * columns_ + termi];
+	}
+
+	/* A sentence with errors is still parsed to the end, the result is a partial tree which is not
+	 * accepted, and all the errors are in SyntaxTree::diagnostics.
+	 */
+	std::unique_ptr<SyntaxTree> Parse(const Sentence& sentence) const;
+
+	/* Tokens are pulled one by one, the end of input is treated as Finish implicitly. So a scanner can
+	 * feed the parser incrementally and the whole token sequence is never materialized. FinishSymbol() in
+	 * the input is not the end but an unexpected token.
+	 */
+	std::unique_ptr<SyntaxTree> Parse(const TokenSource& next) const;
+
+	template<typename Iter>
+	std::unique_ptr<SyntaxTree> Parse(Iter first, Iter last) const {
+		return Parse([&first, &last](SymbolId& id) {
+			if(first == last) return false;
+			id = *first++;
+			return true;
+		});
+	}
+
+	/* Parse all the sentences with 'threads' workers, 0 means using all the hardware threads. The result
+	 * vector has the same order as sentences, one syntax tree for each sentence.
+	 * The workers are started for the call and joined before it returns, so it is meant for one large batch,
+	 * many small batches should share the workers of a TaskScheduler(see BatchDriver) instead.
+	 */
+	std::vector<std::unique_ptr<SyntaxTree>> ParseAll(const std::vector<Sentence>& sentences,
+						unsigned threads = 0) const;
+
+private:
+	SymbolId _intern(const std::string& term);
+	void _countExpansion(ParserStatsSlot& stats, int rule, SymbolId look) const; //see parser_stats.h
+
+	std::vector<std::string> names_;
+	std::unordered_map<std::string, SymbolId> ids_;
+	std::vector<Rule> rules_;
+	std::vector<int> table_; //nonterminals * columns_, columns_ = terminals + Finish
+	std::vector<bool> sync_; //the same layout as table_
+
+	std::string innerPrefix_;
+	uint64_t version_;
+
+	SymbolId finish_{ InvalidSymbol };
+	SymbolId epsilon_{ InvalidSymbol };
+	SymbolId start_{ InvalidSymbol };
+	size_t columns_{ 0 };
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include "rgeanalyzier.h"
 
@@ -8,19 +10,12 @@ struct ErrMsg {
 	int errNum;
 	const char* msg;
 
-	std::string fileName;
+	uint32_t fileId; //see InternFileName()
 	size_t lineNum;
 	size_t colNum;
 
-	ErrMsg(int n, const char* p, const std::string& f, size_t l, size_t c) :
-		errNum(n), msg(p), fileName(f), lineNum(l), colNum(c) {}
-	ErrMsg(ErrMsg&& e) {
-		errNum = e.errNum;
-		msg = e.msg;
-		lineNum = e.lineNum;
-		colNum = e.colNum;
-		fileName = move(e.fileName);
-	}
+	ErrMsg(int n, const char* p, uint32_t f, size_t l, size_t c) :
+		errNum(n), msg(p), fileId(f), lineNum(l), colNum(c) {}
 };
 
 enum Error_Number : int {
@@ -36,9 +31,48 @@ enum Error_Number : int {
 	MULTIPLE_DEFINITION,
 	ILLEGAL_ID_DEFINITION,
 
+//Errors for CompressedFileReader
+	UNSUPPORTED_COMPRESSION,
+	CORRUPTED_COMPRESSION,
+
+//Errors for AsyncFileReader
+	FILE_READ_FAILED,
+
 	TOTAL_ERROR //use for count
 };
 
+/* File names are interned once, so an error carries a small id instead of a copy of the name. The ids
+ * are stable for the whole process, a name seen before by the same thread is found without a lock.
+ */
+uint32_t InternFileName(const std::string& file);
+const std::string& FileNameOf(uint32_t id);
+
+/* Errors of one compilation(a file, a job of BatchDriver...). They are pushed without any lock, and
+ * MergeErrors() sorts them by file and position and appends them to GetAllErrors() when the compilation
+ * completes, so the order of GetAllErrors() does not depend on the order the threads run.
+ */
+struct ErrorSink {
+	std::vector<ErrMsg> errors;
+};
+
+//while the scope is alive, PushError() of this thread goes to 'sink', scopes can be nested
+class ErrorSinkScope {
+public:
+	explicit ErrorSinkScope(ErrorSink& sink);
+	~ErrorSinkScope();
+	ErrorSinkScope(const ErrorSinkScope&) = delete;
+	ErrorSinkScope& operator=(const ErrorSinkScope&) = delete;
+
+private:
+	ErrorSink* previous_;
+};
+
+void MergeErrors(ErrorSink& sink);
+
+/* The errors pushed out of any ErrorSinkScope go to a buffer of the thread, which is appended to
+ * GetAllErrors() in the order they were pushed when GetAllErrors() is called by the thread or the thread
+ * exits. GetAllErrors() should not be called while other threads are merging.
+ */
 std::vector<ErrMsg>& GetAllErrors();
 void PushError(ErrMsg&& emsg);
 bool PrintAllErrors();
@@ -47,7 +81,6 @@ extern std::array<const char*, TOTAL_ERROR> Error_Message;
 
 #define GENERATE_ERRMSG_PUSH(error, reader) do{ \
 										ErrMsg errmsg{error, Error_Message[error], \
-										reader->GetFilePath(), reader->LineNumber(), reader->ColNumber() }; \
+										InternFileName(reader->GetFilePath()), reader->LineNumber(), reader->ColNumber() }; \
 										PushError(std::move(errmsg)); \
 									}while(0)
-
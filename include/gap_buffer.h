@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+/* A sequence kept in one array with a gap at the place of the last change, so a change near the last one
+ * only moves the items between the two places instead of all the items after it. The items after the gap
+ * may be kept relative to the end of the sequence, then they stay right whatever is changed before them:
+ * MoveGap() lets the owner convert every item carried over the gap.
+ */
+template<typename T>
+class GapBuffer {
+public:
+	size_t size() const { return items_.size() - gapSize_; }
+	bool empty() const { return size() == 0; }
+	void clear() {
+		items_.clear();
+		gap_ = gapSize_ = 0;
+	}
+	//the items before the gap are [0, Gap()) of data()
+	size_t Gap() const { return gap_; }
+	const T* data() const { return items_.data(); }
+	//the item i of the sequence as it is kept
+	const T& operator[](size_t i) const { return items_[i < gap_ ? i : i + gapSize_]; }
+
+	template<typename Iter>
+	void Assign(Iter first, Iter last){
+		items_.assign(first, last);
+		gap_ = items_.size();
+		gapSize_ = 0;
+	}
+	//the whole sequence in one container, like std::string
+	template<typename Container>
+	Container Copy() const {
+		Container out(items_.begin(), items_.begin() + gap_);
+		out.insert(out.end(), items_.begin() + gap_ + gapSize_, items_.end());
+		return out;
+	}
+
+	void MoveGap(size_t pos){
+		if(pos < gap_) std::move_backward(items_.begin() + pos, items_.begin() + gap_, items_.begin() + gap_ + gapSize_);
+		else std::move(items_.begin() + gap_ + gapSize_, items_.begin() + pos + gapSize_, items_.begin() + gap_);
+		gap_ = pos;
+	}
+	//toFront(item) is called for every item carried from after the gap to before it, toBack(item) the other way
+	template<typename ToFront, typename ToBack>
+	void MoveGap(size_t pos, ToFront toFront, ToBack toBack){
+		for(; gap_ < pos; gap_++){
+			items_[gap_] = items_[gap_ + gapSize_];
+			toFront(items_[gap_]);
+		}
+		for(; gap_ > pos; gap_--){
+			items_[gap_ - 1 + gapSize_] = items_[gap_ - 1];
+			toBack(items_[gap_ - 1 + gapSize_]);
+		}
+	}
+	//removes n items after the gap
+	void Erase(size_t n) { gapSize_ += n; }
+	//inserts the items before the gap
+	template<typename Iter>
+	void Insert(Iter first, Iter last){
+		const size_t n = static_cast<size_t>(std::distance(first, last));
+		if(n > gapSize_) _grow(n);
+		std::copy(first, last, items_.begin() + gap_);
+		gap_ += n;
+		gapSize_ -= n;
+	}
+
+private:
+	//the gap grows with the array, so a run of insertions moves the items after it a few times only
+	void _grow(size_t n){
+		const size_t grow = std::max(n - gapSize_, items_.size() / 2 + 16);
+		items_.insert(items_.begin() + gap_ + gapSize_, grow, T());
+		gapSize_ += grow;
+	}
+
+	std::vector<T> items_;
+	size_t gap_{ 0 };
+	size_t gapSize_{ 0 };
+};
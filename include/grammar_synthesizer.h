@@ -0,0 +1,56 @@
+#pragma once
+
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "syntax_specific.h"
+
+/* Parameters of a synthetic grammar. The grammar is a chain of binary operator levels ending with an
+ * operand level:
+ *     <E>-><L0>
+ *     <Li>-><Li>oi_0<Li+1>|...|<Li+1>        (left recursive level)
+ *     <Li>-><Li+1>oi_0<Li>|...|<Li+1>        (right recursive level, the alternatives share a prefix)
+ *     <P>->id|num|(<L0>)|kj(<L0>)xj|kj(<L0>)yj|...
+ * So ElimLeftRecur() and LeftFactoring() are both needed before the LL(1) table can be constructed.
+ */
+struct SyntheticGrammarOptions{
+	int nonTerminals{ 8 };   //operator levels, <E> and <P> are not counted
+	int alternatives{ 2 };   //operators of each level
+	int leftRecursive{ 8 };  //how many levels(chosen randomly) are left recursive, the others are right recursive
+	int commonPrefixes{ 0 }; //pairs of operand alternatives sharing a prefix
+	unsigned seed{ 0 };
+};
+
+/* Returns the grammar in the format of .syn files. */
+std::string SynthesizeGrammar(const SyntheticGrammarOptions& options);
+
+/* Derives random sentences from the LL(1) table of a grammar, the same seed gives the same sentences.
+ * While the sentence is shorter than the expected length, productions are chosen randomly, after that
+ * (or deeper than the depth limit) the production that terminates fastest is chosen, so every sentence is in
+ * the language and at least about the expected length.
+ * The depth increases only at the nonterminals which are not the last term of their production, so the
+ * tails made by eliminating left recursion do not count, but every level of nested parentheses does.
+ */
+class SentenceDeriver{
+public:
+	using Production = ContextFreeGrammar::Production;
+
+	//the LL(1) table of grammar should have been constructed, grammar should live longer than the deriver
+	explicit SentenceDeriver(const ContextFreeGrammar& grammar, unsigned seed = 0);
+
+	std::vector<std::string> Derive(size_t length, int maxDepth);
+
+private:
+	void _computeMinimal();
+	void _computeRecursive();
+	bool _isRecursive(const Production* p) const;
+
+	const ContextFreeGrammar& grammar_;
+	std::map<std::string, std::vector<const Production*>> alternatives_;
+	std::map<std::string, const Production*> minimal_; //alternative with the lowest derivation height
+	std::set<std::string> recursive_; //nonterminals which can derive themselves
+	std::mt19937 rng_;
+};
@@ -44,11 +44,15 @@ enum class CONNECTION_TYPE {
 class IDStateBuilder {
 public:
 	virtual void BuildIDState(const std::string& str) = 0;
-	virtual void GenerateGraphvz(std::string filename) const {
-		std::cout << "Cannot generate Graphvz file" << std::endl;
+	//writes the state graph built by BuildIDState(), returns false if the file cannot be written
+	virtual bool GenerateGraphvz(std::string filename) const {
+		return false;
 	}
 	virtual std::shared_ptr<DFA> GenerateDFA(){
 		std::cout << "Cannot generate DFA" << std::endl;
 		return nullptr;
 	}
 };
+
+//writes the states and transfers of dfa, returns false if the file cannot be written
+bool GenerateDFAGraphvz(const DFA& dfa, const std::string& filename);
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "gap_buffer.h"
+
+/* Keeps the text, the tokens and the syntax tree of one document, and brings them up to date after every
+ * edit instead of lexing and parsing the whole text again, for editors which parse after each keystroke.
+ * Tokens are separated by blanks and newlines like Language::Lex(), comments are skipped if their delimiters
+ * are given.
+ *
+ * After Edit() the tokens and the tree are the same as Reset() with the new text would give. An edit costs
+ * about the bytes and tokens it changes, not the size of the document: the text is scanned again from a
+ * point shortly before the edit until the old tokens are met again, and the tree is parsed again from the
+ * smallest nonterminal covering the changed tokens, with the untouched subtrees reused. An edit which
+ * changes the tokens far away, like opening a comment, costs as far as it reaches, and a text with errors
+ * is parsed completely after each edit so that its diagnostics are the same as CompiledGrammar::Parse().
+ */
+class IncrementalParser {
+public:
+	using SymbolId = CompiledGrammar::SymbolId;
+
+	struct Token {
+		size_t offset; //in bytes
+		size_t length;
+		SymbolId id;   //InvalidSymbol if it is not a terminal of the grammar
+	};
+
+	//comments are skipped like blanks, they begin where a token could begin, an empty delimiter is not used
+	struct Comments {
+		std::string line; //to the end of the line
+		std::string blockBegin;
+		std::string blockEnd;
+	};
+
+	static const size_t CHECKPOINT_BYTES{ 256 };
+
+	//what the last Reset() or Edit() did
+	struct EditStats {
+		bool fullParse{ false };
+		size_t relexedBytes{ 0 }; //from the checkpoint resumed to where the scan met the old tokens again
+		size_t relexedTokens{ 0 };
+		size_t parsedTokens{ 0 }; //tokens matched by the parser, the ones in the reused subtrees are not
+		size_t reusedNodes{ 0 };  //subtrees spliced from the old tree
+		size_t createdNodes{ 0 };
+	};
+
+	explicit IncrementalParser(const CompiledGrammar& grammar, const Comments& comments = Comments());
+
+	IncrementalParser(const IncrementalParser&) = delete;
+	IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+	//lexes and parses text completely
+	void Reset(const std::string& text);
+	//replaces 'removed' bytes at offset with inserted, offset and removed are clamped to the text
+	void Edit(size_t offset, size_t removed, const std::string& inserted);
+
+	//a copy of the whole text
+	std::string Text() const { return text_.Copy<std::string>(); }
+	size_t TextSize() const { return text_.size(); }
+	size_t TokenCount() const { return tokens_.size(); }
+	//with its offset in the text, the tokens after the gap keep another one
+	Token TokenAt(size_t i) const;
+	//the tree must not be compacted, its widths are needed by the next edit
+	const SyntaxTree& Tree() const { return *tree_; }
+	const EditStats& LastEdit() const { return stats_; }
+	size_t CheckpointCount() const { return checkpoints_.size(); }
+
+private:
+	enum class ScanState : char { BLANK, LINE_COMMENT, BLOCK_COMMENT };
+
+	/* The scan resumes at offset in state, 'token' is the index of the next token. In a block comment no
+	 * end delimiter ends before offset, the search goes on from the bytes before it which are in the comment.
+	 */
+	struct Checkpoint {
+		size_t offset;
+		ScanState state;
+		size_t token;
+	};
+
+	/* Where a scan meets the old one again, it is looked for from the offset 'from' of the new text. The old
+	 * tokens and checkpoints it compares are after the gaps, so their offsets have moved with the text.
+	 */
+	struct Resync {
+		size_t from;        //npos if the scan goes to the end
+		size_t token;       //the old tokens and checkpoints before these have been passed
+		size_t checkpoint;
+		bool found;
+	};
+
+	//a node of the old tree: parent->children[index], beginning at the token 'start'
+	struct NodeRef {
+		SyntaxNode* parent;
+		size_t index;
+		size_t start;
+		SyntaxNode* Get() const { return parent->children[index].get(); }
+	};
+
+	class OldTreeCursor;
+
+	//scans [at.offset, size) of the text, which must be before its gap
+	size_t _scan(const Checkpoint& at, size_t size, Resync& sync, std::vector<Token>& tokens,
+						std::vector<Checkpoint>& checkpoints) const;
+	Checkpoint _checkpointAt(size_t i) const;
+	std::string _textAt(size_t offset, size_t length) const;
+	SymbolId _look(size_t pos) const {
+		return pos < tokens_.size() ? tokens_[pos].id : grammar_.FinishSymbol();
+	}
+
+	void _parseAll();
+	bool _repair(size_t first, size_t removed, size_t inserted);
+	bool _reparse(size_t depth, size_t first, size_t removed, size_t inserted);
+	size_t _end(size_t depth) const;
+	void _pushPath(const NodeRef& ref);
+	void _resizePath(size_t size);
+	bool _decisionsHold(size_t depth, SymbolId look) const;
+	bool _emptyDecisionsHold(const SyntaxNode* node, SymbolId look) const;
+	bool _tailDecisionsHold(const SyntaxNode* node, size_t width, SymbolId look) const;
+	bool _predicts(const SyntaxNode* node, SymbolId look) const;
+
+	const CompiledGrammar& grammar_;
+	Comments comments_;
+	GapBuffer<char> text_;
+	GapBuffer<Token> tokens_;           //by offset
+	GapBuffer<Checkpoint> checkpoints_; //by offset
+	std::unique_ptr<SyntaxTree> tree_;
+	std::vector<NodeRef> path_;   //from the start symbol down to the node repaired last
+	std::vector<size_t> widths_;  //the indexes in path_ of the nodes keeping their widths
+	EditStats stats_;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "idstatebuilder.h"
+#include "rgeanalyzier.h"
+
+class TaskScheduler;
+
+struct LanguageSpec {
+	std::string name;
+	std::string grammarFile; //.syn
+	std::string lexFile;     //.rge, optional
+};
+
+/* A language definition loaded once: the grammar is read, its left recursion and common prefixes are
+ * eliminated, and the LL(1) table is compiled. If there is a lexical rules file, it is analysed and the
+ * DFA of ID is built too. After Load() a Language is read only, so it can be shared by all the threads
+ * parsing this language.
+ * The lexer and the grammar do not depend on each other, so they are built as two tasks running at the
+ * same time, and loading takes about as long as the slower of the two.
+ */
+class Language {
+public:
+	/* Returns nullptr if a file cannot be opened, the lexical rules have errors(they are also merged into
+	 * GetAllErrors()) or the grammar is not LL(1), the reason is written to 'error' if it is not nullptr.
+	 * The lexer is built on another thread while the grammar is built on the calling one.
+	 */
+	static std::unique_ptr<Language> Load(const LanguageSpec& spec, std::string* error = nullptr);
+	static std::unique_ptr<Language> Load(const std::string& name, const std::string& synFile,
+						std::string* error = nullptr);
+	/* Loads all the languages with the stages of all of them submitted to scheduler, the result is in
+	 * the order of specs, with nullptr for a language which failed and the reason in (*errors)[i].
+	 */
+	static std::vector<std::unique_ptr<Language>> LoadAll(const std::vector<LanguageSpec>& specs,
+						TaskScheduler& scheduler, std::vector<std::string>* errors = nullptr);
+
+	const std::string& Name() const { return spec_.name; }
+	const std::string& GrammarFile() const { return spec_.grammarFile; }
+	const std::string& LexFile() const { return spec_.lexFile; }
+	const LanguageSpec& Spec() const { return spec_; }
+	const CompiledGrammar& Grammar() const { return *compiled_; }
+	//nullptr without the lexical rules file
+	const RGEDomainSpecific* Domain() const { return domain_; }
+	//nullptr without the lexical rules file or an ID definition
+	const DFA* IDDfa() const { return idDfa_.get(); }
+
+	//tokens of the buffer, split on blanks and newlines like QSentenceReader
+	std::vector<std::string> Lex(const std::string& buffer) const;
+
+private:
+	Language() {}
+
+	//the stages, each one touches only its own members so they can run at the same time
+	bool _buildGrammar(std::string& error);
+	bool _buildLexer(std::string& error);
+
+	LanguageSpec spec_;
+	//ll1table points to the productions, so the grammar is held by pointer and never copied
+	std::unique_ptr<ContextFreeGrammar> grammar_;
+	std::unique_ptr<CompiledGrammar> compiled_;
+	//the domain is owned by the analyzer
+	std::unique_ptr<RgeAnalyzier> lexer_;
+	const RGEDomainSpecific* domain_{ nullptr };
+	std::shared_ptr<DFA> idDfa_;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+
+/* LRU cache of syntax trees in front of CompiledGrammar::Parse(), for workloads which parse the same
+ * sentences again and again(generated code, repeated snippets). The key is a 64 bit hash of the token
+ * ids and the version of the grammar, a hit is confirmed by comparing the ids, so a hash collision is
+ * only a miss. The trees are shared and immutable, a hit costs the hash and one comparison instead of
+ * a parse. A reloaded grammar has a new version, the trees of the old one are never found again and
+ * age out of the cache.
+ *
+ * The cache is split into shards by the hash, each one with its own lock and an equal part of the memory
+ * budget. The memory of an entry is its token ids plus ResidentBytes() of its tree, a tree larger than
+ * the budget of a shard is not cached. The unknown tokens of a sentence are all InvalidSymbol, so the
+ * token of a diagnostic at an unknown token is empty, take it from the sentence by its position.
+ */
+class ParseCache {
+public:
+	using SymbolId = CompiledGrammar::SymbolId;
+	using Tokens = std::vector<SymbolId>;
+	using Tree = std::shared_ptr<const SyntaxTree>;
+
+	explicit ParseCache(size_t budgetBytes);
+
+	ParseCache(const ParseCache&) = delete;
+	ParseCache& operator=(const ParseCache&) = delete;
+
+	//the tree in the cache, or parses tokens with grammar and caches the tree
+	Tree Parse(const CompiledGrammar& grammar, const Tokens& tokens);
+	//nullptr if tokens of this grammar are not in the cache
+	Tree Find(const CompiledGrammar& grammar, const Tokens& tokens);
+	void Insert(const CompiledGrammar& grammar, const Tokens& tokens, Tree tree);
+
+	//the ids of the tokens of a sentence, InvalidSymbol for the unknown ones
+	static Tokens TokenIds(const CompiledGrammar& grammar, const CompiledGrammar::Sentence& sentence);
+	static uint64_t Hash(uint64_t version, const Tokens& tokens);
+
+	size_t Hits() const { return hits_.load(std::memory_order_relaxed); }
+	size_t Misses() const { return misses_.load(std::memory_order_relaxed); }
+	size_t Evictions() const { return evictions_.load(std::memory_order_relaxed); }
+	size_t Entries() const;
+	size_t Bytes() const;
+	size_t BudgetBytes() const { return budget_; }
+
+	//drops all the trees, the counters are kept
+	void Clear();
+
+	static const size_t SHARDS{ 16 };
+
+private:
+	struct Entry {
+		uint64_t hash;
+		uint64_t version;
+		Tokens tokens;
+		Tree tree;
+		size_t bytes;
+	};
+
+	struct Shard {
+		mutable std::mutex mutex;
+		std::list<Entry> lru; //the most recently used at the front
+		std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+		size_t bytes{ 0 };
+	};
+
+	//the high bits pick the shard, the low ones the bucket of the index
+	Shard& _shard(uint64_t hash) { return shards_[(hash >> 32) % SHARDS]; }
+	void _erase(Shard& shard, std::list<Entry>::iterator iter);
+
+	size_t budget_;
+	Shard shards_[SHARDS];
+	std::atomic<size_t> hits_{ 0 };
+	std::atomic<size_t> misses_{ 0 };
+	std::atomic<size_t> evictions_{ 0 };
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "language.h"
+#include "parse_cache.h"
+
+template<typename T> class RcuCell;
+
+/* One request to ParseService. On the wire a request is a header line followed by the buffer:
+ *     <op> <language> <deadline> <length>\n<length bytes>
+ * op is one of
+ *     lex     the tokens of the buffer
+ *     parse   only whether the buffer is accepted, and the errors if it is not
+ *     tree    the compact syntax tree(see SyntaxTree::Compact()) if the buffer is accepted
+ * deadline is the budget of the request in microseconds since it is received, 0 means no deadline.
+ */
+struct ParseRequest {
+	std::string op;
+	std::string language;
+	uint64_t deadline{ 0 };
+	std::string buffer;
+};
+
+/* Every request has a response in the same order, a header line followed by the payload:
+ *     <status> <length>\n<length bytes>
+ * status is one of
+ *     ok        lex: the tokens separated by blanks, parse: empty, tree: one node on each line
+ *               preorder, as "<depth> <term>"
+ *     rejected  one error on each line, as "<token position>\t<token>\t<expected term>"
+ *     timeout   the deadline passed before the request was done, empty payload
+ *     error     malformed request or unknown language, the payload is the reason
+ */
+struct ParseResponse {
+	std::string status;
+	std::string payload;
+};
+
+/* Serves lex/parse requests for the languages loaded once at startup, so a request does not pay for
+ * reading the grammar or constructing the LL(1) table. Clients connect to a Unix domain socket and may
+ * send many requests without waiting for the responses: all the requests which have arrived are
+ * handled as one batch and their responses are sent back with a single write. Each connection is
+ * served by its own thread, the languages are read only and shared.
+ *
+ * A language can be reloaded from its files while requests are being served: the new tables are built
+ * aside and published with an atomic pointer swap, the requests in flight keep the old tables until they
+ * finish(see RcuCell), so a request never waits for a reload.
+ *
+ * With EnableCache() the trees of parse/tree requests are kept in a ParseCache, so a buffer sent again
+ * is only lexed. The accepted trees are cached compacted, the ones cut off by the deadline are not cached.
+ */
+class ParseService {
+public:
+	ParseService();
+	~ParseService();
+
+	ParseService(const ParseService&) = delete;
+	ParseService& operator=(const ParseService&) = delete;
+
+	//returns false if a language with the same name has been added, languages cannot be added while serving
+	bool AddLanguage(std::unique_ptr<Language> lang);
+	//the result is valid until the EpochGuard of the caller is destroyed
+	const Language* FindLanguage(const std::string& name) const;
+
+	/* Loads the language from its grammar file again and publishes it, the old one is kept if the new
+	 * one cannot be loaded and the reason is written to 'error'.
+	 */
+	bool Reload(const std::string& name, std::string* error = nullptr);
+	//returns the languages failed to reload
+	size_t ReloadAll(std::string* errors = nullptr);
+
+	//cache the trees in budgetBytes, before serving
+	void EnableCache(size_t budgetBytes) { cache_.reset(new ParseCache(budgetBytes)); }
+	//nullptr if the cache is not enabled
+	const ParseCache* Cache() const { return cache_.get(); }
+
+	//only sets a flag, Serve() reloads all the languages in the background, so it can be called from a signal handler
+	void RequestReload() { reload_.store(true); }
+
+	ParseResponse Handle(const ParseRequest& request) const;
+
+	/* Decodes the complete requests at the beginning of data and appends their encoded responses to
+	 * 'responses'. Returns the bytes consumed, the rest is an incomplete request. 'malformed' is set if
+	 * a header cannot be decoded, the connection should be closed after the responses are sent.
+	 */
+	size_t HandleBuffer(const char* data, size_t size, std::string& responses, bool& malformed) const;
+
+	/* Listens on socketPath(an existing file there is removed) and blocks until Stop() is called.
+	 * Returns false if the socket cannot be created, or Unix domain socket is not supported.
+	 */
+	bool Serve(const std::string& socketPath);
+
+	//only sets a flag, so it can be called from a signal handler or another thread
+	void Stop() { stop_.store(true); }
+
+	static std::string EncodeRequest(const ParseRequest& request);
+	static std::string EncodeResponse(const ParseResponse& response);
+
+	//longest buffer of a request, a longer one is treated as malformed
+	static const size_t MAX_REQUEST_BYTES{ 64u << 20 };
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	ParseResponse _handle(const ParseRequest& request, Clock::time_point received) const;
+	void _serveConnection(int fd);
+
+	void _reloadLoop();
+
+	//the map is not changed while serving, only the cells are
+	std::map<std::string, std::unique_ptr<RcuCell<Language>>> languages_;
+	std::mutex reloadMutex_;
+	std::unique_ptr<ParseCache> cache_;
+	std::atomic<bool> stop_{ false };
+	std::atomic<bool> reload_{ false };
+};
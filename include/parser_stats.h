@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Counters of the parsing hot path(LL1Parsing and CompiledGrammar::Parse), compiled in only when
+ * QCOMPILER_ENABLE_PARSER_STATS is defined(cmake -DQCOMPILER_ENABLE_PARSER_STATS=ON), otherwise
+ * QC_PARSER_STATS expands to nothing. Every thread counts into its own slot, padded to keep the slots of
+ * different threads out of the same cache line, and ParserStats sums the slots when a report is asked for.
+ */
+struct ParserStatsSlot {
+	char padBegin[64];
+
+	struct Entry {
+		uint64_t count{ 0 };
+		std::string name;
+	};
+
+	//the slot of the calling thread
+	static ParserStatsSlot& Current();
+
+	/* A production is identified by the id of its grammar, which is never reused by this process(see
+	 * CompiledGrammar::Version()), and its key in the grammar. name() is called only the first time the
+	 * production(or the table cell, see Cell()) is seen, so the report does not depend on the grammar.
+	 */
+	template<typename NameFn>
+	void Expand(uint64_t grammar, uint64_t production, NameFn name) {
+		expansions++;
+		Entry& e = productions[Key{ grammar, production, 0 }];
+		if(e.count++ == 0) e.name = name();
+	}
+	template<typename NameFn>
+	void Cell(uint64_t grammar, uint64_t production, uint64_t lookahead, NameFn name) {
+		Entry& e = cells[Key{ grammar, production, lookahead }];
+		if(e.count++ == 0) e.name = name();
+	}
+	void StackDepth(size_t depth) { if(depth > maxStackDepth) maxStackDepth = depth; }
+
+	uint64_t parses{ 0 };
+	uint64_t tokens{ 0 };
+	uint64_t lookups{ 0 };     //LL(1) table lookups, including the failed ones
+	uint64_t expansions{ 0 };
+	uint64_t epsilonPops{ 0 };
+	uint64_t maxStackDepth{ 0 };
+	uint64_t nanoseconds{ 0 }; //time spent in the parsers
+
+	struct Key {
+		uint64_t grammar;
+		uint64_t production;
+		uint64_t lookahead; //0 for a production
+		bool operator==(const Key& k) const {
+			return grammar == k.grammar && production == k.production && lookahead == k.lookahead;
+		}
+	};
+	struct KeyHash {
+		size_t operator()(const Key& k) const {
+			std::hash<uint64_t> h;
+			return (h(k.grammar) * 31 + h(k.production)) * 31 + h(k.lookahead);
+		}
+	};
+
+	std::unordered_map<Key, Entry, KeyHash> productions; //named as "A -> x B"
+	std::unordered_map<Key, Entry, KeyHash> cells;       //named as "[A, x] A -> x B"
+
+	char padEnd[64];
+};
+
+/* Sums of all the slots, it should be read when no parser is running. */
+class ParserStats {
+public:
+	using Ranking = std::vector<std::pair<std::string, uint64_t>>;
+
+	static ParserStatsSlot Total();
+	//top n by count, ties are ordered by name
+	static Ranking HotProductions(size_t n);
+	static Ranking HotNonTerminals(size_t n);
+	static Ranking HotCells(size_t n);
+
+	static void Report(std::ostream& out, size_t n = 10);
+	static void Reset();
+
+	//"A -> x B", the name of a production in the report
+	static std::string ProductionName(const std::string& lhs, const std::vector<std::string>& rhs);
+};
+
+#ifdef QCOMPILER_ENABLE_PARSER_STATS
+#define QC_PARSER_STATS(...) __VA_ARGS__
+#else
+#define QC_PARSER_STATS(...)
+#endif
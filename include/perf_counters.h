@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Hardware performance counters(Linux perf_event_open) of the calling thread, counting user space only so
+ * they work with the default perf_event_paranoid. The events are opened as one group, so they are started,
+ * stopped and read together with a single syscall. An event the kernel refuses(no PMU in a virtual machine,
+ * a stricter perf_event_paranoid, not Linux) is just left out of the group and the others still count.
+ * When the kernel multiplexes the group, the values are scaled by enabled time / running time like perf
+ * stat does.
+ */
+enum PerfEvent {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_L1D_MISSES, //L1 data cache read misses
+	PERF_LLC_MISSES, //last level cache misses
+	PERF_BRANCH_MISSES,
+	PERF_EVENT_COUNT
+};
+
+struct PerfSample {
+	uint64_t value[PERF_EVENT_COUNT]{};
+	unsigned available{ 0 }; //bit i is set if value[i] was counted
+
+	bool Has(PerfEvent e) const { return (available >> e) & 1u; }
+	PerfSample operator-(const PerfSample& other) const;
+	PerfSample& operator+=(const PerfSample& other);
+};
+
+class PerfCounters {
+public:
+	//opens the counters for the calling thread, they only count that thread and are stopped at first
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	bool Available() const { return available_ != 0; }
+	bool Available(PerfEvent e) const { return (available_ >> e) & 1u; }
+
+	void Start();
+	void Stop();
+	void Reset();
+	//the counts since the last Reset(), of the periods between Start() and Stop()
+	PerfSample Read() const;
+
+	//the name used in the JSON output, like "cycles" or "llc_misses"
+	static const char* EventName(PerfEvent e);
+
+private:
+	int fds_[PERF_EVENT_COUNT];
+	int leader_{ -1 }; //the first event opened, the others are read through it
+	unsigned available_{ 0 };
+};
+
+/* Counters by pipeline stage, compiled in only when QCOMPILER_ENABLE_PERF_COUNTERS is
+ * defined(cmake -DQCOMPILER_ENABLE_PERF_COUNTERS=ON). Every thread opens its counters the first time it
+ * enters a QC_PERF_STAGE, and a stage is charged the difference between entering and leaving it, so the
+ * counts of nested stages are included in the outer ones, like the durations of trace events. Every thread
+ * adds up its stages in its own slot without a lock, PerfStats merges the slots by name, so it should be
+ * read when no stage is running.
+ */
+struct PerfStageStats {
+	std::string name;
+	uint64_t calls{ 0 };
+	uint64_t nanoseconds{ 0 };    //wall clock
+	uint64_t cpuNanoseconds{ 0 }; //cpu time of the thread
+	PerfSample counters;
+};
+
+class PerfStats {
+public:
+	static bool Enabled();
+	//sorted by name
+	static std::vector<PerfStageStats> Stages();
+	/* Writes the stages in the JSON format of the benchmark suite(Google Benchmark), one entry named
+	 * "stage/<name>" for every stage, the times and the counters are averaged over the calls.
+	 */
+	static void WriteJson(std::ostream& out);
+	//returns false if the file cannot be written or the counters are compiled out
+	static bool WriteJson(const std::string& file);
+	static void Reset();
+};
+
+class PerfStageScope {
+public:
+	//name should be a string literal, only the pointer is kept
+	explicit PerfStageScope(const char* name);
+	~PerfStageScope();
+
+	PerfStageScope(const PerfStageScope&) = delete;
+	PerfStageScope& operator=(const PerfStageScope&) = delete;
+
+private:
+	const char* name_;
+	PerfSample begin_;
+	uint64_t beginNanoseconds_;
+	uint64_t beginCpuNanoseconds_;
+};
+
+#ifdef QCOMPILER_ENABLE_PERF_COUNTERS
+#define QC_PERF_CONCAT_(a, b) a##b
+#define QC_PERF_CONCAT(a, b) QC_PERF_CONCAT_(a, b)
+#define QC_PERF_STAGE(name) PerfStageScope QC_PERF_CONCAT(qc_perf_stage_, __LINE__)(name)
+#else
+#define QC_PERF_STAGE(name) do{}while(0)
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+
+/* Runs the scanner and the parser at the same time: the scanner runs on its own thread and pushes
+ * token ids into a bounded lock free ring(SpscQueue), the parser pulls them from the ring on the calling
+ * thread. The scanner waits when the ring is full and the parser waits when it is empty, so the costs of
+ * scanning and parsing overlap and the memory of the buffered tokens is bounded by the ring capacity,
+ * however long the input is.
+ */
+class PipelinedParser {
+public:
+	explicit PipelinedParser(const CompiledGrammar& grammar, size_t ringCapacity = 4096);
+
+	//the FileReader by its registered name, "QFileReader" by default, returns false if there is no such reader
+	bool SetFileReader(const std::string& name);
+
+	/* The whole file is one sentence, tokens are separated by blanks and newlines. A token which is not
+	 * a terminal of the grammar is passed as InvalidSymbol, so its diagnostic has an empty token. Returns
+	 * nullptr if the file cannot be opened.
+	 */
+	std::unique_ptr<SyntaxTree> ParseFile(const std::string& file);
+
+	//scan is called on the scanner thread until it returns false
+	std::unique_ptr<SyntaxTree> Parse(const CompiledGrammar::TokenSource& scan);
+
+	//times the scanner waited on the full ring, summed over all the parses
+	size_t ScannerStalls() const { return scannerStalls_.load(std::memory_order_relaxed); }
+	//times the parser waited on the empty ring, summed over all the parses
+	size_t ParserStalls() const { return parserStalls_.load(std::memory_order_relaxed); }
+
+private:
+	const CompiledGrammar& grammar_;
+	size_t ringCapacity_;
+	std::string readerName_{ "QFileReader" };
+	std::atomic<size_t> scannerStalls_{ 0 };
+	std::atomic<size_t> parserStalls_{ 0 };
+};
@@ -4,12 +4,18 @@
 #include <string>
 #include "rgespecific.h"
 
+class IDStateBuilder;
+
 class RgeAnalyzier {
 public:
 	RgeAnalyzier(){}
 	virtual ~RgeAnalyzier(){}
 	virtual RGEDomainSpecific* RgeAnalyse() = 0;
 	virtual bool OpenFile(const std::string&) = 0;
+	//pick the FileReader by its registered name before OpenFile(), "QFileReader" is the default one
+	virtual bool SetFileReader(const std::string& name) = 0;
+	//the states built from the ID definition by RgeAnalyse(), nullptr if there is no ID definition
+	virtual IDStateBuilder* GetIDStateBuilder() { return nullptr; }
 };
 
 std::unique_ptr<RgeAnalyzier> CreateRgeAnalyzier(const std::string& analyzier_name);
@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <set>
 #include <map>
 #include <string>
@@ -9,6 +11,7 @@
 #include <iostream>
 #include <algorithm>
 #include <string>
+#include <functional>
 
 #include "sys_env.h"
 
@@ -29,6 +32,21 @@ struct SyntaxNode{
 	enum NodeType { TERMINAL, NONTERMINAL, FINISH };
 
 	SyntaxNode(const std::string& name = "", NodeType t = NONTERMINAL) : term(name), type(t){}
+	/* The trees of long sentences are hundreds of thousands of levels deep, the default destructor
+	 * would recurse once per level, so the descendants are freed from an explicit stack.
+	 */
+	~SyntaxNode(){
+		if(children.empty()) return;
+		std::vector<std::unique_ptr<SyntaxNode>> stack;
+		stack.swap(children);
+		while(!stack.empty()){
+			std::unique_ptr<SyntaxNode> node = std::move(stack.back());
+			stack.pop_back();
+			if(!node) continue; //moved away
+			for(auto& child : node->children) stack.push_back(std::move(child));
+			node->children.clear();
+		}
+	}
 
 	void addChild(const std::string& name, NodeType t){
 		children.emplace_back(std::make_unique<SyntaxNode>(name, t));
@@ -43,10 +61,21 @@ struct SyntaxNode{
 
 	const std::string term;
 	NodeType type; //terminal or nonterminal
+	size_t width{ 0 }; //tokens covered by the node, only kept by IncrementalParser
+
+	//the width of the last nonterminal child of a node kept by IncrementalParser, what the others leave of it
+	static const size_t REST_WIDTH{ static_cast<size_t>(-1) };
 
 	std::vector<std::unique_ptr<SyntaxNode>> children;
 };
 
+/* Diagnostic of one parsing error, position is the index of the token in the sentence. */
+struct ParseDiagnostic{
+	size_t position;
+	std::string token;
+	std::string expected;
+};
+
 struct SyntaxTree{
 
 	SyntaxTree() : head(new SyntaxNode(headName, SyntaxNode::NONTERMINAL)), counter(0){}
@@ -56,13 +85,24 @@ struct SyntaxTree{
 	void NotAccepted() { accepted = false; }
 	void Accepted() { accepted = true; }
 
-	void GenerateGraphvz(const std::string& filename = "parsing.gv");
+	//returns false if the file cannot be written
+	bool GenerateGraphvz(const std::string& filename = "parsing.gv");
 	void _generateGraphvz(std::ofstream& outfile);
 
+	/* Compact the parse tree to an abstract syntax tree: epsilon leaves and the Finish node are dropped,
+	 * single child chains are collapsed, and the tails generated by eliminating left recursion(nonterminals
+	 * begin with innerPrefix) are re-associated into left associative binary nodes whose term is the
+	 * operator. For example, the tree of "id + id * id" becomes +(id, *(id, id)).
+	 */
+	void Compact(const std::string& innerPrefix);
+	std::unique_ptr<SyntaxNode> _compactNode(std::unique_ptr<SyntaxNode> node, const std::string& innerPrefix);
+	static int _countNodes(const SyntaxNode* node);
+
 	const std::string headName{ "head" };
 	std::unique_ptr<SyntaxNode> head;
 	bool accepted{ false };
 	int counter{ 1 }; //at least has a head
+	std::vector<ParseDiagnostic> diagnostics;
 };
 
 struct FirstTable{
@@ -133,12 +173,10 @@ struct ContextFreeGrammar{
 	using ProductionTable = std::multimap<std::string, std::vector<std::string >>;
 	using FactorPrefix = std::set<std::vector<std::string>>;
 	using SelectTable = std::map<Production*, std::set<std::string>>;
+	/* Pull based token source, returns false when there is no more token. */
+	using TokenSource = std::function<bool(std::string&)>;
 
 	struct _InnerNameGenerator{
-		_InnerNameGenerator() {}
-		_InnerNameGenerator(const _InnerNameGenerator& g) {
-			counter = g.counter;
-		}
 		std::string GenerateName();
 
 		int counter{ 0 };
@@ -200,21 +238,38 @@ struct ContextFreeGrammar{
 
 	_InnerNameGenerator nameGenerator;
 
+	/* Unique among the grammars of this process, identifies the grammar for ParserStats. A moved grammar
+	 * takes a new id, and so do ConstructLL1Table and AddProduction/RemoveProduction, since the
+	 * addresses of the productions and terminals freed before may be reused.
+	 */
+	struct _GrammarId{
+		_GrammarId() : value(Next()) {}
+		_GrammarId(const _GrammarId&) : value(Next()) {}
+		_GrammarId& operator=(const _GrammarId&) { value = Next(); return *this; }
+		static uint64_t Next() {
+			static std::atomic<uint64_t> counter{ 0 };
+			return ++counter;
+		}
+
+		uint64_t value;
+	};
+	_GrammarId grammarId;
+
+	/* Term -> nonterminals whose productions use the term in the right part. Built on the first incremental
+	 * change and maintained by AddProduction/RemoveProduction, other transformations just clear it.
+	 */
+	std::map<std::string, std::set<std::string>> usedIn;
+
+	/* ll1table and select point to the productions, moving the productions keeps them where they are but
+	 * copying them does not, so a grammar is moved only.
+	 */
 	ContextFreeGrammar() {}
-	ContextFreeGrammar(const ContextFreeGrammar& grammar) {
-		startSymbol = grammar.startSymbol;
-		nonTerminals = grammar.nonTerminals;
-		terminals = grammar.terminals;
-		productions = grammar.productions;
-
-		first = grammar.first;
-		follow = grammar.follow;
-		nullable = grammar.nullable;
-
-		addStartSymbol = grammar.addStartSymbol;
-		nameGenerator = grammar.nameGenerator;
-		ll1table = grammar.ll1table;
-	}
+	ContextFreeGrammar(ContextFreeGrammar&&) = default;
+	ContextFreeGrammar& operator=(ContextFreeGrammar&&) = default;
+	ContextFreeGrammar& operator=(const ContextFreeGrammar&) = delete;
+
+	//a grammar with the same terms, productions and FIRST/FOLLOW sets, but without the tables built on them
+	ContextFreeGrammar CopyProductions() const;
 
 	void GetFirstTable();
 	void GetFollowTable();
@@ -240,7 +295,32 @@ struct ContextFreeGrammar{
 
 	bool ConstructLL1Table();
 
+	/* Change tracking API. After GetFirstTable, GetFollowTable, GetSelectTable and ConstructLL1Table have
+	 * been called, a production can be added or removed, then only the FIRST/FOLLOW sets in the dependency
+	 * cone of the change are recomputed, and only the affected SELECT sets and LL(1) rows are patched.
+	 * In the right part, terms that are neither known nonterminals nor the left part are seen as terminals.
+	 * Returns false if the production already exists(add) or cannot be found(remove). Otherwise 'ambiguous'
+	 * is set as ConstructLL1Table() returns, if one of the patched rows has conflicting productions.
+	 */
+	bool AddProduction(const std::string& left, const std::vector<std::string>& right, bool* ambiguous = nullptr);
+	bool RemoveProduction(const std::string& left, const std::vector<std::string>& right, bool* ambiguous = nullptr);
+
+	void _buildUsedIn();
+	std::set<std::string> _firstCone(const std::string& left) const;
+	std::set<std::string> _followCone(std::set<std::string> seeds, const std::set<std::string>& firstCone) const;
+	void _recomputeFirst(const std::set<std::string>& cone);
+	void _recomputeFollow(const std::set<std::string>& cone);
+	bool _patchSelectAndLL1Rows(const std::set<std::string>& rows);
+
 	std::unique_ptr<SyntaxTree> LL1Parsing(const std::vector<std::string>& sentence) const;
+	/* Tokens are pulled one by one, the end of input is treated as Finish implicitly, a token named Finish
+	 * is not the end but an unexpected token.
+	 * Errors would not abort the parsing, they are recovered in panic mode, the result is a partial
+	 * tree which is not accepted and all the errors are in SyntaxTree::diagnostics.
+	 */
+	std::unique_ptr<SyntaxTree> LL1Parsing(const TokenSource& next) const;
+	bool _recoverFromError(const SyntaxNode* node, std::string& term, size_t& pos, bool& input_end,
+						const TokenSource& next) const;
 
 	void PrintGrammar() const;
 
@@ -298,6 +378,8 @@ public:
 	virtual ~GrammarGenerator(){}
 
 	virtual bool OpenFile(const std::string& ) = 0;
+	//pick the FileReader by its registered name before OpenFile(), "QFileReader" is the default one
+	virtual bool SetFileReader(const std::string& name) = 0;
 
 	virtual ContextFreeGrammar GrammarGenerate() = 0;
 };
@@ -308,6 +390,8 @@ public:
 	virtual ~SentenceReader(){}
 
 	virtual std::vector<std::string> ReadFile(const std::string& ) = 0;
+	//pick the FileReader by its registered name before ReadFile(), "QFileReader" is the default one
+	virtual bool SetFileReader(const std::string& name) = 0;
 };
 
 std::unique_ptr<GrammarGenerator> CreateGrammarGenerator(const std::string& name);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Work stealing scheduler. Every worker has its own deque: tasks submitted by a worker go to the back
+ * of its deque and are taken by itself from the back(the newest one, whose data is still in the cache),
+ * an idle worker steals from the front of the other deques(the oldest one, which is usually the largest
+ * piece of work left). Tasks submitted by other threads are spread over the workers round robin.
+ */
+class TaskScheduler {
+public:
+	using Task = std::function<void()>;
+
+	//0 means using all the hardware threads
+	explicit TaskScheduler(unsigned threads = 0);
+	~TaskScheduler();
+
+	TaskScheduler(const TaskScheduler&) = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+	void Submit(Task task);
+
+	/* Blocks until all the submitted tasks(including the ones submitted by the tasks) are finished.
+	 * It should not be called in a task.
+	 */
+	void Wait();
+
+	unsigned ThreadCount() const { return static_cast<unsigned>(workers_.size()); }
+	size_t StolenCount() const { return stolen_.load(std::memory_order_relaxed); }
+
+private:
+	struct Worker {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+		std::thread thread;
+	};
+
+	void _run(unsigned index);
+	bool _popLocal(unsigned index, Task& task);
+	bool _steal(unsigned index, Task& task);
+	void _finishOne();
+
+	std::vector<std::unique_ptr<Worker>> workers_;
+
+	std::mutex mutex_;
+	std::condition_variable wakeup_; //workers wait for tasks
+	std::condition_variable idle_;   //Wait() waits for all the tasks
+	bool stop_{ false };
+
+	std::atomic<size_t> pending_{ 0 }; //submitted but not finished
+	std::atomic<size_t> queued_{ 0 };  //in the deques
+	std::atomic<unsigned> next_{ 0 };
+	std::atomic<size_t> stolen_{ 0 };
+};
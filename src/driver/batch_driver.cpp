@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include "batch_driver.h"
+#include "error.h"
+#include "utility/file_reader.h"
+#include "utility/utility_internal.h"
+#include "utility/trace.h"
+#include "alloc_stats.h"
+#include "perf_counters.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+const size_t BatchDriver::CHUNK_SENTENCES;
+
+struct BatchDriver::FileWork {
+	BatchFileResult* result;
+	std::vector<CompiledGrammar::Sentence> sentences;
+	std::vector<size_t> lines;
+	//one slot for each sentence, so the chunks never write the same memory
+	std::vector<char> accepted;
+	std::vector<std::vector<ParseDiagnostic>> diagnostics;
+	//the chunk which brings it to 0 folds the sentences into the result and frees them
+	std::atomic<size_t> remainingChunks{ 0 };
+	ErrorSink errors; //errors of reading the file, merged in the order of the input files
+};
+
+BatchDriver::BatchDriver(const CompiledGrammar& grammar, TaskScheduler& scheduler)
+	: grammar_(grammar), scheduler_(scheduler) {
+}
+
+bool BatchDriver::SetFileReader(const std::string& name){
+	if(!CreateFileReader(name)) return false;
+	readerName_ = name;
+	return true;
+}
+
+static size_t _fileSize(const std::string& file){
+	std::ifstream infile(file, std::ios::binary | std::ios::ate);
+	if(!infile) return 0;
+	return static_cast<size_t>(infile.tellg());
+}
+
+std::vector<BatchFileResult> BatchDriver::Run(const std::vector<std::string>& files){
+	std::vector<BatchFileResult> results(files.size());
+	std::vector<FileWork> works(files.size());
+
+	std::vector<size_t> sizes(files.size()), order(files.size());
+	for(size_t i = 0; i < files.size(); i++) sizes[i] = _fileSize(files[i]);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+	for(size_t i : order){
+		results[i].file = files[i];
+		works[i].result = &results[i];
+		FileWork* work = &works[i];
+		scheduler_.Submit([this, work]() { _processFile(work); });
+	}
+	scheduler_.Wait();
+
+	for(auto& work : works) MergeErrors(work.errors);
+	return results;
+}
+
+void BatchDriver::_processFile(FileWork* work){
+	QC_TRACE_SCOPE("BatchDriver::ReadFile");
+	QC_STAGE("BatchDriver::ReadFile");
+	QC_PERF_STAGE("BatchDriver::ReadFile");
+	ErrorSinkScope scope(work->errors);
+	std::unique_ptr<FileReader> reader = CreateFileReader(readerName_);
+	if(!reader || !reader->OpenFile(work->result->file)) return;
+	work->result->opened = true;
+
+	while(!reader->IsFileEnd()){
+		size_t line = reader->LineNumber();
+		CompiledGrammar::Sentence sentence;
+		SplitTokens(reader->ReadLine(), sentence);
+		if(sentence.empty()) continue;
+		work->sentences.push_back(std::move(sentence));
+		work->lines.push_back(line);
+	}
+
+	size_t n = work->sentences.size();
+	work->result->sentences = n;
+	work->accepted.assign(n, 0);
+	work->diagnostics.resize(n);
+	work->remainingChunks = std::max<size_t>((n + CHUNK_SENTENCES - 1) / CHUNK_SENTENCES, 1);
+
+	//the first chunk is parsed here, the others wait in the deque of this worker to be stolen
+	for(size_t beg = CHUNK_SENTENCES; beg < n; beg += CHUNK_SENTENCES){
+		size_t end = std::min(beg + CHUNK_SENTENCES, n);
+		scheduler_.Submit([this, work, beg, end]() { _parseChunk(work, beg, end); });
+	}
+	_parseChunk(work, 0, std::min(CHUNK_SENTENCES, n));
+}
+
+void BatchDriver::_parseChunk(FileWork* work, size_t beg, size_t end){
+	QC_TRACE_SCOPE("BatchDriver::ParseChunk");
+	QC_STAGE("BatchDriver::ParseChunk");
+	QC_PERF_STAGE("BatchDriver::ParseChunk");
+	for(size_t i = beg; i < end; i++){
+		if(!cache_){
+			std::unique_ptr<SyntaxTree> tree = grammar_.Parse(work->sentences[i]);
+			work->accepted[i] = tree->IsAccepted();
+			work->diagnostics[i] = std::move(tree->diagnostics);
+			continue;
+		}
+		//the cached tree is shared, its diagnostics are copied and the unknown tokens named again
+		const CompiledGrammar::Sentence& sentence = work->sentences[i];
+		ParseCache::Tree tree = cache_->Parse(grammar_, ParseCache::TokenIds(grammar_, sentence));
+		work->accepted[i] = tree->IsAccepted();
+		work->diagnostics[i] = tree->diagnostics;
+		for(auto& d : work->diagnostics[i])
+			if(d.position < sentence.size()) d.token = sentence[d.position];
+	}
+	if(--work->remainingChunks == 0) _finishFile(work);
+}
+
+void BatchDriver::_finishFile(FileWork* work){
+	BatchFileResult& result = *work->result;
+	for(size_t i = 0; i < work->sentences.size(); i++){
+		result.tokens += work->sentences[i].size();
+		if(work->accepted[i]) result.accepted++;
+		for(auto& d : work->diagnostics[i]) result.diagnostics.push_back(FileDiagnostic{ work->lines[i], std::move(d) });
+	}
+	std::vector<CompiledGrammar::Sentence>().swap(work->sentences);
+	std::vector<size_t>().swap(work->lines);
+	std::vector<char>().swap(work->accepted);
+	std::vector<std::vector<ParseDiagnostic>>().swap(work->diagnostics);
+}
+
+#ifdef _WIN32
+static void _listDirectory(const std::string& dir, std::vector<std::string>& files){
+	WIN32_FIND_DATAA data;
+	HANDLE handle = FindFirstFileA((dir + "\\*").c_str(), &data);
+	if(handle == INVALID_HANDLE_VALUE) return;
+	do {
+		std::string name = data.cFileName;
+		if(name == "." || name == "..") continue;
+		if(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) _listDirectory(dir + "\\" + name, files);
+		else files.push_back(dir + "\\" + name);
+	} while(FindNextFileA(handle, &data));
+	FindClose(handle);
+}
+
+static bool _isDirectory(const std::string& path){
+	DWORD attr = GetFileAttributesA(path.c_str());
+	return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+}
+#else
+static void _listDirectory(const std::string& dir, std::vector<std::string>& files){
+	DIR* d = opendir(dir.c_str());
+	if(d == nullptr) return;
+	while(dirent* entry = readdir(d)){
+		std::string name = entry->d_name;
+		if(name == "." || name == "..") continue;
+		std::string path = dir + "/" + name;
+		struct stat st;
+		if(stat(path.c_str(), &st) != 0) continue;
+		if(S_ISDIR(st.st_mode)) _listDirectory(path, files);
+		else if(S_ISREG(st.st_mode)) files.push_back(path);
+	}
+	closedir(d);
+}
+
+static bool _isDirectory(const std::string& path){
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+#endif
+
+std::vector<std::string> BatchDriver::ListInputs(const std::string& path){
+	std::vector<std::string> files;
+	if(_isDirectory(path)){
+		_listDirectory(path, files);
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	std::unique_ptr<FileReader> reader = CreateFileReader("QFileReader");
+	if(!reader->OpenFile(path)) return files;
+	while(!reader->IsFileEnd()){
+		std::string line = reader->ReadLine();
+		TrimmedPrefix(line);
+		TrimmedPostfix(line);
+		if(!line.empty()) files.push_back(line);
+	}
+	return files;
+}
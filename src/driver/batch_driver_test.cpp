@@ -0,0 +1,78 @@
+#include <fstream>
+#include "gtest/gtest.h"
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "batch_driver.h"
+#include "task_scheduler.h"
+#include "syntax/test_grammar.h"
+
+static std::unique_ptr<ContextFreeGrammar> ExpressionGrammar(){
+	return TestGrammar("batch_driver_test.syn", { "<E>-><E>+<T>|<T>", "<T>-><T>*<F>|<F>", "<F>->id|(<E>)" });
+}
+
+static void WriteFile(const std::string& name, const std::string& contents){
+	std::ofstream outfile(name, std::ios::binary);
+	outfile << contents;
+}
+
+TEST(BatchDriverTest, ResultsInOrder){
+	CompiledGrammar grammar(*ExpressionGrammar());
+
+	std::string large;
+	for(int i = 0; i < 1000; i++) large += i == 700 ? "id + + id\n" : "id * ( id + id )\n";
+	WriteFile("batch_driver_large.stn", large);
+	WriteFile("batch_driver_small.stn", "\nid\n\n( id\n");
+	WriteFile("batch_driver_list.txt", "batch_driver_small.stn\nbatch_driver_missing.stn\n  batch_driver_large.stn  \n");
+
+	std::vector<std::string> files = BatchDriver::ListInputs("batch_driver_list.txt");
+	ASSERT_EQ(files.size(), 3u);
+	EXPECT_EQ(files[2], "batch_driver_large.stn");
+
+	TaskScheduler scheduler(3);
+	BatchDriver driver(grammar, scheduler);
+	EXPECT_FALSE(driver.SetFileReader("NoSuchReader"));
+	EXPECT_TRUE(driver.SetFileReader("MMapFileReader"));
+	std::vector<BatchFileResult> results = driver.Run(files);
+	ASSERT_EQ(results.size(), 3u);
+
+	EXPECT_EQ(results[0].file, "batch_driver_small.stn");
+	EXPECT_TRUE(results[0].opened);
+	EXPECT_EQ(results[0].sentences, 2u);
+	EXPECT_EQ(results[0].accepted, 1u);
+	ASSERT_EQ(results[0].diagnostics.size(), 1u);
+	EXPECT_EQ(results[0].diagnostics[0].line, 4u);
+
+	EXPECT_FALSE(results[1].opened);
+
+	EXPECT_EQ(results[2].sentences, 1000u);
+	EXPECT_EQ(results[2].tokens, 999u * 7 + 4);
+	EXPECT_EQ(results[2].accepted, 999u);
+	ASSERT_EQ(results[2].diagnostics.size(), 1u);
+	EXPECT_EQ(results[2].diagnostics[0].line, 701u);
+	EXPECT_EQ(results[2].diagnostics[0].diagnostic.position, 2u);
+}
+
+TEST(BatchDriverTest, ParseCache){
+	CompiledGrammar grammar(*ExpressionGrammar());
+	std::string repeated;
+	for(int i = 0; i < 500; i++) repeated += i % 2 ? "id * ( id + id )\n" : "id + foo\n";
+	WriteFile("batch_driver_repeated.stn", repeated);
+
+	TaskScheduler scheduler(2);
+	ParseCache cache(1 << 20);
+	BatchDriver driver(grammar, scheduler);
+	driver.SetParseCache(&cache);
+	std::vector<BatchFileResult> results = driver.Run({ "batch_driver_repeated.stn" });
+	ASSERT_EQ(results.size(), 1u);
+	EXPECT_EQ(results[0].accepted, 250u);
+	ASSERT_EQ(results[0].diagnostics.size(), 250u);
+	EXPECT_EQ(results[0].diagnostics[0].diagnostic.token, "foo");
+	EXPECT_EQ(cache.Entries(), 2u);
+	EXPECT_EQ(cache.Hits() + cache.Misses(), 500u);
+	EXPECT_GE(cache.Hits(), 496u);
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
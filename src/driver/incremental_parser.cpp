@@ -0,0 +1,579 @@
+#include <algorithm>
+#include "incremental_parser.h"
+#include "utility/trace.h"
+#include "alloc_stats.h"
+#include "perf_counters.h"
+
+//the same separators as Language::Lex
+static bool _isSeparator(char c){
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+//the first index in [0, n) for which pred is false, it is true for the ones before it only
+template<typename Pred>
+static size_t _partitionPoint(size_t n, Pred pred){
+	size_t low = 0, high = n;
+	while(low < high){
+		size_t mid = low + (high - low) / 2;
+		if(pred(mid)) low = mid + 1;
+		else high = mid;
+	}
+	return low;
+}
+
+/* Every node of the tree knows how many tokens it covers(SyntaxNode::width), so the span of a node is found
+ * by walking down from the root. The last nonterminal child of a node covers what its siblings leave of its
+ * parent and does not keep its width(SyntaxNode::REST_WIDTH): a repair then changes the widths of the
+ * ancestors which are not the last child of their parent only, as many as the brackets around the change,
+ * and not as many as the long right recursive tails left by eliminating left recursion.
+ */
+
+//the width of node->children[index], node covers 'width' tokens
+static size_t _childWidth(const SyntaxNode* node, size_t width, size_t index){
+	if(node->children[index]->width != SyntaxNode::REST_WIDTH) return node->children[index]->width;
+	for(size_t i = 0; i + 1 < node->children.size(); i++) width -= node->children[i]->width;
+	return width;
+}
+
+//the widths of the children have been measured, the last nonterminal one gives its width up to node
+static void _leaveRest(SyntaxNode* node){
+	if(!node->children.empty() && node->children.back()->type == SyntaxNode::NONTERMINAL)
+		node->children.back()->width = SyntaxNode::REST_WIDTH;
+}
+
+/* Walks the old subtree of the repaired node in preorder, only forward, so all the lookups of one repair
+ * cost no more than one walk down to the changed tokens and over the subtrees skipped on the way.
+ */
+class IncrementalParser::OldTreeCursor {
+public:
+	OldTreeCursor(const NodeRef& root, size_t width) : path_{ Entry{ root, root.start + width } } {}
+
+	//the old nonterminal 'term' beginning at the token q and its width, q must not decrease between the calls
+	bool Seek(size_t q, const std::string& term, NodeRef& found, size_t& width){
+		while(!path_.empty()){
+			const Entry cur = path_.back();
+			SyntaxNode* node = cur.ref.Get();
+			if(cur.ref.start > q) return false;
+			if(cur.ref.start == q && node->type == SyntaxNode::NONTERMINAL && node->term == term){
+				found = cur.ref;
+				width = cur.end - cur.ref.start;
+				return true;
+			}
+			if(node->children.empty() || (cur.ref.start < q && cur.end <= q)) Skip();
+			else path_.push_back(_child(node, 0, cur.ref.start, cur.end));
+		}
+		return false;
+	}
+
+	//moves over the current node and its subtree
+	void Skip(){
+		while(!path_.empty()){
+			if(path_.size() == 1) { path_.clear(); return; } //the root has no siblings here
+			Entry& cur = path_.back();
+			if(cur.ref.index + 1 < cur.ref.parent->children.size()){
+				cur = _child(cur.ref.parent, cur.ref.index + 1, cur.end, path_[path_.size() - 2].end);
+				return;
+			}
+			path_.pop_back();
+		}
+	}
+
+private:
+	struct Entry {
+		NodeRef ref;
+		size_t end; //the token after the node
+	};
+
+	//parent->children[index] beginning at the token start, parent ends at the token end
+	static Entry _child(SyntaxNode* parent, size_t index, size_t start, size_t end){
+		const size_t width = parent->children[index]->width;
+		return Entry{ NodeRef{ parent, index, start }, width == SyntaxNode::REST_WIDTH ? end : start + width };
+	}
+
+	std::vector<Entry> path_; //the current node at the back
+};
+
+//nodes of a subtree, the children moved out of it are not counted
+static size_t _countNodes(const SyntaxNode* root){
+	size_t n = 0;
+	std::vector<const SyntaxNode*> st{ root };
+	while(!st.empty()){
+		const SyntaxNode* node = st.back();
+		st.pop_back();
+		n++;
+		for(const auto& child : node->children) if(child) st.push_back(child.get());
+	}
+	return n;
+}
+
+const size_t IncrementalParser::CHECKPOINT_BYTES;
+
+IncrementalParser::IncrementalParser(const CompiledGrammar& grammar, const Comments& comments)
+	: grammar_(grammar), comments_(comments), tree_(new SyntaxTree) {
+	//a block comment needs both of its delimiters
+	if(comments_.blockBegin.empty() || comments_.blockEnd.empty()){
+		comments_.blockBegin.clear();
+		comments_.blockEnd.clear();
+	}
+}
+
+/* The text, the tokens and the checkpoints are gap buffers with the gap at the last edit, and the tokens
+ * and the checkpoints after the gap keep their offsets from the end of the text(and the checkpoints their
+ * tokens from the last token), so an edit moves what lies between it and the last edit, not everything
+ * after it.
+ */
+IncrementalParser::Token IncrementalParser::TokenAt(size_t i) const {
+	Token token = tokens_[i];
+	if(i >= tokens_.Gap()) token.offset = text_.size() - token.offset;
+	return token;
+}
+
+IncrementalParser::Checkpoint IncrementalParser::_checkpointAt(size_t i) const {
+	Checkpoint checkpoint = checkpoints_[i];
+	if(i >= checkpoints_.Gap()){
+		checkpoint.offset = text_.size() - checkpoint.offset;
+		checkpoint.token = tokens_.size() - checkpoint.token;
+	}
+	return checkpoint;
+}
+
+std::string IncrementalParser::_textAt(size_t offset, size_t length) const {
+	std::string str;
+	for(size_t i = offset; i < offset + length; i++) str += text_[i];
+	return str;
+}
+
+/* Scans the text from the checkpoint 'at', appending the tokens and a checkpoint about every CHECKPOINT_BYTES,
+ * and returns the offset where it has stopped: size, or the first offset after sync.from where it is in the
+ * same state as the old scan was at the same moved offset.
+ * After a token the separator ending it is taken too, and a comment is searched in pieces no longer than
+ * the distance to the next checkpoint, so the state recorded at an offset depends only on the bytes before it.
+ */
+size_t IncrementalParser::_scan(const Checkpoint& at, size_t size, Resync& sync, std::vector<Token>& tokens,
+					std::vector<Checkpoint>& checkpoints) const {
+	const std::string& end = comments_.blockEnd;
+	const char* text = text_.data();
+	const size_t npos = std::string::npos;
+	size_t pos = at.offset, last = at.offset;
+	ScanState state = at.state;
+	//where the end of the block comment may begin, a checkpoint in the comment is never before it
+	size_t content = state == ScanState::BLOCK_COMMENT ? pos + 1 - end.size() : pos;
+	sync.found = false;
+
+	auto startsWith = [text, size](size_t p, const std::string& delimiter) {
+		return !delimiter.empty() && p + delimiter.size() <= size && std::equal(delimiter.begin(), delimiter.end(), text + p);
+	};
+	//the next old checkpoint after the edit which is not before pos
+	auto oldCheckpoint = [&]() -> size_t {
+		if(sync.from == npos) return npos;
+		const size_t target = std::max(pos, sync.from);
+		while(sync.checkpoint < checkpoints_.size() && _checkpointAt(sync.checkpoint).offset < target) sync.checkpoint++;
+		return sync.checkpoint < checkpoints_.size() ? _checkpointAt(sync.checkpoint).offset : npos;
+	};
+
+	while(pos < size){
+		const bool resumable = state != ScanState::BLOCK_COMMENT || pos + 1 >= content + end.size();
+		const size_t behind = state == ScanState::BLOCK_COMMENT ? end.size() - 1 : 0;
+		const size_t next = oldCheckpoint();
+
+		//the old scan was in the same state here, from now on both read the same bytes
+		if(sync.from != npos && pos >= sync.from + behind){
+			if(state == ScanState::BLANK && !_isSeparator(text[pos])){
+				while(sync.token < tokens_.size() && TokenAt(sync.token).offset < pos) sync.token++;
+				if(sync.token < tokens_.size() && TokenAt(sync.token).offset == pos) sync.found = true;
+			}
+			else if(state != ScanState::BLANK && resumable && next == pos && _checkpointAt(sync.checkpoint).state == state){
+				sync.token = _checkpointAt(sync.checkpoint).token;
+				sync.found = true;
+			}
+			if(sync.found) return pos;
+		}
+		if(pos >= last + CHECKPOINT_BYTES && resumable){
+			checkpoints.push_back(Checkpoint{ pos, state, at.token + tokens.size() });
+			last = pos;
+		}
+
+		if(state == ScanState::BLANK){
+			if(_isSeparator(text[pos])) pos++;
+			else if(startsWith(pos, comments_.line)){
+				pos += comments_.line.size();
+				state = ScanState::LINE_COMMENT;
+			}
+			else if(startsWith(pos, comments_.blockBegin)){
+				pos += comments_.blockBegin.size();
+				content = pos;
+				state = ScanState::BLOCK_COMMENT;
+			}
+			else {
+				size_t stop = static_cast<size_t>(std::find_if(text + pos, text + size, _isSeparator) - text);
+				tokens.push_back(Token{ pos, stop - pos, grammar_.FindSymbol(std::string(text + pos, stop - pos)) });
+				pos = stop < size ? stop + 1 : size;
+			}
+			continue;
+		}
+
+		//a piece of the comment, up to the next checkpoint of either scan
+		size_t limit = size;
+		auto bound = [&limit, pos](size_t x) { if(x > pos) limit = std::min(limit, x); };
+		bound(std::max(last + CHECKPOINT_BYTES, content + behind));
+		bound(next);
+		if(state == ScanState::LINE_COMMENT){
+			size_t newline = static_cast<size_t>(std::find(text + pos, text + limit, '\n') - text);
+			pos = newline < limit ? newline + 1 : limit;
+			if(newline < limit) state = ScanState::BLANK;
+		}
+		else {
+			//no end delimiter ends before pos, the ones ending after it may begin before it
+			size_t from = resumable ? pos - behind : content;
+			const char* found = std::search(text + from, text + limit, end.begin(), end.end());
+			pos = found == text + limit ? limit : static_cast<size_t>(found - text) + end.size();
+			if(found != text + limit) state = ScanState::BLANK;
+		}
+	}
+	return size;
+}
+
+void IncrementalParser::Reset(const std::string& text){
+	text_.Assign(text.begin(), text.end());
+	tokens_.clear();
+	checkpoints_.clear();
+	std::vector<Token> tokens;
+	std::vector<Checkpoint> checkpoints;
+	Resync sync{ std::string::npos, 0, 0, false };
+	_scan(Checkpoint{ 0, ScanState::BLANK, 0 }, text_.size(), sync, tokens, checkpoints);
+	tokens_.Assign(tokens.begin(), tokens.end());
+	checkpoints_.Assign(checkpoints.begin(), checkpoints.end());
+	stats_ = EditStats();
+	stats_.relexedBytes = text_.size();
+	stats_.relexedTokens = tokens_.size();
+	_parseAll();
+}
+
+void IncrementalParser::_parseAll(){
+	size_t ind = 0;
+	tree_ = grammar_.Parse([this, &ind](SymbolId& id) {
+		if(ind >= tokens_.size()) return false;
+		id = tokens_[ind++].id;
+		return true;
+	});
+	path_.clear();
+	widths_.clear();
+	stats_.fullParse = true;
+	stats_.parsedTokens = tokens_.size();
+	stats_.reusedNodes = 0;
+	stats_.createdNodes = static_cast<size_t>(tree_->counter);
+
+	//unknown terms have no names in the grammar, take them back from the text
+	for(auto& d : tree_->diagnostics)
+		if(d.position < tokens_.size()) d.token = _textAt(TokenAt(d.position).offset, TokenAt(d.position).length);
+	if(!tree_->IsAccepted()) return;
+
+	//the parents are before their children, so walked backwards every child is measured before its parent
+	std::vector<SyntaxNode*> nodes{ tree_->GetHead() };
+	for(size_t i = 0; i < nodes.size(); i++)
+		for(const auto& child : nodes[i]->children) nodes.push_back(child.get());
+	for(auto iter = nodes.rbegin(); iter != nodes.rend(); ++iter){
+		SyntaxNode* node = *iter;
+		node->width = node->type == SyntaxNode::TERMINAL ? 1 : 0;
+		for(const auto& child : node->children) node->width += child->width;
+	}
+	for(SyntaxNode* node : nodes) _leaveRest(node);
+}
+
+/* The scanner is a small automaton: between tokens, in a line comment or in a block comment. Every
+ * CHECKPOINT_BYTES it records its state, and every token begins between tokens, so an edit is scanned again
+ * from the last checkpoint or token before it. The scan stops as soon as it is in the same state at the
+ * same(moved) offset as the old one after the edit, that is it begins a token where an old token began, or
+ * it passes an old checkpoint of a comment in the same state, since from there both read the same bytes.
+ * A keystroke costs a few hundred bytes of scanning even inside a comment as long as the whole file.
+ *
+ * Only an accepted tree is repaired, a text with errors is parsed completely.
+ */
+void IncrementalParser::Edit(size_t offset, size_t removed, const std::string& inserted){
+	QC_TRACE_SCOPE("IncrementalParser::Edit");
+	QC_STAGE("IncrementalParser::Edit");
+	QC_PERF_STAGE("IncrementalParser::Edit");
+	offset = std::min(offset, text_.size());
+	removed = std::min(removed, text_.size() - offset);
+	stats_ = EditStats();
+
+	//the scan resumes from the last checkpoint or token beginning at or before the edit, the later of the two
+	const size_t c = _partitionPoint(checkpoints_.size(), [this, offset](size_t i) { return _checkpointAt(i).offset <= offset; });
+	const size_t t = _partitionPoint(tokens_.size(), [this, offset](size_t i) { return TokenAt(i).offset <= offset; });
+	Checkpoint at{ 0, ScanState::BLANK, 0 };
+	if(c != 0) at = _checkpointAt(c - 1);
+	if(t != 0 && TokenAt(t - 1).offset > at.offset) at = Checkpoint{ TokenAt(t - 1).offset, ScanState::BLANK, t - 1 };
+	const size_t a = at.token;
+
+	//the old tokens and checkpoints from the scan on are put after the gaps, there they move with the text
+	const size_t size = text_.size(), count = tokens_.size();
+	auto flip_token = [size](Token& k) { k.offset = size - k.offset; };
+	auto flip_checkpoint = [size, count](Checkpoint& k) {
+		k.offset = size - k.offset;
+		k.token = count - k.token;
+	};
+	tokens_.MoveGap(a, flip_token, flip_token);
+	checkpoints_.MoveGap(c, flip_checkpoint, flip_checkpoint);
+	text_.MoveGap(offset);
+	text_.Erase(removed);
+	text_.Insert(inserted.begin(), inserted.end());
+
+	//the scan reads the text before its gap, which is moved further until the scan meets the old one
+	std::vector<Token> relexed;
+	std::vector<Checkpoint> recorded;
+	Resync sync{ offset + inserted.size(), a, c, false };
+	size_t stop = 0;
+	for(size_t window = 4 * CHECKPOINT_BYTES;; window *= 4){
+		const size_t bound = std::min(text_.size(), text_.Gap() + window);
+		text_.MoveGap(bound);
+		relexed.clear();
+		recorded.clear();
+		sync = Resync{ offset + inserted.size(), a, c, false };
+		stop = _scan(at, bound, sync, relexed, recorded);
+		if(sync.found || bound == text_.size()) break;
+	}
+	stats_.relexedBytes = stop - at.offset;
+	stats_.relexedTokens = relexed.size();
+	//the old tokens and checkpoints from here on hold again
+	const size_t b = sync.found ? sync.token : tokens_.size();
+	const size_t d = !sync.found ? checkpoints_.size() : c + _partitionPoint(checkpoints_.size() - c,
+		[this, c, stop](size_t i) { return _checkpointAt(c + i).offset < stop; });
+
+	//the unchanged tokens at both ends of the window are not damage to the tree
+	size_t same_front = 0, same_back = 0;
+	while(same_front < relexed.size() && a + same_front < b && relexed[same_front].id == tokens_[a + same_front].id)
+		same_front++;
+	while(same_back < relexed.size() - same_front && b - same_back > a + same_front
+		&& relexed[relexed.size() - 1 - same_back].id == tokens_[b - 1 - same_back].id)
+		same_back++;
+
+	tokens_.Erase(b - a);
+	tokens_.Insert(relexed.begin(), relexed.end());
+	checkpoints_.Erase(d - c);
+	checkpoints_.Insert(recorded.begin(), recorded.end());
+
+	const size_t damaged = b - a - same_front - same_back, replacing = relexed.size() - same_front - same_back;
+	if(!tree_->IsAccepted() || !_repair(a + same_front, damaged, replacing)) _parseAll();
+}
+
+/* The old tokens [first, first + removed) are replaced by the new tokens [first, first + inserted), the
+ * candidates are the nonterminals covering the old ones, from the smallest. If the repaired node does not
+ * end where its old tokens end, its parent is tried, and at last the whole text is parsed again.
+ * The path down to the repaired node is kept, so the next edit nearby does not walk down from the root.
+ */
+bool IncrementalParser::_repair(size_t first, size_t removed, size_t inserted){
+	if(removed == 0 && inserted == 0) return true;
+
+	//an edit near the last one goes on from the nodes covering both, instead of walking down from the root
+	const size_t last = first + removed;
+	while(path_.size() > 1 && (path_.back().start > first || _end(path_.size() - 1) < last)) _resizePath(path_.size() - 1);
+	if(path_.empty()) _pushPath(NodeRef{ tree_->GetHead(), 0, 0 });
+	size_t end = _end(path_.size() - 1);
+	for(;;){
+		SyntaxNode* node = path_.back().Get();
+		size_t start = path_.back().start;
+		bool found = false;
+		for(size_t i = 0; i < node->children.size() && !found; i++){
+			const SyntaxNode* child = node->children[i].get();
+			const size_t child_end = child->width == SyntaxNode::REST_WIDTH ? end : start + child->width;
+			//the leftmost one if several cover an insertion, it has been decided before the changed tokens
+			if(child->type == SyntaxNode::NONTERMINAL && !child->children.empty() && start <= first && child_end >= last){
+				_pushPath(NodeRef{ node, i, start });
+				end = child_end;
+				found = true;
+			}
+			start = child_end;
+		}
+		if(!found) break;
+	}
+
+	for(size_t depth = path_.size(); depth-- > 0;){
+		if(!_reparse(depth, first, removed, inserted)) continue;
+		_resizePath(depth + 1); //the nodes below have been replaced
+		return true;
+	}
+	return false;
+}
+
+//the token after the node path_[depth], a node without its width ends where its parent ends
+size_t IncrementalParser::_end(size_t depth) const {
+	auto iter = std::upper_bound(widths_.begin(), widths_.end(), depth);
+	if(iter == widths_.begin()) return tree_->GetHead()->width;
+	const NodeRef& ref = path_[*(iter - 1)];
+	return ref.start + ref.Get()->width;
+}
+
+void IncrementalParser::_pushPath(const NodeRef& ref){
+	if(ref.Get()->width != SyntaxNode::REST_WIDTH) widths_.push_back(path_.size());
+	path_.push_back(ref);
+}
+
+void IncrementalParser::_resizePath(size_t size){
+	path_.resize(size);
+	while(!widths_.empty() && widths_.back() >= size) widths_.pop_back();
+}
+
+/* The node path_[depth] is parsed again by the same LL(1) table, and on the way every subtree of the old node
+ * lying wholly before or after the change is spliced in instead of being parsed, since a nonterminal
+ * expanded at the same token over the same tokens always derives the same subtree. A node which begins
+ * right at the change was predicted by a token which has changed, so it is only repaired if the decisions
+ * taken at that token still hold, that is the new token is in the SELECT sets of the rules chosen there.
+ */
+bool IncrementalParser::_reparse(size_t depth, size_t first, size_t removed, size_t inserted){
+	struct Frame {
+		SyntaxNode* parent;
+		size_t index;
+		SymbolId symbol;
+	};
+	struct Splice {
+		SyntaxNode* parent;
+		size_t index;
+		NodeRef old;
+		size_t width;
+	};
+
+	const NodeRef target = path_[depth];
+	const SyntaxNode* old_node = target.Get();
+	const size_t start = target.start, old_width = _end(depth) - start;
+	const size_t new_end = start + old_width - removed + inserted;
+	const size_t changed_end = first + inserted; //the new tokens after it are the old ones from first + removed
+	if(start == first && !_decisionsHold(depth, _look(start))) return false;
+
+	SyntaxNode holder;
+	holder.addChild(old_node->term, SyntaxNode::NONTERMINAL);
+	std::vector<Frame> st{ Frame{ &holder, 0, grammar_.FindSymbol(old_node->term) } };
+	std::vector<SyntaxNode*> expanded;
+	std::vector<Splice> splices;
+	OldTreeCursor cursor(target, old_width);
+	size_t pos = start, matched = 0, created = 1;
+	SymbolId look = _look(pos);
+
+	while(!st.empty()){
+		Frame f = st.back();
+		st.pop_back();
+		SyntaxNode* node = f.parent->children[f.index].get();
+		if(f.symbol == grammar_.EpsilonSymbol()) continue;
+		if(!grammar_.IsNonTerminal(f.symbol)){
+			if(f.symbol != look || pos >= new_end) return false;
+			node->width = 1;
+			look = _look(++pos);
+			matched++;
+			continue;
+		}
+
+		//an old subtree over unchanged tokens, whose lookahead at its end is unchanged too, is the same
+		if(pos < first || pos >= changed_end){
+			const size_t q = pos < first ? pos : pos - inserted + removed;
+			NodeRef old{ nullptr, 0, 0 };
+			size_t width = 0;
+			if(cursor.Seek(q, node->term, old, width)){
+				if((pos >= changed_end || q + width < first) && pos + width <= new_end){
+					cursor.Skip();
+					splices.push_back(Splice{ f.parent, f.index, old, width });
+					pos += width;
+					look = _look(pos);
+					continue;
+				}
+			}
+		}
+
+		int r = grammar_.Predict(f.symbol, look);
+		if(r == CompiledGrammar::NoRule) return false;
+		const std::vector<SymbolId>& rhs = grammar_.GetRule(r).rhs;
+		for(auto s : rhs)
+			node->addChild(grammar_.SymbolName(s), grammar_.IsTerminal(s) ? SyntaxNode::TERMINAL : SyntaxNode::NONTERMINAL);
+		for(size_t i = rhs.size(); i-- > 0;) //reverse order to stack
+			st.push_back(Frame{ node, i, rhs[i] });
+		created += rhs.size();
+		expanded.push_back(node);
+	}
+	if(pos != new_end) return false;
+
+	//nothing is moved until the repair succeeds, so a failed one leaves the old tree as it was
+	for(const auto& s : splices){
+		s.parent->children[s.index] = std::move(s.old.parent->children[s.old.index]);
+		s.parent->children[s.index]->width = s.width;
+	}
+	for(auto iter = expanded.rbegin(); iter != expanded.rend(); ++iter){
+		SyntaxNode* node = *iter;
+		node->width = 0;
+		for(const auto& child : node->children) node->width += child->width;
+	}
+	for(SyntaxNode* node : expanded) _leaveRest(node);
+	if(target.index + 1 == target.parent->children.size()) holder.children[0]->width = SyntaxNode::REST_WIDTH;
+	std::swap(target.parent->children[target.index], holder.children[0]);
+
+	//the old node itself may have been reused, as the empty tail of an insertion at its start
+	const size_t dropped = holder.children[0] ? _countNodes(holder.children[0].get()) : 0;
+	//the ancestors without their widths follow their parents
+	if(inserted != removed)
+		for(size_t i = 0; i < widths_.size() && widths_[i] < depth; i++)
+			path_[widths_[i]].Get()->width = path_[widths_[i]].Get()->width + inserted - removed;
+	tree_->GetHead()->width = tokens_.size();
+	tree_->counter = static_cast<int>(tree_->counter + created - splices.size() - dropped);
+
+	stats_.parsedTokens = matched;
+	stats_.reusedNodes = splices.size();
+	stats_.createdNodes = created - splices.size();
+	return true;
+}
+
+/* The nodes out of the repaired one which were predicted by the token at its start: the ancestors
+ * beginning there, which are the last ones of the path, and the empty nodes just before it, which are the
+ * empty siblings and the empty last descendants of the node ending there.
+ */
+bool IncrementalParser::_decisionsHold(size_t depth, SymbolId look) const {
+	const size_t start = path_[depth].start;
+	for(size_t i = depth + 1; i-- > 0 && path_[i].start == start;){
+		if(i < depth && !_predicts(path_[i].Get(), look)) return false;
+		//the siblings before a node keep their widths
+		for(size_t j = path_[i].index; j-- > 0;){
+			const SyntaxNode* sibling = path_[i].parent->children[j].get();
+			if(sibling->width != 0){
+				if(!_tailDecisionsHold(sibling, sibling->width, look)) return false;
+				break;
+			}
+			if(!_emptyDecisionsHold(sibling, look)) return false;
+		}
+	}
+	return true;
+}
+
+bool IncrementalParser::_emptyDecisionsHold(const SyntaxNode* node, SymbolId look) const {
+	if(!_predicts(node, look)) return false;
+	for(const auto& child : node->children)
+		if(!_emptyDecisionsHold(child.get(), look)) return false;
+	return true;
+}
+
+//the empty nodes at the end of a node which is not empty, it covers 'width' tokens
+bool IncrementalParser::_tailDecisionsHold(const SyntaxNode* node, size_t width, SymbolId look) const {
+	while(node){
+		const SyntaxNode* next = nullptr;
+		size_t next_width = 0;
+		for(size_t j = node->children.size(); j-- > 0 && !next;){
+			const size_t child_width = _childWidth(node, width, j);
+			if(child_width != 0){
+				next = node->children[j].get();
+				next_width = child_width;
+			}
+			else if(!_emptyDecisionsHold(node->children[j].get(), look)) return false;
+		}
+		node = next;
+		width = next_width;
+	}
+	return true;
+}
+
+//look still selects the rule node has been expanded by
+bool IncrementalParser::_predicts(const SyntaxNode* node, SymbolId look) const {
+	SymbolId id = grammar_.FindSymbol(node->term);
+	if(!grammar_.IsNonTerminal(id)) return true; //terminals and epsilon leaves decide nothing
+	int r = grammar_.Predict(id, look);
+	if(r == CompiledGrammar::NoRule) return false;
+	const std::vector<SymbolId>& rhs = grammar_.GetRule(r).rhs;
+	if(rhs.size() != node->children.size()) return false;
+	for(size_t i = 0; i < rhs.size(); i++)
+		if(grammar_.SymbolName(rhs[i]) != node->children[i]->term) return false;
+	return true;
+}
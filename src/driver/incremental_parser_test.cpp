@@ -0,0 +1,222 @@
+#include <random>
+#include "gtest/gtest.h"
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "incremental_parser.h"
+#include "syntax/test_grammar.h"
+
+static std::unique_ptr<ContextFreeGrammar> ProgramGrammar(){
+	return TestGrammar("incremental_parser_test.syn", { "<P>-><S><P>|#", "<S>->let id = <E> ;|print <E> ;",
+						"<E>-><E>+<T>|<T>", "<T>-><T>*<F>|<F>", "<F>->id|num|(<E>)" }, true, true);
+}
+
+/* Preorder terms with their widths, node covers 'width' tokens. Only the last child may leave its width to
+ * its parent, and if it is a nonterminal, the widths of the others add up to the width of the node.
+ */
+static void Dump(const SyntaxNode* node, size_t width, std::string& out){
+	out += node->term + ":" + std::to_string(width) + "(";
+	size_t sum = node->type == SyntaxNode::TERMINAL ? 1 : 0;
+	for(size_t i = 0; i < node->children.size(); i++){
+		const SyntaxNode* child = node->children[i].get();
+		size_t child_width = child->width;
+		if(child_width == SyntaxNode::REST_WIDTH){
+			EXPECT_EQ(i + 1, node->children.size()) << child->term;
+			EXPECT_EQ(child->type, SyntaxNode::NONTERMINAL) << child->term;
+			child_width = width - sum;
+		}
+		Dump(child, child_width, out);
+		sum += child_width;
+	}
+	out += ")";
+	EXPECT_EQ(sum, width) << node->term;
+}
+
+static std::string Dump(const IncrementalParser& parser){
+	std::string out = parser.Tree().IsAccepted() ? "accepted " : "rejected ";
+	for(const auto& d : parser.Tree().diagnostics)
+		out += std::to_string(d.position) + ":" + d.token + ":" + d.expected + " ";
+	if(parser.Tree().IsAccepted()){
+		EXPECT_EQ(parser.Tree().head->width, parser.TokenCount());
+		Dump(parser.Tree().head.get(), parser.Tree().head->width, out);
+	}
+	return out;
+}
+
+static std::string Program(int statements){
+	std::string text;
+	for(int i = 0; i < statements; i++)
+		text += i % 2 ? "let id = id * ( num + id ) ;\n" : "print id + num * id ;\n";
+	return text;
+}
+
+TEST(IncrementalParserTest, ReusesUntouchedSubtrees){
+	CompiledGrammar grammar(*ProgramGrammar());
+	IncrementalParser parser(grammar), fresh(grammar);
+	std::string text = Program(200);
+	parser.Reset(text);
+	ASSERT_TRUE(parser.Tree().IsAccepted());
+	EXPECT_TRUE(parser.LastEdit().fullParse);
+
+	//replace one 'num' in the middle of the text
+	size_t offset = text.find("num", text.size() / 2);
+	parser.Edit(offset, 3, "( id + num )");
+	text.replace(offset, 3, "( id + num )");
+	fresh.Reset(text);
+	EXPECT_EQ(parser.Text(), text);
+	EXPECT_EQ(Dump(parser), Dump(fresh));
+	EXPECT_EQ(parser.Tree().counter, fresh.Tree().counter);
+	EXPECT_FALSE(parser.LastEdit().fullParse);
+	EXPECT_LT(parser.LastEdit().parsedTokens, 20u);
+	EXPECT_GT(parser.LastEdit().reusedNodes, 0u);
+	EXPECT_LT(parser.LastEdit().relexedBytes, 20u);
+
+	//blanks only, nothing to parse
+	parser.Edit(offset, 0, "  \n ");
+	EXPECT_FALSE(parser.LastEdit().fullParse);
+	EXPECT_EQ(parser.LastEdit().parsedTokens, 0u);
+	EXPECT_EQ(parser.TokenAt(parser.TokenCount() - 1).offset + 1, parser.TextSize() - 1);
+
+	//a statement appended at the end
+	parser.Edit(parser.Text().size(), 0, "print num ;");
+	text = parser.Text();
+	fresh.Reset(text);
+	EXPECT_EQ(Dump(parser), Dump(fresh));
+	EXPECT_FALSE(parser.LastEdit().fullParse);
+	EXPECT_LT(parser.LastEdit().parsedTokens, 10u);
+}
+
+TEST(IncrementalParserTest, ErrorsAreParsedCompletely){
+	CompiledGrammar grammar(*ProgramGrammar());
+	IncrementalParser parser(grammar), fresh(grammar);
+	parser.Reset(Program(10));
+
+	//'foo' is not a terminal, its name comes back from the text
+	size_t offset = parser.Text().find("num");
+	parser.Edit(offset, 3, "foo");
+	fresh.Reset(parser.Text());
+	EXPECT_FALSE(parser.Tree().IsAccepted());
+	EXPECT_TRUE(parser.LastEdit().fullParse);
+	ASSERT_FALSE(parser.Tree().diagnostics.empty());
+	EXPECT_EQ(parser.Tree().diagnostics[0].token, "foo");
+	EXPECT_EQ(Dump(parser), Dump(fresh));
+
+	parser.Edit(offset, 3, "num");
+	EXPECT_TRUE(parser.Tree().IsAccepted());
+	EXPECT_EQ(parser.Text(), Program(10));
+
+	parser.Edit(0, parser.Text().size(), "");
+	EXPECT_EQ(parser.TokenCount(), 0u);
+	parser.Edit(0, 0, "print id ;");
+	EXPECT_TRUE(parser.Tree().IsAccepted());
+}
+
+//random edits, some of them splitting or joining tokens, always give the tree of a complete parse
+TEST(IncrementalParserTest, RandomEditsMatchCompleteParse){
+	CompiledGrammar grammar(*ProgramGrammar());
+	IncrementalParser parser(grammar), fresh(grammar);
+	parser.Reset(Program(20));
+
+	const std::vector<std::string> pieces{ "id", "num", "+", "*", "(", ")", " ", "\n", ";", "let id =", "print",
+		"i", "d", "nu", "( id + num )", "+ id", "* num", "print id ;", "let id = num ;" };
+	std::mt19937 random(2024);
+	size_t incremental = 0;
+	for(int i = 0; i < 2000; i++){
+		const std::string& text = parser.Text();
+		size_t offset = random() % (text.size() + 1);
+		size_t removed = random() % 3 == 0 ? random() % 8 : 0;
+		std::string inserted = random() % 4 == 0 ? "" : pieces[random() % pieces.size()];
+		//keep the text near a valid program, so most of the edits are repaired incrementally
+		if(!parser.Tree().IsAccepted() && random() % 2 == 0) { parser.Reset(Program(20)); continue; }
+
+		parser.Edit(offset, removed, inserted);
+		fresh.Reset(parser.Text());
+		ASSERT_EQ(Dump(parser), Dump(fresh)) << "edit " << i << " at " << offset;
+		ASSERT_EQ(parser.Tree().counter, fresh.Tree().counter);
+		ASSERT_EQ(parser.TokenCount(), fresh.TokenCount());
+		for(size_t t = 0; t < fresh.TokenCount(); t++){
+			ASSERT_EQ(parser.TokenAt(t).offset, fresh.TokenAt(t).offset);
+			ASSERT_EQ(parser.TokenAt(t).length, fresh.TokenAt(t).length);
+		}
+		if(!parser.LastEdit().fullParse) incremental++;
+	}
+	EXPECT_GT(incremental, 100u);
+}
+
+static bool SameTokens(const IncrementalParser& parser, const IncrementalParser& fresh){
+	if(parser.TokenCount() != fresh.TokenCount()) return false;
+	for(size_t t = 0; t < fresh.TokenCount(); t++)
+		if(parser.TokenAt(t).offset != fresh.TokenAt(t).offset || parser.TokenAt(t).length != fresh.TokenAt(t).length
+			|| parser.TokenAt(t).id != fresh.TokenAt(t).id) return false;
+	return true;
+}
+
+TEST(IncrementalParserTest, ResumesFromCheckpoints){
+	CompiledGrammar grammar(*ProgramGrammar());
+	const IncrementalParser::Comments comments{ "//", "/*", "*/" };
+	IncrementalParser parser(grammar, comments), fresh(grammar, comments);
+	//a long block comment between two programs
+	std::string text = Program(100) + "/* " + Program(400) + " */\n" + Program(100) + "// the end";
+	parser.Reset(text);
+	ASSERT_TRUE(parser.Tree().IsAccepted());
+	EXPECT_GT(parser.CheckpointCount(), text.size() / IncrementalParser::CHECKPOINT_BYTES / 2);
+
+	//keystrokes in the middle of the comment are scanned from the checkpoint before them up to the next one
+	size_t offset = text.find("num", text.size() / 2);
+	for(const char* word : { "x", "", "*", "", "/", "" }){
+		parser.Edit(offset, parser.Text()[offset] == 'n' ? 0 : 1, word);
+		fresh.Reset(parser.Text());
+		EXPECT_TRUE(SameTokens(parser, fresh));
+		EXPECT_EQ(Dump(parser), Dump(fresh));
+		EXPECT_LE(parser.LastEdit().relexedBytes, 2 * IncrementalParser::CHECKPOINT_BYTES + 4);
+		EXPECT_EQ(parser.LastEdit().relexedTokens, 0u);
+		EXPECT_EQ(parser.LastEdit().parsedTokens, 0u);
+	}
+
+	//closing the comment early brings back its tail as tokens, up to the old end
+	parser.Edit(offset, 0, "*/ ");
+	fresh.Reset(parser.Text());
+	EXPECT_TRUE(SameTokens(parser, fresh));
+	EXPECT_EQ(Dump(parser), Dump(fresh));
+	EXPECT_GT(parser.LastEdit().relexedTokens, 100u);
+	parser.Edit(offset, 3, "");
+	EXPECT_EQ(parser.Text(), text);
+	fresh.Reset(text);
+	EXPECT_TRUE(SameTokens(parser, fresh));
+	EXPECT_TRUE(parser.Tree().IsAccepted());
+
+	//a keystroke between tokens is scanned from the token before it
+	offset = text.find("num", text.size() - 100);
+	parser.Edit(offset, 3, "id");
+	EXPECT_LT(parser.LastEdit().relexedBytes, 10u);
+	EXPECT_EQ(parser.LastEdit().relexedTokens, 1u);
+}
+
+//random edits of a text with comments scan the same tokens as the whole text
+TEST(IncrementalParserTest, RandomEditsWithComments){
+	CompiledGrammar grammar(*ProgramGrammar());
+	const IncrementalParser::Comments comments{ "//", "/*", "*/" };
+	IncrementalParser parser(grammar, comments), fresh(grammar, comments);
+	const std::string start = Program(20) + "// a line\n/* a block\n" + Program(10) + "*/" + Program(20);
+	parser.Reset(start);
+
+	const std::vector<std::string> pieces{ "id", "num", "+", " ", "\n", ";", "//", "/*", "*/", "/", "*", "print id ;",
+		"/* num */", "// id\n" };
+	std::mt19937 random(2025);
+	for(int i = 0; i < 3000; i++){
+		const std::string& text = parser.Text();
+		size_t offset = random() % (text.size() + 1);
+		size_t removed = random() % 3 == 0 ? random() % 8 : 0;
+		std::string inserted = random() % 4 == 0 ? "" : pieces[random() % pieces.size()];
+		if(random() % 50 == 0) { parser.Reset(start); continue; }
+
+		parser.Edit(offset, removed, inserted);
+		fresh.Reset(parser.Text());
+		ASSERT_TRUE(SameTokens(parser, fresh)) << "edit " << i << " at " << offset;
+		ASSERT_EQ(Dump(parser), Dump(fresh)) << "edit " << i << " at " << offset;
+	}
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
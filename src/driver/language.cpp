@@ -0,0 +1,109 @@
+#include <thread>
+#include "language.h"
+#include "error.h"
+#include "task_scheduler.h"
+#include "utility/utility_internal.h"
+
+bool Language::_buildGrammar(std::string& error){
+	std::unique_ptr<GrammarGenerator> gen = CreateGrammarGenerator("QGrammarGeneratorFactory");
+	if(!gen->OpenFile(spec_.grammarFile)){
+		error = "cannot open " + spec_.grammarFile;
+		return false;
+	}
+
+	grammar_.reset(new ContextFreeGrammar(gen->GrammarGenerate()));
+	ContextFreeGrammar& gram = *grammar_;
+	gram.ElimLeftRecur();
+	gram.LeftFactoring();
+	gram.GetFirstTable();
+	gram.GetFollowTable();
+	gram.GetSelectTable();
+	if(gram.ConstructLL1Table()){
+		error = spec_.grammarFile + " is not LL(1)";
+		return false;
+	}
+	compiled_.reset(new CompiledGrammar(gram));
+	return true;
+}
+
+//the errors are collected in a sink of this stage, so they do not interleave with the other stage
+bool Language::_buildLexer(std::string& error){
+	if(spec_.lexFile.empty()) return true;
+	lexer_ = CreateRgeAnalyzier("QRgeAnalyzier");
+	ErrorSink sink;
+	{
+		ErrorSinkScope scope(sink);
+		if(!lexer_->OpenFile(spec_.lexFile)){
+			error = "cannot open " + spec_.lexFile;
+			MergeErrors(sink);
+			return false;
+		}
+		domain_ = lexer_->RgeAnalyse();
+	}
+	if(!sink.errors.empty()){
+		const ErrMsg& first = sink.errors.front();
+		error = spec_.lexFile + ":" + std::to_string(first.lineNum) + ": " + first.msg;
+		MergeErrors(sink);
+		return false;
+	}
+	IDStateBuilder* builder = lexer_->GetIDStateBuilder();
+	if(builder) idDfa_ = builder->GenerateDFA();
+	return true;
+}
+
+//the language if both of its stages succeeded, or the reason of the first failure
+static std::unique_ptr<Language> _joinStages(std::unique_ptr<Language> lang, bool lexOk, const std::string& lexError,
+						bool grammarOk, const std::string& grammarError, std::string* error){
+	if(lexOk && grammarOk) return lang;
+	if(error) *error = lexOk ? grammarError : lexError;
+	return nullptr;
+}
+
+std::unique_ptr<Language> Language::Load(const LanguageSpec& spec, std::string* error){
+	std::unique_ptr<Language> lang(new Language);
+	lang->spec_ = spec;
+
+	bool lex_ok = true;
+	std::string lex_error, grammar_error;
+	std::thread lexer;
+	if(!spec.lexFile.empty()) lexer = std::thread([&]() { lex_ok = lang->_buildLexer(lex_error); });
+	bool grammar_ok = lang->_buildGrammar(grammar_error);
+	if(lexer.joinable()) lexer.join();
+	return _joinStages(std::move(lang), lex_ok, lex_error, grammar_ok, grammar_error, error);
+}
+
+std::unique_ptr<Language> Language::Load(const std::string& name, const std::string& synFile, std::string* error){
+	return Load(LanguageSpec{ name, synFile, "" }, error);
+}
+
+std::vector<std::unique_ptr<Language>> Language::LoadAll(const std::vector<LanguageSpec>& specs,
+						TaskScheduler& scheduler, std::vector<std::string>* errors){
+	const size_t n = specs.size();
+	std::vector<std::unique_ptr<Language>> langs(n);
+	//not vector<bool>, the flags are written by different tasks
+	std::vector<char> lex_ok(n, 1), grammar_ok(n, 1);
+	std::vector<std::string> lex_errors(n), grammar_errors(n);
+	for(size_t i = 0; i < n; i++){
+		langs[i].reset(new Language);
+		langs[i]->spec_ = specs[i];
+	}
+	for(size_t i = 0; i < n; i++){
+		Language* lang = langs[i].get();
+		if(!specs[i].lexFile.empty())
+			scheduler.Submit([lang, i, &lex_ok, &lex_errors]() { lex_ok[i] = lang->_buildLexer(lex_errors[i]); });
+		scheduler.Submit([lang, i, &grammar_ok, &grammar_errors]() { grammar_ok[i] = lang->_buildGrammar(grammar_errors[i]); });
+	}
+	scheduler.Wait();
+
+	if(errors) errors->assign(n, "");
+	for(size_t i = 0; i < n; i++)
+		langs[i] = _joinStages(std::move(langs[i]), lex_ok[i] != 0, lex_errors[i], grammar_ok[i] != 0, grammar_errors[i],
+						errors ? &(*errors)[i] : nullptr);
+	return langs;
+}
+
+std::vector<std::string> Language::Lex(const std::string& buffer) const {
+	std::vector<std::string> tokens;
+	SplitTokens(buffer, tokens, " \t\r\n");
+	return tokens;
+}
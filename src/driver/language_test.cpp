@@ -0,0 +1,87 @@
+#include <fstream>
+#include "gtest/gtest.h"
+#include "error.h"
+#include "language.h"
+#include "task_scheduler.h"
+
+static void WriteFile(const std::string& file, const std::string& contents){
+	std::ofstream outfile(file, std::ios::binary);
+	outfile << contents;
+}
+
+static void WriteFiles(){
+	WriteFile("language_test.syn", "<E>-><E>+<T>|<T>\n<T>-><T>*<F>|<F>\n<F>->id|(<E>)\n");
+	WriteFile("language_test_ambiguous.syn", "<S>-><A>|<B>\n<A>->a\n<B>->a\n");
+	WriteFile("language_test.rge", "keywords = {if, else}\noperators = {+, *}\nsymbols = {(, )}\n"
+		"ID = {([a-c]|[A-C])([a-c]|[A-C])*}\n");
+	WriteFile("language_test_bad.rge", "keywords = {if, else}\nsymbols = {(, )\n");
+}
+
+//'ab' is an ID: the first character moves away from the start state, and the second one is accepted too
+static bool AcceptsID(const DFA& dfa, const std::string& str){
+	int state = 0;
+	for(char c : str){
+		state = dfa.StateTransfer(state, c);
+		if(state == dfa.unReachable_) return false;
+	}
+	return dfa.isTerminal_[state];
+}
+
+TEST(LanguageTest, LoadBuildsLexerAndGrammar){
+	WriteFiles();
+	std::string error;
+	std::unique_ptr<Language> lang = Language::Load(LanguageSpec{ "expr", "language_test.syn", "language_test.rge" }, &error);
+	ASSERT_TRUE(lang != nullptr) << error;
+	EXPECT_EQ(lang->LexFile(), "language_test.rge");
+	ASSERT_TRUE(lang->Domain() != nullptr);
+	ASSERT_TRUE(lang->IDDfa() != nullptr);
+	EXPECT_TRUE(AcceptsID(*lang->IDDfa(), "aB"));
+	EXPECT_FALSE(AcceptsID(*lang->IDDfa(), "ad"));
+	EXPECT_TRUE(lang->Grammar().Parse(lang->Lex("id + id * ( id )"))->IsAccepted());
+
+	//without the lexical rules file
+	lang = Language::Load("expr", "language_test.syn");
+	ASSERT_TRUE(lang != nullptr);
+	EXPECT_TRUE(lang->Domain() == nullptr);
+	EXPECT_TRUE(lang->IDDfa() == nullptr);
+}
+
+TEST(LanguageTest, LoadFailures){
+	WriteFiles();
+	std::string error;
+	EXPECT_TRUE(Language::Load(LanguageSpec{ "a", "language_test_ambiguous.syn", "language_test.rge" }, &error) == nullptr);
+	EXPECT_EQ(error, "language_test_ambiguous.syn is not LL(1)");
+	EXPECT_TRUE(Language::Load(LanguageSpec{ "a", "language_test.syn", "language_test_missing.rge" }, &error) == nullptr);
+	EXPECT_EQ(error, "cannot open language_test_missing.rge");
+
+	size_t before = GetAllErrors().size();
+	EXPECT_TRUE(Language::Load(LanguageSpec{ "a", "language_test.syn", "language_test_bad.rge" }, &error) == nullptr);
+	EXPECT_EQ(error.compare(0, 22, "language_test_bad.rge:"), 0) << error;
+	EXPECT_GT(GetAllErrors().size(), before);
+}
+
+TEST(LanguageTest, LoadAllInParallel){
+	WriteFiles();
+	std::vector<LanguageSpec> specs;
+	for(int i = 0; i < 16; i++) specs.push_back(LanguageSpec{ "expr" + std::to_string(i), "language_test.syn", "language_test.rge" });
+	specs.push_back(LanguageSpec{ "bad", "language_test_ambiguous.syn", "" });
+
+	TaskScheduler scheduler(4);
+	std::vector<std::string> errors;
+	std::vector<std::unique_ptr<Language>> langs = Language::LoadAll(specs, scheduler, &errors);
+	ASSERT_EQ(langs.size(), specs.size());
+	for(int i = 0; i < 16; i++){
+		ASSERT_TRUE(langs[i] != nullptr) << errors[i];
+		EXPECT_EQ(langs[i]->Name(), specs[i].name);
+		EXPECT_TRUE(AcceptsID(*langs[i]->IDDfa(), "cab"));
+		EXPECT_TRUE(langs[i]->Grammar().Parse(langs[i]->Lex("( id + id ) * id"))->IsAccepted());
+		EXPECT_EQ(errors[i], "");
+	}
+	EXPECT_TRUE(langs[16] == nullptr);
+	EXPECT_EQ(errors[16], "language_test_ambiguous.syn is not LL(1)");
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,293 @@
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <thread>
+#include "parse_service.h"
+#include "utility/rcu_cell.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+const size_t ParseService::MAX_REQUEST_BYTES;
+
+ParseService::ParseService() {
+}
+
+ParseService::~ParseService() {
+	Stop();
+}
+
+bool ParseService::AddLanguage(std::unique_ptr<Language> lang){
+	if(!lang || languages_.find(lang->Name()) != languages_.end()) return false;
+	std::string name = lang->Name();
+	languages_[name].reset(new RcuCell<Language>(std::move(lang)));
+	return true;
+}
+
+const Language* ParseService::FindLanguage(const std::string& name) const {
+	auto iter = languages_.find(name);
+	return iter == languages_.end() ? nullptr : iter->second->Get();
+}
+
+bool ParseService::Reload(const std::string& name, std::string* error){
+	auto iter = languages_.find(name);
+	if(iter == languages_.end()){
+		if(error) *error = "unknown language " + name;
+		return false;
+	}
+
+	//the reloads are serialized, so the current language cannot be retired while its file is read
+	std::lock_guard<std::mutex> lock(reloadMutex_);
+	std::unique_ptr<Language> lang = Language::Load(iter->second->Get()->Spec(), error);
+	if(!lang) return false;
+	iter->second->Publish(std::move(lang));
+	return true;
+}
+
+size_t ParseService::ReloadAll(std::string* errors){
+	size_t failed = 0;
+	for(const auto& lang : languages_){
+		std::string error;
+		if(Reload(lang.first, &error)) continue;
+		failed++;
+		if(errors) *errors += error + "\n";
+	}
+	return failed;
+}
+
+//preorder from an explicit stack, a tree may be too deep to be written recursively
+static void _writeTree(const SyntaxNode* root, std::string& out){
+	std::vector<std::pair<const SyntaxNode*, size_t>> stack{ { root, 0 } };
+	while(!stack.empty()){
+		const SyntaxNode* node = stack.back().first;
+		const size_t depth = stack.back().second;
+		stack.pop_back();
+		out += std::to_string(depth) + " " + node->term + "\n";
+		for(auto it = node->children.rbegin(); it != node->children.rend(); ++it) stack.emplace_back(it->get(), depth + 1);
+	}
+}
+
+ParseResponse ParseService::Handle(const ParseRequest& request) const {
+	return _handle(request, Clock::now());
+}
+
+/* The deadline is checked between the stages and every 256 tokens while parsing, a parse which runs out
+ * of time is cut off by ending its token source early.
+ */
+ParseResponse ParseService::_handle(const ParseRequest& request, Clock::time_point received) const {
+	EpochGuard guard; //the language is not freed by a reload until the request is done
+	const Language* lang = FindLanguage(request.language);
+	if(!lang) return ParseResponse{ "error", "unknown language " + request.language };
+	if(request.op != "lex" && request.op != "parse" && request.op != "tree")
+		return ParseResponse{ "error", "unknown op " + request.op };
+
+	const Clock::time_point deadline = received + std::chrono::microseconds(request.deadline);
+	auto expired = [&request, &deadline]() { return request.deadline != 0 && Clock::now() >= deadline; };
+	if(expired()) return ParseResponse{ "timeout", "" };
+
+	std::vector<std::string> tokens = lang->Lex(request.buffer);
+	if(expired()) return ParseResponse{ "timeout", "" };
+	if(request.op == "lex"){
+		ParseResponse response{ "ok", "" };
+		for(const auto& t : tokens){
+			if(!response.payload.empty()) response.payload += ' ';
+			response.payload += t;
+		}
+		return response;
+	}
+
+	const CompiledGrammar& grammar = lang->Grammar();
+	const ParseCache::Tokens ids = ParseCache::TokenIds(grammar, tokens);
+	ParseCache::Tree tree = cache_ ? cache_->Find(grammar, ids) : nullptr;
+	if(!tree){
+		size_t ind = 0;
+		bool timed_out = false;
+		std::unique_ptr<SyntaxTree> parsed = grammar.Parse([&](CompiledGrammar::SymbolId& id) {
+			if(ind >= ids.size()) return false;
+			if((ind & 255) == 0 && expired()) { timed_out = true; return false; }
+			id = ids[ind++];
+			return true;
+		});
+		if(timed_out) return ParseResponse{ "timeout", "" };
+		//a cached tree is shared by the requests, it is compacted once before being published
+		if(parsed->IsAccepted() && (cache_ || request.op == "tree")) parsed->Compact(grammar.InnerPrefix());
+		tree = std::move(parsed);
+		if(cache_) cache_->Insert(grammar, ids, tree);
+	}
+
+	if(!tree->IsAccepted()){
+		ParseResponse response{ "rejected", "" };
+		for(const auto& d : tree->diagnostics){
+			//unknown terms have no names in the grammar, take them back from the tokens
+			const std::string& token = d.position < tokens.size() ? tokens[d.position] : d.token;
+			response.payload += std::to_string(d.position) + "\t" + token + "\t" + d.expected + "\n";
+		}
+		return response;
+	}
+
+	ParseResponse response{ "ok", "" };
+	if(request.op == "tree"){
+		for(const auto& child : tree->head->children) _writeTree(child.get(), response.payload);
+	}
+	return response;
+}
+
+std::string ParseService::EncodeRequest(const ParseRequest& request){
+	return request.op + " " + request.language + " " + std::to_string(request.deadline) + " "
+		+ std::to_string(request.buffer.size()) + "\n" + request.buffer;
+}
+
+std::string ParseService::EncodeResponse(const ParseResponse& response){
+	return response.status + " " + std::to_string(response.payload.size()) + "\n" + response.payload;
+}
+
+//the old languages are freed here too, once the requests using them are done
+void ParseService::_reloadLoop(){
+	while(!stop_.load()){
+		if(reload_.exchange(false)){
+			std::string errors;
+			if(ReloadAll(&errors)) std::cerr << errors;
+		}
+		for(const auto& lang : languages_) lang.second->Reclaim();
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+}
+
+size_t ParseService::HandleBuffer(const char* data, size_t size, std::string& responses, bool& malformed) const {
+	const size_t max_header = 1024;
+	const Clock::time_point received = Clock::now();
+	malformed = false;
+
+	size_t pos = 0;
+	while(pos < size){
+		const char* eol = static_cast<const char*>(memchr(data + pos, '\n', size - pos));
+		if(!eol){
+			malformed = size - pos > max_header;
+			break;
+		}
+		std::istringstream header(std::string(data + pos, eol));
+		ParseRequest request;
+		size_t length = 0;
+		std::string rest;
+		if(!(header >> request.op >> request.language >> request.deadline >> length) || (header >> rest)
+			|| length > MAX_REQUEST_BYTES){
+			malformed = true;
+			break;
+		}
+
+		size_t begin = static_cast<size_t>(eol - data) + 1;
+		if(size - begin < length) break; //the buffer has not arrived completely
+		request.buffer.assign(data + begin, length);
+		responses += EncodeResponse(_handle(request, received));
+		pos = begin + length;
+	}
+
+	if(malformed){
+		responses += EncodeResponse(ParseResponse{ "error", "malformed request" });
+		return size;
+	}
+	return pos;
+}
+
+#ifndef _WIN32
+static bool _sendAll(int fd, const std::string& data){
+#ifdef MSG_NOSIGNAL
+	const int flags = MSG_NOSIGNAL; //a client which has gone should not kill the service
+#else
+	const int flags = 0;
+#endif
+	size_t sent = 0;
+	while(sent < data.size()){
+		ssize_t n = send(fd, data.data() + sent, data.size() - sent, flags);
+		if(n <= 0) return false;
+		sent += static_cast<size_t>(n);
+	}
+	return true;
+}
+
+//the sockets are polled with a timeout, so the threads notice Stop() in time
+static const int POLL_MILLISECONDS = 100;
+
+void ParseService::_serveConnection(int fd){
+	std::string pending, responses;
+	std::vector<char> chunk(1 << 16);
+	while(!stop_.load()){
+		pollfd pfd{ fd, POLLIN, 0 };
+		int ready = poll(&pfd, 1, POLL_MILLISECONDS);
+		if(ready < 0) break;
+		if(ready == 0) continue;
+
+		ssize_t n = read(fd, chunk.data(), chunk.size());
+		if(n <= 0) break;
+		pending.append(chunk.data(), static_cast<size_t>(n));
+
+		//all the complete requests received so far are one batch
+		bool malformed = false;
+		responses.clear();
+		size_t consumed = HandleBuffer(pending.data(), pending.size(), responses, malformed);
+		pending.erase(0, consumed);
+		if(!responses.empty() && !_sendAll(fd, responses)) break;
+		if(malformed) break;
+	}
+	close(fd);
+}
+
+bool ParseService::Serve(const std::string& socketPath){
+	sockaddr_un addr{};
+	if(socketPath.size() >= sizeof(addr.sun_path)) return false;
+	addr.sun_family = AF_UNIX;
+	socketPath.copy(addr.sun_path, socketPath.size());
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(listener < 0) return false;
+	unlink(socketPath.c_str());
+	if(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 64) != 0){
+		close(listener);
+		return false;
+	}
+
+	struct Connection {
+		std::thread thread;
+		std::shared_ptr<std::atomic<bool>> done;
+	};
+	std::list<Connection> connections;
+	std::thread reloader(&ParseService::_reloadLoop, this);
+	while(!stop_.load()){
+		//join the threads whose clients have gone
+		for(auto iter = connections.begin(); iter != connections.end();){
+			if(!iter->done->load()) { ++iter; continue; }
+			iter->thread.join();
+			iter = connections.erase(iter);
+		}
+
+		pollfd pfd{ listener, POLLIN, 0 };
+		if(poll(&pfd, 1, POLL_MILLISECONDS) <= 0) continue;
+		int fd = accept(listener, nullptr, nullptr);
+		if(fd < 0) continue;
+
+		std::shared_ptr<std::atomic<bool>> done = std::make_shared<std::atomic<bool>>(false);
+		connections.push_back(Connection{ std::thread([this, fd, done]() {
+			_serveConnection(fd);
+			done->store(true);
+		}), done });
+	}
+
+	close(listener);
+	unlink(socketPath.c_str());
+	for(auto& c : connections) c.thread.join();
+	reloader.join();
+	return true;
+}
+#else
+void ParseService::_serveConnection(int fd){
+}
+
+bool ParseService::Serve(const std::string& socketPath){
+	return false;
+}
+#endif
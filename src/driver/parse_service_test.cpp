@@ -0,0 +1,181 @@
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include "gtest/gtest.h"
+#include "language.h"
+#include "parse_service.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static std::unique_ptr<Language> ExpressionLanguage(){
+	std::ofstream outfile("parse_service_test.syn");
+	outfile << "<E>-><E>+<T>|<T>" << std::endl;
+	outfile << "<T>-><T>*<F>|<F>" << std::endl;
+	outfile << "<F>->id|(<E>)" << std::endl;
+	outfile.close();
+	return Language::Load("expr", "parse_service_test.syn");
+}
+
+TEST(ParseServiceTest, Handle){
+	ParseService service;
+	ASSERT_TRUE(service.AddLanguage(ExpressionLanguage()));
+	EXPECT_FALSE(service.AddLanguage(ExpressionLanguage()));
+
+	ParseResponse lex = service.Handle(ParseRequest{ "lex", "expr", 0, " id +\n( id )\t" });
+	EXPECT_EQ(lex.status, "ok");
+	EXPECT_EQ(lex.payload, "id + ( id )");
+
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, "id + id * id" }).status, "ok");
+
+	ParseResponse tree = service.Handle(ParseRequest{ "tree", "expr", 0, "id + id * id" });
+	EXPECT_EQ(tree.status, "ok");
+	EXPECT_EQ(tree.payload, "0 +\n1 id\n1 *\n2 id\n2 id\n");
+
+	ParseResponse rejected = service.Handle(ParseRequest{ "parse", "expr", 0, "id + foo" });
+	EXPECT_EQ(rejected.status, "rejected");
+	EXPECT_EQ(rejected.payload.compare(0, 6, "2\tfoo\t"), 0);
+
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "json", 0, "id" }).status, "error");
+	EXPECT_EQ(service.Handle(ParseRequest{ "compile", "expr", 0, "id" }).status, "error");
+
+	std::string huge;
+	for(int i = 0; i < 200000; i++) huge += "id + ";
+	huge += "id";
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 1, huge }).status, "timeout");
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, huge }).status, "ok");
+	//the compact tree of a long sentence is as deep as the sentence
+	ParseResponse deep = service.Handle(ParseRequest{ "tree", "expr", 0, huge });
+	EXPECT_EQ(deep.status, "ok");
+	EXPECT_EQ(deep.payload.compare(0, 4, "0 +\n"), 0);
+}
+
+TEST(ParseServiceTest, Reload){
+	ParseService service;
+	ASSERT_TRUE(service.AddLanguage(ExpressionLanguage()));
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, "id - id" }).status, "rejected");
+
+	std::ofstream outfile("parse_service_test.syn");
+	outfile << "<E>-><E>+<T>|<E>-<T>|<T>" << std::endl;
+	outfile << "<T>->id|(<E>)" << std::endl;
+	outfile.close();
+	ASSERT_TRUE(service.Reload("expr"));
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, "id - id" }).status, "ok");
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, "id * id" }).status, "rejected");
+
+	//a grammar which is not LL(1) is not published
+	outfile.open("parse_service_test.syn");
+	outfile << "<E>->id|id +<E>|id" << std::endl;
+	outfile.close();
+	std::string error;
+	EXPECT_EQ(service.ReloadAll(&error), 1u);
+	EXPECT_FALSE(error.empty());
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, "id - id" }).status, "ok");
+	EXPECT_FALSE(service.Reload("json"));
+}
+
+TEST(ParseServiceTest, Cache){
+	ParseService service;
+	ASSERT_TRUE(service.AddLanguage(ExpressionLanguage()));
+	EXPECT_TRUE(service.Cache() == nullptr);
+	service.EnableCache(1 << 20);
+
+	//the same tokens hit, however the buffer is spaced, and the tree of a parse request serves a tree request
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, "id + id * id" }).status, "ok");
+	ParseResponse tree = service.Handle(ParseRequest{ "tree", "expr", 0, " id  +\tid * id\n" });
+	EXPECT_EQ(tree.payload, "0 +\n1 id\n1 *\n2 id\n2 id\n");
+	EXPECT_EQ(service.Handle(ParseRequest{ "tree", "expr", 0, "id + id * id" }).payload, tree.payload);
+	EXPECT_EQ(service.Cache()->Misses(), 1u);
+	EXPECT_EQ(service.Cache()->Hits(), 2u);
+
+	//the unknown tokens are named from the buffer, not the cached tree
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, "id + foo" }).payload.compare(0, 6, "2\tfoo\t"), 0);
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, "id + bar" }).payload.compare(0, 6, "2\tbar\t"), 0);
+	EXPECT_EQ(service.Cache()->Hits(), 3u);
+
+	//a parse cut off by the deadline is not cached
+	std::string huge;
+	for(int i = 0; i < 200000; i++) huge += "id + ";
+	huge += "id";
+	size_t entries = service.Cache()->Entries();
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 1, huge }).status, "timeout");
+	EXPECT_EQ(service.Cache()->Entries(), entries);
+
+	//a reloaded grammar does not see the old trees
+	ASSERT_TRUE(service.Reload("expr"));
+	EXPECT_EQ(service.Handle(ParseRequest{ "parse", "expr", 0, "id + id * id" }).status, "ok");
+	EXPECT_EQ(service.Cache()->Hits(), 3u);
+}
+
+TEST(ParseServiceTest, HandleBuffer){
+	ParseService service;
+	ASSERT_TRUE(service.AddLanguage(ExpressionLanguage()));
+
+	std::string batch = ParseService::EncodeRequest(ParseRequest{ "lex", "expr", 0, "id+id" })
+		+ ParseService::EncodeRequest(ParseRequest{ "parse", "expr", 0, "( id" });
+	std::string half = ParseService::EncodeRequest(ParseRequest{ "parse", "expr", 0, "id + id" });
+	batch += half.substr(0, half.size() - 3);
+
+	std::string responses;
+	bool malformed = true;
+	size_t consumed = service.HandleBuffer(batch.data(), batch.size(), responses, malformed);
+	EXPECT_FALSE(malformed);
+	EXPECT_EQ(consumed, batch.size() - (half.size() - 3));
+	EXPECT_EQ(responses.compare(0, 10, "ok 5\nid+id"), 0);
+	EXPECT_NE(responses.find("rejected "), std::string::npos);
+
+	responses.clear();
+	std::string bad = "parse expr\n";
+	EXPECT_EQ(service.HandleBuffer(bad.data(), bad.size(), responses, malformed), bad.size());
+	EXPECT_TRUE(malformed);
+	EXPECT_EQ(responses.compare(0, 6, "error "), 0);
+}
+
+#ifndef _WIN32
+TEST(ParseServiceTest, Socket){
+	ParseService service;
+	ASSERT_TRUE(service.AddLanguage(ExpressionLanguage()));
+	const std::string path = "parse_service_test.sock";
+	bool served = false;
+	std::thread server([&service, &served, &path]() { served = service.Serve(path); });
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	ASSERT_GE(fd, 0);
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	path.copy(addr.sun_path, path.size());
+	int connected = -1;
+	for(int i = 0; i < 100 && connected != 0; i++){
+		connected = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+		if(connected != 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	ASSERT_EQ(connected, 0);
+
+	//two requests in one write, the responses come back in order
+	std::string requests = ParseService::EncodeRequest(ParseRequest{ "parse", "expr", 0, "id * ( id )" })
+		+ ParseService::EncodeRequest(ParseRequest{ "tree", "expr", 0, "id" });
+	ASSERT_EQ(write(fd, requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+	const std::string expect = "ok 0\nok 5\n0 id\n";
+	std::string received;
+	char buf[256];
+	while(received.size() < expect.size()){
+		ssize_t n = read(fd, buf, sizeof(buf));
+		if(n <= 0) break;
+		received.append(buf, static_cast<size_t>(n));
+	}
+	EXPECT_EQ(received, expect);
+	close(fd);
+
+	service.Stop();
+	server.join();
+	EXPECT_TRUE(served);
+}
+#endif
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,68 @@
+#include <thread>
+#include "pipelined_parser.h"
+#include "perf_counters.h"
+#include "utility/file_reader.h"
+#include "utility/spsc_queue.h"
+#include "utility/trace.h"
+
+PipelinedParser::PipelinedParser(const CompiledGrammar& grammar, size_t ringCapacity)
+	: grammar_(grammar), ringCapacity_(ringCapacity == 0 ? 1 : ringCapacity) {
+}
+
+bool PipelinedParser::SetFileReader(const std::string& name){
+	if(!CreateFileReader(name)) return false;
+	readerName_ = name;
+	return true;
+}
+
+std::unique_ptr<SyntaxTree> PipelinedParser::ParseFile(const std::string& file){
+	std::unique_ptr<FileReader> reader = CreateFileReader(readerName_);
+	if(!reader || !reader->OpenFile(file)) return nullptr;
+
+	const CharClass blanks(" \t\r\n");
+	const CharClass word = blanks.Complement();
+	FileReader* r = reader.get();
+	const CompiledGrammar& grammar = grammar_;
+	return Parse([r, &blanks, &word, &grammar](CompiledGrammar::SymbolId& id) {
+		r->SkipWhile(blanks);
+		if(r->IsFileEnd()) return false;
+		id = grammar.FindSymbol(r->ScanWhile(word));
+		return true;
+	});
+}
+
+/* The scanner thread is the only producer and the calling thread the only consumer of the ring. Both
+ * sides block on the ring when it is full or empty(see SpscQueue::Push/Pop). The scanner closes the ring
+ * at the end of input, and the parser closes it when it stops early, so a scanner waiting on the full
+ * ring does not wait forever.
+ */
+std::unique_ptr<SyntaxTree> PipelinedParser::Parse(const CompiledGrammar::TokenSource& scan){
+	SpscQueue<CompiledGrammar::SymbolId> ring(ringCapacity_);
+	size_t scanner_stalls = 0, parser_stalls = 0;
+
+	std::thread scanner([&]() {
+		QC_TRACE_SCOPE("PipelinedParser::Scan");
+		QC_PERF_STAGE("PipelinedParser::Scan");
+		CompiledGrammar::SymbolId id;
+		bool stalled;
+		while(!ring.IsClosed() && scan(id)){
+			if(!ring.Push(id, &stalled)) break;
+			scanner_stalls += stalled;
+		}
+		ring.Close();
+	});
+
+	std::unique_ptr<SyntaxTree> tree = grammar_.Parse([&](CompiledGrammar::SymbolId& id) {
+		bool stalled;
+		//the tokens pushed before Close() are still popped
+		bool popped = ring.Pop(id, &stalled);
+		parser_stalls += stalled;
+		return popped;
+	});
+
+	ring.Close();
+	scanner.join();
+	scannerStalls_.fetch_add(scanner_stalls, std::memory_order_relaxed);
+	parserStalls_.fetch_add(parser_stalls, std::memory_order_relaxed);
+	return tree;
+}
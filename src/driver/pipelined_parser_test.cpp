@@ -0,0 +1,89 @@
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include "gtest/gtest.h"
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "pipelined_parser.h"
+#include "syntax/test_grammar.h"
+
+static std::unique_ptr<ContextFreeGrammar> ExpressionGrammar(){
+	return TestGrammar("pipelined_parser_test.syn", { "<E>-><E>+<T>|<T>", "<T>-><T>*<F>|<F>", "<F>->id|(<E>)" });
+}
+
+static void WriteFile(const std::string& name, const std::string& contents){
+	std::ofstream outfile(name, std::ios::binary);
+	outfile << contents;
+}
+
+static size_t CountNodes(const SyntaxNode* node){
+	size_t n = 1;
+	for(const auto& c : node->children) n += CountNodes(c.get());
+	return n;
+}
+
+TEST(PipelinedParserTest, SameTreeAsSequential){
+	CompiledGrammar grammar(*ExpressionGrammar());
+	std::string text = "id";
+	CompiledGrammar::Sentence sentence{ "id" };
+	for(int i = 0; i < 5000; i++){
+		text += i % 7 ? " + id" : "\n* ( id\t+ id )";
+		if(i % 7) sentence.insert(sentence.end(), { "+", "id" });
+		else sentence.insert(sentence.end(), { "*", "(", "id", "+", "id", ")" });
+	}
+	WriteFile("pipelined_parser_test.stn", text);
+
+	//a tiny ring, so both sides have to wait for each other
+	PipelinedParser parser(grammar, 4);
+	std::unique_ptr<SyntaxTree> tree = parser.ParseFile("pipelined_parser_test.stn");
+	ASSERT_TRUE(tree != nullptr);
+	EXPECT_TRUE(tree->IsAccepted());
+	std::unique_ptr<SyntaxTree> expect = grammar.Parse(sentence);
+	EXPECT_EQ(tree->counter, expect->counter);
+	EXPECT_EQ(CountNodes(tree->GetHead()), CountNodes(expect->GetHead()));
+}
+
+TEST(PipelinedParserTest, Rejected){
+	CompiledGrammar grammar(*ExpressionGrammar());
+	PipelinedParser parser(grammar, 2);
+	EXPECT_FALSE(parser.SetFileReader("NoSuchReader"));
+	ASSERT_TRUE(parser.SetFileReader("MMapFileReader"));
+
+	WriteFile("pipelined_parser_test.stn", "id + foo * id");
+	std::unique_ptr<SyntaxTree> tree = parser.ParseFile("pipelined_parser_test.stn");
+	ASSERT_TRUE(tree != nullptr);
+	EXPECT_FALSE(tree->IsAccepted());
+	ASSERT_FALSE(tree->diagnostics.empty());
+	EXPECT_EQ(tree->diagnostics[0].position, 2u);
+
+	EXPECT_TRUE(parser.ParseFile("pipelined_parser_test_missing.stn") == nullptr);
+
+	//redundant input after the sentence, the parser drains it all
+	WriteFile("pipelined_parser_test.stn", "id ) ) ) ) ) ) ) ) ) ) )");
+	tree = parser.ParseFile("pipelined_parser_test.stn");
+	EXPECT_FALSE(tree->IsAccepted());
+}
+
+//a stall is one wait of a side, not the times it checks the ring while waiting
+TEST(PipelinedParserTest, StallsAreWaits){
+	CompiledGrammar grammar(*ExpressionGrammar());
+	PipelinedParser parser(grammar, 4);
+	const CompiledGrammar::Sentence sentence{ "id", "+", "id", "*", "id" };
+	size_t ind = 0;
+	std::unique_ptr<SyntaxTree> tree = parser.Parse([&](CompiledGrammar::SymbolId& id) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5)); //a slow scanner
+		if(ind >= sentence.size()) return false;
+		id = grammar.FindSymbol(sentence[ind++]);
+		return true;
+	});
+	EXPECT_TRUE(tree->IsAccepted());
+	//one pop for each token and one for the end of input
+	EXPECT_GE(parser.ParserStalls(), 1u);
+	EXPECT_LE(parser.ParserStalls(), sentence.size() + 1);
+	EXPECT_EQ(parser.ScannerStalls(), 0u);
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -1,15 +1,96 @@
 
+#include <algorithm>
+#include <deque>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "error.h"
 #include "rgeanalyzier.h"
 
-std::vector<ErrMsg>& GetAllErrors() {
+//the lock of the merged errors and the interned names, never taken by PushError()
+static std::mutex& _errorMutex() {
+	static std::mutex mutex;
+	return mutex;
+}
+
+static std::vector<ErrMsg>& _mergedErrors() {
 	static std::vector<ErrMsg> allErrors;
 	return allErrors;
 }
 
+//deque, so the references returned by FileNameOf() are never invalidated
+static std::deque<std::string>& _fileNames() {
+	static std::deque<std::string> names;
+	return names;
+}
+
+uint32_t InternFileName(const std::string& file) {
+	thread_local std::unordered_map<std::string, uint32_t> cache;
+	auto iter = cache.find(file);
+	if (iter != cache.end()) return iter->second;
+
+	static std::unordered_map<std::string, uint32_t> ids;
+	std::lock_guard<std::mutex> lock(_errorMutex());
+	auto res = ids.insert(std::make_pair(file, static_cast<uint32_t>(_fileNames().size())));
+	if (res.second) _fileNames().push_back(file);
+	cache[file] = res.first->second;
+	return res.first->second;
+}
+
+const std::string& FileNameOf(uint32_t id) {
+	std::lock_guard<std::mutex> lock(_errorMutex());
+	return _fileNames()[id];
+}
+
+//the errors pushed out of any ErrorSinkScope, flushed in the order they were pushed
+struct ThreadErrorBuffer {
+	ErrorSink sink;
+	~ThreadErrorBuffer() { Flush(); }
+	void Flush() {
+		if (sink.errors.empty()) return;
+		std::lock_guard<std::mutex> lock(_errorMutex());
+		std::vector<ErrMsg>& allerr = _mergedErrors();
+		allerr.insert(allerr.end(), sink.errors.begin(), sink.errors.end());
+		sink.errors.clear();
+	}
+};
+
+static ThreadErrorBuffer& _threadBuffer() {
+	thread_local ThreadErrorBuffer buffer;
+	return buffer;
+}
+
+static thread_local ErrorSink* current_sink = nullptr;
+
+ErrorSinkScope::ErrorSinkScope(ErrorSink& sink) : previous_(current_sink) {
+	current_sink = &sink;
+}
+
+ErrorSinkScope::~ErrorSinkScope() {
+	current_sink = previous_;
+}
+
+void MergeErrors(ErrorSink& sink) {
+	if (sink.errors.empty()) return;
+	std::lock_guard<std::mutex> lock(_errorMutex());
+	const std::deque<std::string>& names = _fileNames();
+	std::stable_sort(sink.errors.begin(), sink.errors.end(), [&names](const ErrMsg& a, const ErrMsg& b) {
+		if (a.fileId != b.fileId) return names[a.fileId] < names[b.fileId];
+		if (a.lineNum != b.lineNum) return a.lineNum < b.lineNum;
+		return a.colNum < b.colNum;
+	});
+	std::vector<ErrMsg>& allerr = _mergedErrors();
+	allerr.insert(allerr.end(), sink.errors.begin(), sink.errors.end());
+	sink.errors.clear();
+}
+
+std::vector<ErrMsg>& GetAllErrors() {
+	_threadBuffer().Flush();
+	return _mergedErrors();
+}
+
 std::array<const char*, TOTAL_ERROR> Error_Message = {
 	"Cannot open file",
 	"Incomplete multiple comments",
@@ -22,10 +103,14 @@ std::array<const char*, TOTAL_ERROR> Error_Message = {
 	
 //Errors for FileReader
 	"File has been already opened",
+	"Compression format is not supported",
+	"Compressed data is corrupted",
+	"Failed to read file",
 };
 
 void PushError(ErrMsg&& emsg) {
-	GetAllErrors().push_back(std::move(emsg));
+	ErrorSink& sink = current_sink ? *current_sink : _threadBuffer().sink;
+	sink.errors.push_back(std::move(emsg));
 }
 
 //return 'true' if there is any error, or return 'false' if there is no error
@@ -38,7 +123,7 @@ bool PrintAllErrors() {
 }
 
 void ErrorPrint(const ErrMsg& emsg) {
-	std::cout << "Error in " << emsg.fileName << " file, " << emsg.lineNum;
+	std::cout << "Error in " << FileNameOf(emsg.fileId) << " file, " << emsg.lineNum;
 	std::cout << " line, " << emsg.colNum << " column: ";
 	std::cout << emsg.msg << std::endl;
 }
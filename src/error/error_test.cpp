@@ -0,0 +1,70 @@
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "error.h"
+
+TEST(ErrorTest, InternFileName){
+	uint32_t id = InternFileName("error_test_a.syn");
+	EXPECT_EQ(InternFileName("error_test_a.syn"), id);
+	EXPECT_NE(InternFileName("error_test_b.syn"), id);
+	EXPECT_EQ(FileNameOf(id), "error_test_a.syn");
+
+	uint32_t other = 0;
+	std::thread t([&other]() { other = InternFileName("error_test_a.syn"); });
+	t.join();
+	EXPECT_EQ(other, id);
+}
+
+//out of any scope the errors keep the order they were pushed
+TEST(ErrorTest, ThreadBufferKeepsOrder){
+	size_t errors = GetAllErrors().size();
+	uint32_t id = InternFileName("error_test_order.syn");
+	PushError(ErrMsg{ ILLEGAL_IDENTITY, Error_Message[ILLEGAL_IDENTITY], id, 5, 1 });
+	PushError(ErrMsg{ MISSING_CHAR, Error_Message[MISSING_CHAR], id, 2, 1 });
+	std::vector<ErrMsg>& allerr = GetAllErrors();
+	ASSERT_EQ(allerr.size(), errors + 2);
+	EXPECT_EQ(allerr[errors].lineNum, 5u);
+	EXPECT_EQ(allerr[errors + 1].lineNum, 2u);
+}
+
+//the errors of several threads are merged by file and position, whatever order the threads run
+TEST(ErrorTest, SinksMergeDeterministically){
+	const int threads = 4, per_thread = 100;
+	std::vector<ErrorSink> sinks(threads);
+	std::vector<std::thread> workers;
+	for(int t = 0; t < threads; t++){
+		workers.emplace_back([&sinks, t]() {
+			ErrorSinkScope scope(sinks[t]);
+			for(int i = per_thread; i > 0; i--){
+				uint32_t id = InternFileName(i % 2 ? "error_test_y.syn" : "error_test_x.syn");
+				PushError(ErrMsg{ ILLEGAL_DEFINITION, Error_Message[ILLEGAL_DEFINITION], id,
+					static_cast<size_t>(i), static_cast<size_t>(t) });
+			}
+		});
+	}
+	for(auto& w : workers) w.join();
+
+	size_t errors = GetAllErrors().size();
+	for(auto& sink : sinks){
+		EXPECT_EQ(sink.errors.size(), static_cast<size_t>(per_thread));
+		MergeErrors(sink);
+		EXPECT_TRUE(sink.errors.empty());
+	}
+	std::vector<ErrMsg>& allerr = GetAllErrors();
+	ASSERT_EQ(allerr.size(), errors + threads * per_thread);
+	for(int t = 0; t < threads; t++){
+		for(int i = 0; i < per_thread; i++){
+			const ErrMsg& e = allerr[errors + t * per_thread + i];
+			EXPECT_EQ(e.colNum, static_cast<size_t>(t));
+			//the half of x first, then the half of y, both ascending by line
+			bool in_x = i < per_thread / 2;
+			EXPECT_EQ(FileNameOf(e.fileId), in_x ? "error_test_x.syn" : "error_test_y.syn");
+			EXPECT_EQ(e.lineNum, static_cast<size_t>(in_x ? 2 * (i + 1) : 2 * (i - per_thread / 2) + 1));
+		}
+	}
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -1,83 +1,230 @@
-#if 0
+#include <cstdlib>
 #include <iostream>
 #include <memory>
-#include <algorithm>
-#include "rgeanalyzier.h"
+#include <string>
+#include <vector>
 #include "error.h"
+#include "rgeanalyzier.h"
+#include "idstatebuilder.h"
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "utility/file_reader.h"
+#include "utility/utility_internal.h"
+
+/* Runs the selected stages of the pipeline, for example:
+ *     qcompiler --rge=domain.rge --grammar=grammar.syn --format=ast sentence.stn
+ * Every non-empty line of a sentence file is a sentence. Nothing is written but the requested output:
+ * the Graphviz files only with --gv-*, and the tables only with --print-grammar.
+ * Exits with 1 if an input cannot be read, the grammar is not LL(1) or any sentence is rejected.
+ * --help(or -h) prints the usage and exits with 0.
+ */
+
+struct CliOptions {
+	std::string rge;
+	std::string grammar;
+	std::vector<std::string> sentences;
+	bool elimLeftRecur{ true };
+	bool leftFactoring{ true };
+	std::string format{ "summary" };
+	std::string reader{ "QFileReader" };
+	bool printGrammar{ false };
+	bool help{ false };
+	std::string parseGraph;
+	std::string nfaGraph;
+	std::string dfaGraph;
+};
+
+static void Usage(std::ostream& out){
+	out << "usage: qcompiler [options] [sentence files]" << std::endl
+		<< "  --rge=FILE             analyse the lexical rules" << std::endl
+		<< "  --grammar=FILE         grammar to parse the sentences with" << std::endl
+		<< "  --stages=LIST          grammar transformations, comma separated elim-left-recursion and" << std::endl
+		<< "                         left-factoring, or none(elim-left-recursion,left-factoring)" << std::endl
+		<< "  --format=FORMAT        output of every sentence: summary, tree(parse tree), ast(compacted tree)" << std::endl
+		<< "                         or none(summary)" << std::endl
+		<< "  --reader=NAME          file reader of the inputs(QFileReader)" << std::endl
+		<< "  --print-grammar        print the transformed grammar and its tables" << std::endl
+		<< "  --gv-parse=FILE        Graphviz of the parse trees, FILE.N for the Nth sentence if there are several" << std::endl
+		<< "  --gv-nfa=FILE          Graphviz of the states built from the ID definition" << std::endl
+		<< "  --gv-dfa=FILE          Graphviz of the DFA of the ID definition" << std::endl
+		<< "  -h, --help             print this usage" << std::endl;
+}
 
-using namespace std;
-
-int main()
-{
-	unique_ptr<RgeAnalyzier> analyzier(std::move(CreateRgeAnalyzier("QRgeAnalyzier")));
-	if (!analyzier || !analyzier->OpenFile("domain.rge")) {
-		cout << "Error in open file" << endl;
-		exit(1);
+static bool ParseStages(const std::string& list, CliOptions& options){
+	options.elimLeftRecur = options.leftFactoring = false;
+	if(list == "none") return true;
+	size_t beg = 0;
+	while(beg <= list.size()){
+		size_t end = list.find(',', beg);
+		if(end == std::string::npos) end = list.size();
+		std::string stage = list.substr(beg, end - beg);
+		if(stage == "elim-left-recursion") options.elimLeftRecur = true;
+		else if(stage == "left-factoring") options.leftFactoring = true;
+		else return false;
+		beg = end + 1;
 	}
-	RGEDomainSpecific* domain = analyzier->RgeAnalyse();
-
-	if(!PrintAllErrors())
-		domain->DisplayRGEDomainSpecific();
-
-	return 0;
+	return true;
 }
-#endif
-
-#if 0
-#include "syntax/grammar_generator_factory.h"
-#include "syntax_specific.h"
 
-int main(){
-	std::unique_ptr<GrammarGenerator> gen = CreateGrammarGenerator("QGrammarGeneratorFactory");
-	gen->OpenFile("grammar.syn");
-
-	ContextFreeGrammar gram = gen->GrammarGenerate();
-	gram.PrintGrammar();
+static bool ParseArgs(int argc, char* argv[], CliOptions& options){
+	for(int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+		if(arg == "--help" || arg == "-h") { options.help = true; return true; }
+		if(arg.compare(0, 2, "--") != 0) { options.sentences.push_back(arg); continue; }
+		if(arg == "--print-grammar") { options.printGrammar = true; continue; }
+		auto pos = arg.find('=');
+		if(pos == std::string::npos) return false;
+		std::string name = arg.substr(2, pos - 2), value = arg.substr(pos + 1);
+
+		if(name == "rge") options.rge = value;
+		else if(name == "grammar") options.grammar = value;
+		else if(name == "stages") { if(!ParseStages(value, options)) return false; }
+		else if(name == "format") {
+			if(value != "summary" && value != "tree" && value != "ast" && value != "none") return false;
+			options.format = value;
+		}
+		else if(name == "reader") options.reader = value;
+		else if(name == "gv-parse") options.parseGraph = value;
+		else if(name == "gv-nfa") options.nfaGraph = value;
+		else if(name == "gv-dfa") options.dfaGraph = value;
+		else return false;
+	}
+	//the outputs need their stages, and there should be something to do
+	if((!options.sentences.empty() || !options.parseGraph.empty() || options.printGrammar) && options.grammar.empty())
+		return false;
+	if((!options.nfaGraph.empty() || !options.dfaGraph.empty()) && options.rge.empty()) return false;
+	return !options.rge.empty() || !options.grammar.empty();
+}
 
-	gram.ElimLeftRecur();
+static bool AnalyseRge(const CliOptions& options){
+	std::unique_ptr<RgeAnalyzier> analyzier = CreateRgeAnalyzier("QRgeAnalyzier");
+	if(!analyzier->SetFileReader(options.reader) || !analyzier->OpenFile(options.rge)){
+		std::cerr << "cannot open " << options.rge << std::endl;
+		return false;
+	}
+	analyzier->RgeAnalyse();
 
-	//gram.PrintGrammar();
+	bool ok = true;
+	IDStateBuilder* builder = analyzier->GetIDStateBuilder();
+	if((!options.nfaGraph.empty() || !options.dfaGraph.empty()) && !builder){
+		std::cerr << options.rge << " has no ID definition" << std::endl;
+		return false;
+	}
+	if(!options.nfaGraph.empty() && !builder->GenerateGraphvz(options.nfaGraph)){
+		std::cerr << "cannot write " << options.nfaGraph << std::endl;
+		ok = false;
+	}
+	if(!options.dfaGraph.empty()){
+		std::shared_ptr<DFA> dfa = builder->GenerateDFA();
+		if(!dfa || !GenerateDFAGraphvz(*dfa, options.dfaGraph)){
+			std::cerr << "cannot write " << options.dfaGraph << std::endl;
+			ok = false;
+		}
+	}
+	return ok;
+}
 
-	//gram.GetFirstTable();
-	//gram.GetFollowTable();
-	
-	gram.PrintGrammar();
+//preorder from an explicit stack, the compact tree of a long sentence is as deep as the sentence
+static void WriteTree(const SyntaxNode* root, int depth){
+	std::vector<std::pair<const SyntaxNode*, int>> stack{ { root, depth } };
+	while(!stack.empty()){
+		const SyntaxNode* node = stack.back().first;
+		const int d = stack.back().second;
+		stack.pop_back();
+		std::cout << std::string(2 * d, ' ') << node->term << '\n';
+		for(auto it = node->children.rbegin(); it != node->children.rend(); ++it) stack.emplace_back(it->get(), d + 1);
+	}
+}
 
-	return 0;
+//FILE for the only sentence, FILE.N for the Nth one of several
+static std::string GraphFile(const std::string& file, size_t index, size_t count){
+	return count == 1 ? file : file + "." + intToString(static_cast<int>(index + 1));
 }
-#endif
 
-#if 1
-#include "syntax/grammar_generator_factory.h"
-#include "syntax_specific.h"
+struct InputSentence {
+	std::string file;
+	size_t line;
+	CompiledGrammar::Sentence tokens;
+};
+
+static bool ReadSentences(const CliOptions& options, std::vector<InputSentence>& sentences){
+	bool ok = true;
+	for(const auto& file : options.sentences){
+		std::unique_ptr<FileReader> reader = CreateFileReader(options.reader);
+		if(!reader || !reader->OpenFile(file)){
+			std::cerr << "cannot open " << file << std::endl;
+			ok = false;
+			continue;
+		}
+		while(!reader->IsFileEnd()){
+			InputSentence sen{ file, reader->LineNumber(), CompiledGrammar::Sentence() };
+			SplitTokens(reader->ReadLine(), sen.tokens);
+			if(!sen.tokens.empty()) sentences.push_back(std::move(sen));
+		}
+	}
+	return ok;
+}
 
-int main() {
+static bool ParseSentences(const CliOptions& options){
 	std::unique_ptr<GrammarGenerator> gen = CreateGrammarGenerator("QGrammarGeneratorFactory");
-	gen->OpenFile("grammar.syn");
-
-	ContextFreeGrammar gram = gen->GrammarGenerate();
-	//gram.PrintGrammar();
-
-	gram.ElimLeftRecur();
-
-	//gram.PrintGrammar();
-	//gram.LeftFactoring();
-	gram.GetFirstTable();
-	gram.GetFollowTable();
-	gram.GetSelectTable();
-	gram.ConstructLL1Table();
-
-	std::unique_ptr<SentenceReader> reader = CreateSentenceReader("QSentenceReader");
-	std::vector<std::string> vec = reader->ReadFile("sentence.stn");
-	std::cout << "Sentence read from file:" << std::endl;
-	for (const auto& t : vec) std::cout << t << " ";
-	std::cout << std::endl;
-
-	std::unique_ptr<SyntaxTree> tree = gram.LL1Parsing(vec);
-	tree->GenerateGraphvz();
+	if(!gen->SetFileReader(options.reader) || !gen->OpenFile(options.grammar)){
+		std::cerr << "cannot open " << options.grammar << std::endl;
+		return false;
+	}
+	//ll1table points to the productions, the grammar is not moved after the table is constructed
+	std::unique_ptr<ContextFreeGrammar> gram(new ContextFreeGrammar(gen->GrammarGenerate()));
+	if(options.elimLeftRecur) gram->ElimLeftRecur();
+	if(options.leftFactoring) gram->LeftFactoring();
+	gram->GetFirstTable();
+	gram->GetFollowTable();
+	gram->GetSelectTable();
+	bool conflict = gram->ConstructLL1Table();
+	if(options.printGrammar) gram->PrintGrammar();
+	if(conflict){
+		std::cerr << options.grammar << " is not LL(1)" << std::endl;
+		return false;
+	}
+	CompiledGrammar compiled(*gram);
+
+	std::vector<InputSentence> sentences;
+	bool ok = ReadSentences(options, sentences);
+	size_t accepted = 0;
+	for(size_t i = 0; i < sentences.size(); i++){
+		const InputSentence& sen = sentences[i];
+		std::unique_ptr<SyntaxTree> tree = compiled.Parse(sen.tokens);
+		if(tree->IsAccepted()) accepted++;
+		if(!options.parseGraph.empty() && !tree->GenerateGraphvz(GraphFile(options.parseGraph, i, sentences.size()))){
+			std::cerr << "cannot write " << GraphFile(options.parseGraph, i, sentences.size()) << std::endl;
+			ok = false;
+		}
+		if(options.format == "none") continue;
+
+		std::cout << sen.file << ":" << sen.line << ": " << (tree->IsAccepted() ? "accepted" : "rejected") << std::endl;
+		for(const auto& d : tree->diagnostics)
+			std::cout << "  token " << d.position << ": unexpected '" << d.token << "', expected " << d.expected << std::endl;
+		if(!tree->IsAccepted() || options.format == "summary") continue;
+		if(options.format == "ast") tree->Compact(compiled.InnerPrefix());
+		for(const auto& child : tree->GetHead()->children) WriteTree(child.get(), 1);
+	}
+	if(options.format != "none" && !sentences.empty())
+		std::cout << accepted << "/" << sentences.size() << " sentences accepted" << std::endl;
+	return ok && accepted == sentences.size();
+}
 
-	//gram.PrintGrammar();
+int main(int argc, char* argv[]){
+	CliOptions options;
+	if(!ParseArgs(argc, argv, options)){
+		Usage(std::cerr);
+		return 1;
+	}
+	if(options.help){
+		Usage(std::cout);
+		return 0;
+	}
 
-	return 0;
+	bool ok = true;
+	if(!options.rge.empty()) ok = AnalyseRge(options) && ok;
+	if(!options.grammar.empty()) ok = ParseSentences(options) && ok;
+	if(PrintAllErrors()) ok = false;
+	return ok ? 0 : 1;
 }
-#endif
\ No newline at end of file
@@ -1,12 +1,16 @@
 
 #include <algorithm>
+#include <atomic>
+#include <fstream>
 #include <sstream>
 #include "idstatebuilder.h"
 #include "q_idstatebuilder.h"
+#include "utility/utility_internal.h"
 
+//languages can be loaded on several threads at once, see Language::LoadAll()
 static int StateNodeIDCounter(){
-	static int counter = 0;
-	return counter++;
+	static std::atomic<int> counter{ 0 };
+	return counter.fetch_add(1, std::memory_order_relaxed);
 }
 
 StateNode::StateNode() : stateNum_(StateNodeIDCounter()){
@@ -72,3 +76,22 @@ void StateNode::_addJudge(std::shared_ptr<Judgement> judge, std::shared_ptr<Stat
 	judges_.insert(make_pair(judge->JudgeStr(), p));
 }
 
+bool GenerateDFAGraphvz(const DFA& dfa, const std::string& filename) {
+	std::ofstream outfile(filename);
+	if(!outfile) return false;
+	outfile << "digraph G {" << std::endl; //use 'strict' can  remove duplicate edges
+	outfile << "node[shape = circle]" << std::endl;
+
+	for(size_t ind = 0; ind < dfa.isTerminal_.size(); ind++){
+		if(dfa.isTerminal_[ind]) outfile << intToString(static_cast<int>(ind)) + "[shape = doublecircle]" << std::endl;
+	}
+
+	for(size_t ind = 0; ind < dfa.table_.size(); ind++){
+		std::string str_from = intToString(static_cast<int>(ind));
+		for(const auto& transfer : dfa.table_[ind])
+			outfile << str_from + "->" + intToString(transfer.second) + "[label = \"" + transfer.first + "\"]" << std::endl;
+	}
+
+	outfile << "}" << std::endl;
+	return static_cast<bool>(outfile);
+}
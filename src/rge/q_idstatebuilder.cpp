@@ -10,6 +10,9 @@
 #include "q_idstatebuilder.h"
 #include "idstatebuilder_factory.h"
 #include "utility/utility_internal.h"
+#include "utility/trace.h"
+#include "alloc_stats.h"
+#include "perf_counters.h"
 
 const char STATE_CONNECT = '_';
 
@@ -384,6 +387,9 @@ void QIDStateBuilder::_handleSpawnStates(std::tuple<std::shared_ptr<StateNode>,
  * more convient for generating the DFA.
  */
 void QIDStateBuilder::_stateSpawn(){
+	QC_TRACE_SCOPE("_stateSpawn");
+	QC_STAGE("_stateSpawn");
+	QC_PERF_STAGE("_stateSpawn");
 	std::set<std::string> alledges;
 	std::map<std::string, std::tuple<std::shared_ptr<StateNode>, std::string, std::shared_ptr<StateNode>>> edgetable;
 	std::set<std::shared_ptr<StateNode>> nodeset;
@@ -417,39 +423,10 @@ void QIDStateBuilder::_stateSpawn(){
 	}
 }
 
-void QIDStateBuilder::_generateDFAGraphvz(std::shared_ptr<DFA> dfa) const {
-	std::ofstream outfile("dfagraph.gv"); //check outfile here
-	if(!outfile){
-		assert(0);
-	}
-	/*outfile << "strict ";*/ //use 'strict' can  remove duplicate edges
-	outfile << "digraph G {" << std::endl; //use 'strict' can  remove duplicate edges
-	outfile << "node[shape = circle]" << std::endl;
-
-	for(int ind = 0; ind < dfa->isTerminal_.size(); ind++){
-		if(dfa->isTerminal_[ind]){
-			std::string node = intToString(ind);
-			std::string str = node + "[shape = doublecircle]";
-			outfile << str << std::endl;
-		}
-	}
-
-	for(int ind = 0; ind < dfa->table_.size(); ind++){
-		auto& mp = dfa->table_[ind];
-		std::string str_from = intToString(ind);
-		for(auto iter = mp.begin(); iter != mp.end(); iter++){
-			char c = iter->first;
-			int to = iter->second;
-			std::string str = str_from + "->" + intToString(to) + "[label = \"" + c + "\"]";
-			outfile << str << std::endl;
-		}
-	}
-
-	outfile << "}" << std::endl;
-	outfile.close();
-}
- 
 std::shared_ptr<DFA> QIDStateBuilder::GenerateDFA(){
+	QC_TRACE_SCOPE("GenerateDFA");
+	QC_STAGE("GenerateDFA");
+	QC_PERF_STAGE("GenerateDFA");
 	std::map<std::string, std::set<std::string>> newstate_oldstates;
 	std::set<std::string> unvisit_newstate;
 	std::map<std::string, int> newstate_index;
@@ -539,19 +516,20 @@ void QIDStateBuilder::_generateGraphvz(std::ofstream& outfile) const {
 	}
 }
 
-void QIDStateBuilder::GenerateGraphvz(std::string filename) const {
-	std::ofstream outfile(filename); //check outfile here
-	if(!outfile){
-		assert(0);
-	}
+bool QIDStateBuilder::GenerateGraphvz(std::string filename) const {
+	std::ofstream outfile(filename);
+	if(!outfile || !rootState_) return false;
 	outfile << "digraph G {" << std::endl;
 	outfile << "node[shape = circle]" << std::endl;
 	_generateGraphvz(outfile);
 	outfile << "}" << std::endl;
-	outfile.close();
+	return static_cast<bool>(outfile);
 }
 
 void QIDStateBuilder::BuildIDState(const std::string& str) {
+	QC_TRACE_SCOPE("BuildIDState");
+	QC_STAGE("BuildIDState");
+	QC_PERF_STAGE("BuildIDState");
 	const char* ptr = str.c_str();
 
 	rootState_.reset(new StateNode); //StateNum_ is 0
@@ -559,9 +537,6 @@ void QIDStateBuilder::BuildIDState(const std::string& str) {
 	_recurStateBuild(rootState_, rootState_, CONNECTION_TYPE::CONN_SERIAL, &ptr);
 	_stateSpawn();//stateTable_ will be set
 	_setStateTerminal();
-	
-	std::shared_ptr<DFA> dfa = GenerateDFA();
-	_generateDFAGraphvz(dfa);
 }
 
 
@@ -80,7 +80,7 @@ class QIDStateBuilder : public IDStateBuilder {
 public:
 	void BuildIDState(const std::string& str) override;
 
-	void GenerateGraphvz(std::string filename) const override;
+	bool GenerateGraphvz(std::string filename) const override;
 
 	std::shared_ptr<DFA> GenerateDFA() override;
 
@@ -92,8 +92,6 @@ private:
 
 	void _generateGraphvz(std::ofstream& outfile) const;
 
-	void _generateDFAGraphvz(std::shared_ptr<DFA> p) const;
-
 	std::vector<std::pair<std::shared_ptr<Judgement>, std::shared_ptr<StateNode>>>
 	_handleXToY(const std::string& judge, std::shared_ptr<StateNode>& ptr);
 
@@ -1,5 +1,4 @@
 
-#include <iostream>
 #include <fstream>
 #include <memory>
 #include <stack>
@@ -13,27 +12,27 @@
 #include "q_idstatebuilder.h"
 #include "factory_template.h"
 #include "utility/file_reader.h"
-#include "utility/file_reader_factory.h"
-#include "utility/q_file_reader.h"
 #include "utility/utility_internal.h"
+#include "utility/trace.h"
+#include "alloc_stats.h"
+#include "perf_counters.h"
 
 class QRgeAnalyzier final : public RgeAnalyzier {
 public:
-	QRgeAnalyzier() : fileReader_(nullptr), domain_(new RGEDomainSpecific), idbuilder_(nullptr){
-		FileReaderFactory *filereader_factory = FileReaderFactoryRegistry::GetFactory("QFileReader");
-		FileReader *reader = filereader_factory->CreateFileReader().release();
-		QFileReader *qreader = dynamic_cast<QFileReader*>(reader);
-		fileReader_.reset(qreader);
-		
+	QRgeAnalyzier() : fileReader_(CreateFileReader("QFileReader")), domain_(new RGEDomainSpecific), idbuilder_(nullptr){
 		IDStateBuilderFactory *factory = IDStateBuilderFactoryRegistry::GetFactory("QIDStateBuilderFactory");
 		idbuilder_.reset(factory->CreateIDStateBuilder().release());
 	}
 
 	bool OpenFile(const std::string& filepath);
+	bool SetFileReader(const std::string& name) override {
+		std::unique_ptr<FileReader> reader = CreateFileReader(name);
+		if(!reader) return false;
+		fileReader_ = std::move(reader);
+		return true;
+	}
 	RGEDomainSpecific* RgeAnalyse();
-
-	//Should be removed ?
-	void show_file() { 	while (!fileReader_->IsFileEnd())	std::cout << fileReader_->NextChar(); }
+	IDStateBuilder* GetIDStateBuilder() override { return idBuilt_ ? idbuilder_.get() : nullptr; }
 
 private:
 	/* There are also comments in regular expression file, this has nothing to do with the
@@ -57,9 +56,10 @@ private:
 		while (!fileReader_->IsFileEnd() && fileReader_->NextChar() != c);
 	}
 
-	std::unique_ptr<QFileReader> fileReader_;
+	std::unique_ptr<FileReader> fileReader_;
 	std::unique_ptr<RGEDomainSpecific> domain_;
 	std::unique_ptr<IDStateBuilder> idbuilder_;
+	bool idBuilt_{ false };
 };
 
 bool QRgeAnalyzier::OpenFile(const std::string& filepath){
@@ -67,6 +67,9 @@ bool QRgeAnalyzier::OpenFile(const std::string& filepath){
 }
 
 RGEDomainSpecific* QRgeAnalyzier::RgeAnalyse() {
+	QC_TRACE_SCOPE("RgeAnalyse");
+	QC_STAGE("RgeAnalyse");
+	QC_PERF_STAGE("RgeAnalyse");
 	fileReader_->ReadToBuffer();
 
 	while (!fileReader_->IsFileEnd())
@@ -82,38 +85,24 @@ RGEDomainSpecific* QRgeAnalyzier::RgeAnalyse() {
 			|| fileReader_->CurrentChar() == RgeularSemantics::MUL_COM_BEGIN) {
 			_consumeComment();
 		}
+		//a definition which fails has pushed its error message
 		else if (fileReader_->CurrentChar() == RgeularSemantics::KEYWORDS[0]) {
-			if (!_domainExtract(RGEDefinition_Type::KEYWORDS))
-				std::cout << "Error in keywords" << std::endl;
-			else
-				std::cout << "Keywords OK" << std::endl;
+			_domainExtract(RGEDefinition_Type::KEYWORDS);
 		}
 		else if (fileReader_->CurrentChar() == RgeularSemantics::SYMBOLS[0]) {
-			if (!_domainExtract(RGEDefinition_Type::SYMBOLS))
-				std::cout << "Error in symbols" << std::endl;
-			else
-				std::cout << "symbols OK" << std::endl;
+			_domainExtract(RGEDefinition_Type::SYMBOLS);
 		}
 		else if (fileReader_->CurrentChar() == RgeularSemantics::OPERATORS[0]) {
-			if (!_domainExtract(RGEDefinition_Type::OPERATORS))
-				std::cout << "Error in operators" << std::endl;
-			else
-				std::cout << "operators OK" << std::endl;
+			_domainExtract(RGEDefinition_Type::OPERATORS);
 		}
 		else if (fileReader_->CurrentChar() == RgeularSemantics::DATATYPES[0]) {
-			if (!_domainExtract(RGEDefinition_Type::DATATYPE))
-				std::cout << "Error in datatypes" << std::endl;
-			else
-				std::cout << "datatypes OK" << std::endl;
+			_domainExtract(RGEDefinition_Type::DATATYPE);
 		}
 		else if (fileReader_->CurrentChar() == RgeularSemantics::ID[0]) {
-			if (!_domainExtract(RGEDefinition_Type::ID))
-				std::cout << "Error in ID " << std::endl;
-			else
-				std::cout << "ID OK" << std::endl;
+			_domainExtract(RGEDefinition_Type::ID);
 		}
 		else //error skip
-			std::cout << fileReader_->NextChar();
+			fileReader_->NextChar();
 	}
 	return domain_.get();
 }
@@ -170,7 +159,7 @@ bool QRgeAnalyzier::_domainExtract(RGEDefinition_Type type) {
 			if (_checkID(substr)) {
 				_setDomainContent(substr, type);
 				idbuilder_->BuildIDState(substr);
-				idbuilder_->GenerateGraphvz("graph.gv");
+				idBuilt_ = true;
 				return true;
 			}
 			else {
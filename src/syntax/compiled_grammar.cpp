@@ -0,0 +1,219 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <map>
+#include "compiled_grammar.h"
+#include "utility/trace.h"
+#include "alloc_stats.h"
+#include "perf_counters.h"
+#include "parser_stats.h"
+
+const CompiledGrammar::SymbolId CompiledGrammar::InvalidSymbol;
+const int CompiledGrammar::NoRule;
+
+static uint64_t _nextVersion(){
+	static std::atomic<uint64_t> version{ 0 };
+	return ++version;
+}
+
+CompiledGrammar::CompiledGrammar(const ContextFreeGrammar& grammar) : innerPrefix_(grammar.nameGenerator.prefix),
+						version_(_nextVersion()){
+	QC_TRACE_SCOPE("CompiledGrammar");
+	QC_STAGE("CompiledGrammar");
+	QC_PERF_STAGE("CompiledGrammar");
+	for(const auto& t : grammar.terminals) _intern(t);
+	finish_ = _intern(ContextFreeGrammar::Finish);
+	epsilon_ = _intern(ContextFreeGrammar::Epsilon);
+	for(const auto& nt : grammar.nonTerminals) _intern(nt);
+	start_ = _intern(grammar.startSymbol);
+
+	std::map<const ContextFreeGrammar::Production*, int> rule_index;
+	for(auto iter = grammar.productions.begin(); iter != grammar.productions.end(); iter++){
+		Rule rule;
+		rule.lhs = _intern(iter->first);
+		for(const auto& t : iter->second) rule.rhs.push_back(_intern(t));
+		rule_index.insert(std::make_pair(&*iter, static_cast<int>(rules_.size())));
+		rules_.push_back(std::move(rule));
+	}
+
+	//all the terms have been interned, the table size is fixed now
+	columns_ = finish_ + 1;
+	table_.assign((names_.size() - epsilon_ - 1) * columns_, NoRule);
+	sync_.assign(table_.size(), false);
+	for(const auto& f : grammar.follow){
+		SymbolId non_term = FindSymbol(f.first);
+		if(!IsNonTerminal(non_term)) continue;
+		for(const auto& t : f.second){
+			SymbolId termi = FindSymbol(t);
+			if(termi >= 0 && termi <= finish_) sync_[(non_term - epsilon_ - 1) * columns_ + termi] = true;
+		}
+	}
+	for(auto iter = grammar.ll1table.begin(); iter != grammar.ll1table.end(); iter++){
+		SymbolId non_term = FindSymbol(iter->first);
+		for(const auto& entry : iter->second){
+			SymbolId termi = FindSymbol(entry.first);
+			auto iter2 = rule_index.find(entry.second);
+			if(!IsNonTerminal(non_term) || termi < 0 || termi > finish_ || iter2 == rule_index.end()) continue;
+			table_[(non_term - epsilon_ - 1) * columns_ + termi] = iter2->second;
+		}
+	}
+}
+
+CompiledGrammar::SymbolId CompiledGrammar::_intern(const std::string& term){
+	auto iter = ids_.find(term);
+	if(iter != ids_.end()) return iter->second;
+
+	SymbolId id = static_cast<SymbolId>(names_.size());
+	names_.push_back(term);
+	ids_.insert(std::make_pair(term, id));
+	return id;
+}
+
+CompiledGrammar::SymbolId CompiledGrammar::FindSymbol(const std::string& term) const {
+	auto iter = ids_.find(term);
+	if(iter == ids_.end()) return InvalidSymbol;
+	else return iter->second;
+}
+
+std::unique_ptr<SyntaxTree> CompiledGrammar::Parse(const Sentence& sentence) const {
+	size_t ind = 0;
+	std::unique_ptr<SyntaxTree> tree = Parse([this, &sentence, &ind](SymbolId& id) {
+		if(ind >= sentence.size()) return false;
+		id = FindSymbol(sentence[ind++]);
+		return true;
+	});
+
+	//unknown terms have no names in the grammar, take them back from the sentence
+	for(auto& d : tree->diagnostics)
+		if(d.position < sentence.size()) d.token = sentence[d.position];
+	return tree;
+}
+
+/* Same table driven algorithm as ContextFreeGrammar::LL1Parsing, and builds the same syntax tree. The
+ * difference is that all the lookups are done by ids. Errors are recovered in the same panic mode as
+ * LL1Parsing, see the comments there.
+ */
+std::unique_ptr<SyntaxTree> CompiledGrammar::Parse(const TokenSource& next) const {
+	QC_TRACE_SCOPE("CompiledGrammar::Parse");
+	QC_STAGE("CompiledGrammar::Parse");
+	QC_PERF_STAGE("CompiledGrammar::Parse");
+	using StackItem = std::pair<SyntaxNode*, SymbolId>;
+	std::vector<StackItem> st;
+	std::unique_ptr<SyntaxTree> tree(new SyntaxTree);
+
+	SymbolId look = InvalidSymbol;
+	if(!next(look)) return tree; //null syntax tree, the same as LL1Parsing
+
+	SyntaxNode* head = tree->GetHead();
+	head->addChild(names_[start_], SyntaxNode::NONTERMINAL);
+	tree->CountIncrease();
+	head->addChild(names_[finish_], SyntaxNode::FINISH);
+	tree->CountIncrease();
+	st.push_back(std::make_pair(head->getChild(1), finish_));
+	st.push_back(std::make_pair(head->getChild(0), start_));
+
+	size_t pos = 0;
+	bool input_end = false, finished = false;
+	QC_PARSER_STATS(ParserStatsSlot& stats = ParserStatsSlot::Current());
+	QC_PARSER_STATS(auto stats_begin = std::chrono::steady_clock::now());
+
+	while(!st.empty()){
+		StackItem item = st.back();
+		st.pop_back();
+		if(item.second == epsilon_) { QC_PARSER_STATS(stats.epsilonPops++); continue; }
+
+		if(item.second == look && (IsTerminal(look) || input_end)){ //a token named '$' is not the end of input
+			if(look == finish_) { finished = true; break; }
+			pos++;
+			if(!next(look)) look = finish_, input_end = true;
+			continue;
+		}
+
+		int r = IsNonTerminal(item.second) ? Predict(item.second, look) : NoRule;
+		QC_PARSER_STATS(if(IsNonTerminal(item.second)) stats.lookups++);
+		if(r == NoRule){
+			const std::string& token = look == InvalidSymbol ? std::string() : names_[look];
+			tree->diagnostics.push_back(ParseDiagnostic{ pos, token, names_[item.second] });
+
+			if(item.second == finish_){ //redundant input after the sentence, drain it
+				while(next(look)) pos++;
+				break;
+			}
+			if(IsTerminal(item.second)) continue; //as if the missing terminal has been inserted
+
+			while(look != finish_ && Predict(item.second, look) == NoRule && !IsSync(item.second, look))
+				if(pos++, !next(look)) look = finish_, input_end = true;
+			if(Predict(item.second, look) != NoRule) st.push_back(item); //synchronized at its start
+			continue;
+		}
+
+		SyntaxNode* cur = item.first;
+		const std::vector<SymbolId>& rhs = rules_[r].rhs;
+		for(auto s : rhs){
+			SyntaxNode::NodeType t = IsTerminal(s) ? SyntaxNode::TERMINAL : SyntaxNode::NONTERMINAL;
+			cur->addChild(names_[s], t);
+			tree->CountIncrease();
+		}
+		for(int i = static_cast<int>(rhs.size()) - 1; i >= 0; i--) //reverse order to stack
+			st.push_back(std::make_pair(cur->getChild(i), rhs[i]));
+		QC_PARSER_STATS(_countExpansion(stats, r, look); stats.StackDepth(st.size()));
+	}
+	QC_PARSER_STATS(stats.parses++; stats.tokens += pos);
+	QC_PARSER_STATS(stats.nanoseconds += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+							std::chrono::steady_clock::now() - stats_begin).count()));
+
+	if(finished && tree->diagnostics.empty()) tree->Accepted();
+	else tree->NotAccepted();
+
+	return tree;
+}
+
+#ifdef QCOMPILER_ENABLE_PARSER_STATS
+//the rules are keyed by their indexes in the version of the grammar, the lookahead by its symbol id
+void CompiledGrammar::_countExpansion(ParserStatsSlot& stats, int rule, SymbolId look) const {
+	const Rule* p = &rules_[rule];
+	auto name = [this, p]() {
+		std::vector<std::string> rhs;
+		for(auto s : p->rhs) rhs.push_back(names_[s]);
+		return ParserStats::ProductionName(names_[p->lhs], rhs);
+	};
+	stats.Expand(version_, static_cast<uint64_t>(rule), name);
+	stats.Cell(version_, static_cast<uint64_t>(rule), static_cast<uint64_t>(look), [this, p, look, &name]() {
+		return "[" + names_[p->lhs] + ", " + names_[look] + "] " + name();
+	});
+}
+#endif
+
+/* Workers take sentences from a shared atomic cursor in small chunks, so long sentences would not
+ * hold back the rest. Each worker only writes its own slots of the result vector, and the grammar is
+ * read only, so there is no lock at all.
+ */
+std::vector<std::unique_ptr<SyntaxTree>> CompiledGrammar::ParseAll(const std::vector<Sentence>& sentences,
+						unsigned threads) const {
+	std::vector<std::unique_ptr<SyntaxTree>> results(sentences.size());
+	const size_t grain = 8;
+
+	if(threads == 0) threads = std::thread::hardware_concurrency();
+	if(threads == 0) threads = 1;
+	size_t max_threads = (sentences.size() + grain - 1) / grain;
+	if(threads > max_threads) threads = static_cast<unsigned>(max_threads);
+
+	std::atomic<size_t> cursor{ 0 };
+	auto worker = [&]() {
+		for(;;){
+			size_t beg = cursor.fetch_add(grain, std::memory_order_relaxed);
+			if(beg >= sentences.size()) break;
+			size_t end = std::min(beg + grain, sentences.size());
+			for(size_t i = beg; i < end; i++) results[i] = Parse(sentences[i]);
+		}
+	};
+
+	if(threads <= 1) { worker(); return results; }
+
+	std::vector<std::thread> pool;
+	for(unsigned i = 1; i < threads; i++) pool.emplace_back(worker);
+	worker(); //current thread works too
+	for(auto& t : pool) t.join();
+
+	return results;
+}
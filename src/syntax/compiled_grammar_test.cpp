@@ -0,0 +1,130 @@
+#include "gtest/gtest.h"
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "syntax/test_grammar.h"
+
+static std::unique_ptr<ContextFreeGrammar> ExpressionGrammar(){
+	return TestGrammar("compiled_grammar_test.syn", { "<S>-><E>", "<E>-><E>+<T>|<E>-<T>|<T>", "<T>-><T>*<F>|<T>/<F>|<F>",
+						"<F>->id|num|(<E>)" });
+}
+
+TEST(CompiledGrammarTest, SameAsLL1Parsing){
+	std::unique_ptr<ContextFreeGrammar> gram = ExpressionGrammar();
+	CompiledGrammar compiled(*gram);
+
+	std::vector<std::string> sen{ "id", "+", "(", "id", "*", "id", "-", "id", ")", "-", "id" };
+	std::unique_ptr<SyntaxTree> expect = gram->LL1Parsing(sen);
+	std::unique_ptr<SyntaxTree> tree = compiled.Parse(sen);
+
+	EXPECT_TRUE(expect->IsAccepted());
+	EXPECT_TRUE(tree->IsAccepted());
+	EXPECT_EQ(expect->counter, tree->counter);
+}
+
+TEST(CompiledGrammarTest, RejectWithDiagnostic){
+	CompiledGrammar compiled(*ExpressionGrammar());
+
+	std::unique_ptr<SyntaxTree> tree = compiled.Parse({ "id", "+", "+", "id" });
+	EXPECT_FALSE(tree->IsAccepted());
+	ASSERT_EQ(tree->diagnostics.size(), 1u);
+	EXPECT_EQ(tree->diagnostics[0].position, 2u);
+}
+
+TEST(CompiledGrammarTest, PanicModeRecovery){
+	std::unique_ptr<ContextFreeGrammar> gram = ExpressionGrammar();
+	CompiledGrammar compiled(*gram);
+
+	//missing ')', a redundant '+' and an unknown term, all of them are reported and parsing goes on
+	std::vector<std::string> sen{ "(", "id", "+", "+", "id", "*", "?", "num", "-", "id" };
+	std::unique_ptr<SyntaxTree> tree = compiled.Parse(sen);
+	std::unique_ptr<SyntaxTree> expect = gram->LL1Parsing(sen);
+
+	EXPECT_FALSE(tree->IsAccepted());
+	EXPECT_FALSE(expect->IsAccepted());
+	ASSERT_EQ(tree->diagnostics.size(), 3u);
+	ASSERT_EQ(expect->diagnostics.size(), 3u);
+	for(size_t i = 0; i < tree->diagnostics.size(); i++){
+		EXPECT_EQ(tree->diagnostics[i].position, expect->diagnostics[i].position);
+		EXPECT_EQ(tree->diagnostics[i].token, expect->diagnostics[i].token);
+	}
+	EXPECT_EQ(tree->diagnostics[0].position, 3u);
+	EXPECT_EQ(tree->diagnostics[1].token, "?");
+	EXPECT_EQ(tree->diagnostics[2].token, "$");
+	EXPECT_EQ(tree->counter, expect->counter);
+}
+
+TEST(CompiledGrammarTest, PullTokens){
+	std::unique_ptr<ContextFreeGrammar> gram = ExpressionGrammar();
+	CompiledGrammar compiled(*gram);
+
+	std::vector<std::string> sen{ "(", "id", "+", "num", ")", "*", "id" };
+	std::vector<CompiledGrammar::SymbolId> ids;
+	for(const auto& t : sen) ids.push_back(compiled.FindSymbol(t));
+
+	std::unique_ptr<SyntaxTree> tree = compiled.Parse(ids.begin(), ids.end());
+	EXPECT_TRUE(tree->IsAccepted());
+	EXPECT_EQ(tree->counter, gram->LL1Parsing(sen)->counter);
+
+	size_t ind = 0;
+	tree = gram->LL1Parsing([&sen, &ind](std::string& term) {
+		if(ind >= sen.size()) return false;
+		term = sen[ind++];
+		return true;
+	});
+	EXPECT_TRUE(tree->IsAccepted());
+
+	//'$' in the input is not the end of input, nor is a token named like a nonterminal a nonterminal
+	for(const std::vector<std::string>& wrong : { std::vector<std::string>{ "id", "$" },
+			std::vector<std::string>{ "id", "$", "+", "id" }, std::vector<std::string>{ "(", "E", ")" } }){
+		std::unique_ptr<SyntaxTree> expect = gram->LL1Parsing(wrong);
+		EXPECT_FALSE(expect->IsAccepted());
+		ASSERT_FALSE(expect->diagnostics.empty());
+		EXPECT_EQ(expect->diagnostics[0].token, wrong[1]);
+		tree = compiled.Parse(wrong);
+		EXPECT_EQ(tree->counter, expect->counter);
+		ASSERT_EQ(tree->diagnostics.size(), expect->diagnostics.size());
+		EXPECT_EQ(tree->diagnostics[0].position, expect->diagnostics[0].position);
+	}
+}
+
+TEST(CompiledGrammarTest, CompactTree){
+	std::unique_ptr<ContextFreeGrammar> gram = ExpressionGrammar();
+	CompiledGrammar compiled(*gram);
+
+	std::unique_ptr<SyntaxTree> tree = compiled.Parse({ "id", "-", "num", "-", "id", "*", "id" });
+	int full = tree->counter;
+	tree->Compact(compiled.InnerPrefix());
+	EXPECT_LT(tree->counter * 2, full);
+
+	//-(-(id, num), *(id, id))
+	SyntaxNode* root = tree->GetHead()->getChild(0);
+	ASSERT_NE(root, nullptr);
+	EXPECT_EQ(root->getTerm(), "-");
+	ASSERT_EQ(root->children.size(), 2u);
+	EXPECT_EQ(root->getChild(0)->getTerm(), "-");
+	EXPECT_EQ(root->getChild(0)->getChild(1)->getTerm(), "num");
+	EXPECT_EQ(root->getChild(1)->getTerm(), "*");
+	EXPECT_EQ(root->getChild(1)->getChild(0)->getTerm(), "id");
+	EXPECT_EQ(tree->counter, 8);
+}
+
+TEST(CompiledGrammarTest, ParseAll){
+	CompiledGrammar compiled(*ExpressionGrammar());
+
+	std::vector<CompiledGrammar::Sentence> sentences;
+	for(int i = 0; i < 1000; i++){
+		if(i % 3 == 0) sentences.push_back({ "id", "*", "(", "num", "+", "id", ")" });
+		else if(i % 3 == 1) sentences.push_back({ "id", "id" });
+		else sentences.push_back({ "num" });
+	}
+
+	std::vector<std::unique_ptr<SyntaxTree>> trees = compiled.ParseAll(sentences, 4);
+	ASSERT_EQ(trees.size(), sentences.size());
+	for(size_t i = 0; i < trees.size(); i++)
+		EXPECT_EQ(trees[i]->IsAccepted(), i % 3 != 1);
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -1,9 +1,14 @@
 
 #include <cassert>
+#include <chrono>
 #include <stack>
 #include <fstream>
 #include "syntax_specific.h"
 #include "utility/utility_internal.h"
+#include "utility/trace.h"
+#include "alloc_stats.h"
+#include "perf_counters.h"
+#include "parser_stats.h"
 
 const std::string ContextFreeGrammar::Epsilon = std::string(1, SyntaxSemantics::EPSILON);
 const std::string ContextFreeGrammar::Finish = std::string(1, SyntaxSemantics::FINISH);
@@ -113,6 +118,9 @@ bool ContextFreeGrammar::_isNullable(const std::string& term) const {
  * In this case, First[A] has '#', because both B and C are nullable.
  */
 void ContextFreeGrammar::GetFirstTable(){
+	QC_TRACE_SCOPE("GetFirstTable");
+	QC_STAGE("GetFirstTable");
+	QC_PERF_STAGE("GetFirstTable");
 	for(const auto& Z : terminals) first[Z].insert(Z); //for terminal Z, first[Z] = {Z}
 
 	bool fir_mod = false, nul_mod = false;
@@ -148,6 +156,9 @@ void ContextFreeGrammar::GetFirstTable(){
  * once there is no really change, finish the work.
  */
 void ContextFreeGrammar::GetFollowTable(){
+	QC_TRACE_SCOPE("GetFollowTable");
+	QC_STAGE("GetFollowTable");
+	QC_PERF_STAGE("GetFollowTable");
 	bool fol_mod = false, nul_mod = false;
 
 	follow.Insert(startSymbol, Finish);
@@ -211,20 +222,40 @@ void ContextFreeGrammar::GetFollowTable(){
  * again by begin() function.
  */
 void ContextFreeGrammar::ElimLeftRecur(){
+	QC_TRACE_SCOPE("ElimLeftRecur");
+	QC_STAGE("ElimLeftRecur");
+	QC_PERF_STAGE("ElimLeftRecur");
 	auto iter_i = nonTerminals.begin();
+	usedIn.clear();
 
 	while(iter_i != nonTerminals.end()){
 		bool eliminated = false;
-		ContextFreeGrammar tmp = *this;
+		ContextFreeGrammar tmp = CopyProductions();
 		for(auto iter_j = nonTerminals.begin(); iter_j != iter_i; iter_j++)
 			tmp._leftSubstitue(*iter_i, *iter_j);//substitute *iter_j with its productions in *iteri's productions
 
 		eliminated = tmp._elimImmediateLeftRecur(*iter_i);
-		if(eliminated) *this = tmp, iter_i = nonTerminals.begin();
+		if(eliminated) *this = std::move(tmp), iter_i = nonTerminals.begin();
 		else iter_i++;
 	}
 }
 
+ContextFreeGrammar ContextFreeGrammar::CopyProductions() const{
+	ContextFreeGrammar grammar;
+	grammar.startSymbol = startSymbol;
+	grammar.nonTerminals = nonTerminals;
+	grammar.terminals = terminals;
+	grammar.productions = productions;
+
+	grammar.first = first;
+	grammar.follow = follow;
+	grammar.nullable = nullable;
+
+	grammar.addStartSymbol = addStartSymbol;
+	grammar.nameGenerator = nameGenerator;
+	return grammar;
+}
+
 /* For <A>-><S>xxx, we use <S>'s productions to substitute <S> itself in this production.
  * This means there will be more productions.
  * Try to find all productions that starts with <S> and all the <A>-<S>xxx productions.
@@ -361,7 +392,11 @@ bool ContextFreeGrammar::_elimImmediateLeftRecur(const std::string& term){
  * should work, the complexity perhaps just as same as eliminating left recursions.
  */
 void ContextFreeGrammar::LeftFactoring() {
+	QC_TRACE_SCOPE("LeftFactoring");
+	QC_STAGE("LeftFactoring");
+	QC_PERF_STAGE("LeftFactoring");
 	auto iter = nonTerminals.begin();
+	usedIn.clear();
 	while(iter != nonTerminals.end()) {
 		FactorPrefix leftfactor = _getLeftFactor(*iter);
 		if(leftfactor.size() == 0) iter++;
@@ -457,6 +492,9 @@ int ContextFreeGrammar::_findLongestLeftFactor(const std::vector<std::string>& v
  * a's first set.
  */
 void ContextFreeGrammar::GetSelectTable(){
+	QC_TRACE_SCOPE("GetSelectTable");
+	QC_STAGE("GetSelectTable");
+	QC_PERF_STAGE("GetSelectTable");
 	for(auto iter = productions.begin(); iter != productions.end(); iter++){
 		const std::string& A = iter->first;
 		const std::vector<std::string>& alpha = iter->second;
@@ -483,24 +521,62 @@ std::set<std::string> ContextFreeGrammar::_getSentenceFirst(const std::vector<st
 }
 
 bool ContextFreeGrammar::ConstructLL1Table(){
+	QC_TRACE_SCOPE("ConstructLL1Table");
+	QC_STAGE("ConstructLL1Table");
+	QC_PERF_STAGE("ConstructLL1Table");
 	bool ambigous = false;
+	grammarId.value = _GrammarId::Next();
 
-	for(auto iter = select.begin(); iter != select.end(); iter++){
+	//the productions are visited in the order of the grammar, not of their addresses, so the first production
+	//of a conflicting cell is kept wherever the productions are allocated
+	for(auto& prod : productions){
+		auto iter = select.find(&prod);
+		if(iter == select.end()) continue;
 		Production* p = iter->first;
 		const std::string& non_term = p->first;
 		const std::set<std::string>& all_terms = iter->second;
 		for(const auto& termi : all_terms){
-			ambigous = ambigous ? ambigous : !ll1table.Insert(non_term, termi, p);
+			ambigous = !ll1table.Insert(non_term, termi, p) || ambigous;
 		}
 	}
 	return ambigous;
 }
 
+#ifdef QCOMPILER_ENABLE_PARSER_STATS
+/* The production and the terminal of the lookahead are identified by their addresses, which are stable
+ * while the grammar has the same grammarId.
+ */
+static void _countExpansion(ParserStatsSlot& stats, const ContextFreeGrammar& gram,
+				const ContextFreeGrammar::Production* p, const std::string& term){
+	const uint64_t id = gram.grammarId.value;
+	const uint64_t production = reinterpret_cast<uintptr_t>(p);
+	stats.Expand(id, production, [p]() { return ParserStats::ProductionName(p->first, p->second); });
+	auto iter = gram.terminals.find(term);
+	const std::string* look = iter == gram.terminals.end() ? &ContextFreeGrammar::Finish : &*iter;
+	stats.Cell(id, production, reinterpret_cast<uintptr_t>(look), [p, look]() {
+		return "[" + p->first + ", " + *look + "] " + ParserStats::ProductionName(p->first, p->second);
+	});
+}
+#endif
+
 std::unique_ptr<SyntaxTree> ContextFreeGrammar::LL1Parsing(const std::vector<std::string>& sentence) const{
+	size_t ind = 0;
+	return LL1Parsing([&sentence, &ind](std::string& term) {
+		if(ind >= sentence.size()) return false;
+		term = sentence[ind++];
+		return true;
+	});
+}
+
+std::unique_ptr<SyntaxTree> ContextFreeGrammar::LL1Parsing(const TokenSource& next) const{
+	QC_TRACE_SCOPE("LL1Parsing");
+	QC_STAGE("LL1Parsing");
+	QC_PERF_STAGE("LL1Parsing");
 	std::stack<SyntaxNode*> st;
 	std::unique_ptr<SyntaxTree> tree(new SyntaxTree);
 
-	if(sentence.size() == 0) return tree; //null syntax tree, perhaps should never be here
+	std::string term;
+	if(!next(term)) return tree; //null syntax tree, perhaps should never be here
 
 	tree->GetHead()->addChild(startSymbol, SyntaxNode::NONTERMINAL);
 	tree->CountIncrease();
@@ -509,23 +585,33 @@ std::unique_ptr<SyntaxTree> ContextFreeGrammar::LL1Parsing(const std::vector<std
 	st.push(tree->GetHead()->getChild(1));
 	st.push(tree->GetHead()->getChild(0));
 
-	std::vector<std::string> new_sen = sentence;
-	new_sen.push_back(Finish);
+	bool input_end = false, finished = false;
+	size_t pos = 0;
+	QC_PARSER_STATS(ParserStatsSlot& stats = ParserStatsSlot::Current());
+	QC_PARSER_STATS(auto stats_begin = std::chrono::steady_clock::now());
 	
-	auto iter = new_sen.begin();
-	
-	while(!st.empty() && iter != new_sen.end()){
+	while(!st.empty()){
 		SyntaxNode* curNode = st.top();
 		st.pop();
-		if(curNode->getTerm() == Epsilon) continue;
-
-		std::string term = *iter;
-		if(term == curNode->getTerm()) { 
-			{ iter++; continue; }
+		if(curNode->getTerm() == Epsilon) { QC_PARSER_STATS(stats.epsilonPops++); continue; }
+
+		//only a terminal matches a token, and Finish the end of input, a token named '$' or like a nonterminal
+		//is an unexpected one
+		if(term == curNode->getTerm() && (curNode->type == SyntaxNode::TERMINAL || input_end)){
+			if(curNode->type == SyntaxNode::FINISH) { finished = true; break; }
+			if(pos++, !next(term)) term = Finish, input_end = true; //end of input, the next one is Finish
+			continue;
 		}
 		
-		Production* p = ll1table.Parse(curNode->getTerm(), term);
-		assert(p != nullptr);
+		Production* p = nullptr;
+		if(curNode->type == SyntaxNode::NONTERMINAL) p = ll1table.Parse(curNode->getTerm(), term);
+		QC_PARSER_STATS(if(curNode->type == SyntaxNode::NONTERMINAL) stats.lookups++);
+		if(p == nullptr){
+			tree->diagnostics.push_back(ParseDiagnostic{ pos, term, curNode->getTerm() });
+			if(!_recoverFromError(curNode, term, pos, input_end, next)) break;
+			if(ll1table.Parse(curNode->getTerm(), term) != nullptr) st.push(curNode); //synchronized at its start
+			continue;
+		}
 		
 		for(auto iter2 = p->second.begin(); iter2 != p->second.end(); iter2++){
 			SyntaxNode::NodeType t = _isTerminal(*iter2) ? SyntaxNode::TERMINAL : SyntaxNode::NONTERMINAL;
@@ -537,14 +623,49 @@ std::unique_ptr<SyntaxTree> ContextFreeGrammar::LL1Parsing(const std::vector<std
 			SyntaxNode* node = curNode->getChild(i);
 			st.push(node);
 		}
+		QC_PARSER_STATS(_countExpansion(stats, *this, p, term); stats.StackDepth(st.size()));
 	}
+	QC_PARSER_STATS(stats.parses++; stats.tokens += pos);
+	QC_PARSER_STATS(stats.nanoseconds += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+							std::chrono::steady_clock::now() - stats_begin).count()));
 
-	if(st.empty() && iter == new_sen.end()) tree->Accepted();
+	if(finished && tree->diagnostics.empty()) tree->Accepted();
 	else tree->NotAccepted();
 
 	return tree;
 }
 
+/* Panic mode error recovery, the synchronization set of nonterminal A is Follow(A).
+ * 1. Finish is on the top of stack, but there is still input. All the redundant input are drained,
+ *    and the parsing stops.
+ * 2. Terminal a is on the top of stack but does not match the input. Pop a, this works as if the
+ *    missing a has been inserted.
+ * 3. Nonterminal A is on the top of stack and there is no entry in LL(1) table. Skip the input until
+ *    a token that can start A(there is entry in table now) or a token in Follow(A), or the end. For
+ *    the former case, A is pushed back by the caller and parsing goes on with it, for the latter
+ *    cases, A is popped and the parsing goes on with the rest of the stack.
+ *
+ * Only one diagnostic for each error, the skipped tokens would not generate diagnostics any more.
+ * Returns false if the parsing should stop.
+ */
+bool ContextFreeGrammar::_recoverFromError(const SyntaxNode* node, std::string& term, size_t& pos,
+							bool& input_end, const TokenSource& next) const {
+	if(node->type == SyntaxNode::FINISH){
+		while(next(term)) pos++;
+		return false;
+	}
+	if(node->type == SyntaxNode::TERMINAL) return true;
+
+	const std::string& A = node->getTerm();
+	auto iter = follow.find(A);
+	auto in_follow = [&iter, this](const std::string& t) {
+		return iter != follow.end() && iter->second.find(t) != iter->second.end();
+	};
+	while(!input_end && ll1table.Parse(A, term) == nullptr && !in_follow(term))
+		if(pos++, !next(term)) term = Finish, input_end = true;
+	return true;
+}
+
 bool ContextFreeGrammar::_nontermIsUsing(const std::string& term) const {
 	for(auto iter = productions.begin(); iter != productions.end(); iter++){
 		if(iter->first == term) continue; //term uses itself, ignore this case
@@ -610,16 +731,14 @@ std::set<std::string> FirstTable::GetFirstSet(const std::string& term) const{
 	return iter->second;
 }
 
-void SyntaxTree::GenerateGraphvz(const std::string& filename) {
-	std::ofstream outfile(filename); //check outfile here
-	if(!outfile){
-		assert(0);
-	}
+bool SyntaxTree::GenerateGraphvz(const std::string& filename) {
+	std::ofstream outfile(filename);
+	if(!outfile) return false;
 	outfile << "digraph G {" << std::endl;
 	outfile << "node[shape = plaintext]" << std::endl;
 	_generateGraphvz(outfile);
 	outfile << "}" << std::endl;
-	outfile.close();
+	return static_cast<bool>(outfile);
 }
 
 void SyntaxTree::_generateGraphvz(std::ofstream& outfile) {
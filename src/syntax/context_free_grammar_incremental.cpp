@@ -0,0 +1,234 @@
+#include <queue>
+#include "syntax_specific.h"
+#include "utility/utility_internal.h"
+
+/* How the incremental change works?
+ *
+ * FIRST: First[X] and nullable[X] depend on the terms in the right part of X's productions. So once the
+ * productions of L change, only L and the nonterminals that use L(directly or not) can change, this is
+ * the first cone. The sets in the cone are cleared and computed again with the same iteration as
+ * GetFirstTable, but only the productions of the cone are visited, terms out of the cone are stable.
+ *
+ * FOLLOW: for X->Y1...Yn, Follow[Yi] depends on First[Yi+1...] and Follow[X]. The seeds of the follow cone
+ * are the nonterminals in the changed right part, and the nonterminals before any term of the first cone
+ * in all productions. Then Follow[X] flows into Yi if Yi+1...Yn are all nullable, the cone is closed under
+ * this relation. Nullable has been updated by FIRST already, so the relation is exact.
+ *
+ * SELECT and LL(1) table: only the productions whose left part is in one of the two cones can change their
+ * SELECT sets, and only the rows of these nonterminals are rebuilt.
+ */
+bool ContextFreeGrammar::AddProduction(const std::string& left, const std::vector<std::string>& right, bool* ambiguous){
+	if(right.empty()) return false;
+	auto iter_pair = productions.equal_range(left);
+	for(auto iter = iter_pair.first; iter != iter_pair.second; iter++)
+		if(iter->second == right) return false;
+
+	if(usedIn.empty()) _buildUsedIn();
+	grammarId.value = _GrammarId::Next();
+
+	std::set<std::string> seeds;
+	if(_isTerminal(left)){ //used as terminal before, now it becomes nonterminal
+		terminals.erase(left);
+		first[left].clear();
+		seeds.insert(left);
+	}
+	nonTerminals.insert(left);
+	if(nullable.find(left) == nullable.end()) nullable[left] = false;
+
+	for(const auto& t : right){
+		if(t == Epsilon || t == left || nonTerminals.find(t) != nonTerminals.end()) continue;
+		if(terminals.insert(t).second) first[t].insert(t), nullable[t] = false;
+	}
+
+	productions.insert(std::make_pair(left, right));
+	for(const auto& t : right) usedIn[t].insert(left);
+
+	std::set<std::string> first_cone = _firstCone(left);
+	_recomputeFirst(first_cone);
+
+	for(const auto& t : right) if(nonTerminals.find(t) != nonTerminals.end()) seeds.insert(t);
+	std::set<std::string> follow_cone = _followCone(seeds, first_cone);
+	_recomputeFollow(follow_cone);
+
+	std::set<std::string> rows = first_cone;
+	rows.insert(follow_cone.begin(), follow_cone.end());
+	bool conflict = _patchSelectAndLL1Rows(rows);
+	if(ambiguous) *ambiguous = conflict;
+	return true;
+}
+
+bool ContextFreeGrammar::RemoveProduction(const std::string& left, const std::vector<std::string>& right, bool* ambiguous){
+	auto iter_pair = productions.equal_range(left);
+	auto iter = iter_pair.first;
+	while(iter != iter_pair.second && iter->second != right) iter++;
+	if(iter == iter_pair.second) return false;
+
+	if(usedIn.empty()) _buildUsedIn();
+	grammarId.value = _GrammarId::Next();
+
+	select.erase(&*iter);
+	productions.erase(iter); //the row of 'left' still points to it, it will be rebuilt at last
+
+	for(const auto& t : right){ //'left' may still use t in its other productions
+		bool using_t = false;
+		iter_pair = productions.equal_range(left);
+		for(auto iter2 = iter_pair.first; iter2 != iter_pair.second && !using_t; iter2++)
+			using_t = std::find(iter2->second.begin(), iter2->second.end(), t) != iter2->second.end();
+		if(!using_t) usedIn[t].erase(left);
+	}
+
+	std::set<std::string> first_cone = _firstCone(left);
+	_recomputeFirst(first_cone);
+
+	std::set<std::string> seeds;
+	for(const auto& t : right) if(nonTerminals.find(t) != nonTerminals.end()) seeds.insert(t);
+	std::set<std::string> follow_cone = _followCone(seeds, first_cone);
+	_recomputeFollow(follow_cone);
+
+	std::set<std::string> rows = first_cone;
+	rows.insert(follow_cone.begin(), follow_cone.end());
+	bool conflict = _patchSelectAndLL1Rows(rows);
+	if(ambiguous) *ambiguous = conflict;
+	return true;
+}
+
+void ContextFreeGrammar::_buildUsedIn(){
+	usedIn.clear();
+	for(auto iter = productions.begin(); iter != productions.end(); iter++)
+		for(const auto& t : iter->second) usedIn[t].insert(iter->first);
+}
+
+std::set<std::string> ContextFreeGrammar::_firstCone(const std::string& left) const {
+	std::set<std::string> cone;
+	std::queue<std::string> q;
+
+	cone.insert(left), q.push(left);
+	while(!q.empty()){
+		auto iter = usedIn.find(q.front());
+		q.pop();
+		if(iter == usedIn.end()) continue;
+		for(const auto& X : iter->second)
+			if(cone.insert(X).second) q.push(X);
+	}
+	return cone;
+}
+
+std::set<std::string> ContextFreeGrammar::_followCone(std::set<std::string> seeds,
+						const std::set<std::string>& firstCone) const {
+	for(const auto& Z : firstCone){
+		auto iter = usedIn.find(Z);
+		if(iter == usedIn.end()) continue;
+		for(const auto& X : iter->second){
+			auto iter_pair = productions.equal_range(X);
+			for(auto iter2 = iter_pair.first; iter2 != iter_pair.second; iter2++){
+				const std::vector<std::string>& Y = iter2->second;
+				//every term before the last Z is followed by some Z, as <A> in <S>-><A><A>
+				auto pos = std::find(Y.rbegin(), Y.rend(), Z);
+				for(auto iter3 = pos; iter3 != Y.rend(); iter3++)
+					if(nonTerminals.find(*iter3) != nonTerminals.end()) seeds.insert(*iter3);
+			}
+		}
+	}
+
+	std::set<std::string> cone;
+	std::queue<std::string> q;
+	for(const auto& s : seeds) cone.insert(s), q.push(s);
+	while(!q.empty()){
+		std::string X = q.front();
+		q.pop();
+		auto iter_pair = productions.equal_range(X);
+		for(auto iter = iter_pair.first; iter != iter_pair.second; iter++){
+			const std::vector<std::string>& Y = iter->second;
+			for(int i = static_cast<int>(Y.size()) - 1; i >= 0; i--){ //from the tail, while it is nullable
+				if(nonTerminals.find(Y[i]) != nonTerminals.end() && cone.insert(Y[i]).second) q.push(Y[i]);
+				if(!_isNullable(Y[i])) break;
+			}
+		}
+	}
+	return cone;
+}
+
+void ContextFreeGrammar::_recomputeFirst(const std::set<std::string>& cone){
+	std::vector<Production*> prods;
+	for(const auto& X : cone){
+		first[X].clear();
+		nullable[X] = false;
+		auto iter_pair = productions.equal_range(X);
+		for(auto iter = iter_pair.first; iter != iter_pair.second; iter++) prods.push_back(&*iter);
+	}
+
+	bool fir_mod = false, nul_mod = false;
+	do{ //the same as GetFirstTable
+		fir_mod = false, nul_mod = false;
+		for(auto p : prods){
+			bool all_null = true;
+			const std::string& X = p->first;
+			const std::vector<std::string>& Y = p->second;
+			for(size_t i = 0; i < Y.size() && all_null; i++){
+				fir_mod = first.UnionExclude(X, first[Y[i]], Epsilon) ? true : fir_mod;
+				if(!_isNullable(Y[i])) all_null = false;
+			}
+			if (all_null){
+				nul_mod = nullable.SetValue(X, true) ? true : nul_mod;
+				fir_mod = first.Insert(X, Epsilon) ? true : fir_mod;
+			}
+		}
+	}while(fir_mod || nul_mod);
+}
+
+void ContextFreeGrammar::_recomputeFollow(const std::set<std::string>& cone){
+	std::set<std::string> lefts;
+	for(const auto& Y : cone){
+		follow[Y].clear();
+		auto iter = usedIn.find(Y);
+		if(iter != usedIn.end()) lefts.insert(iter->second.begin(), iter->second.end());
+	}
+	if(cone.find(startSymbol) != cone.end()) follow.Insert(startSymbol, Finish);
+
+	std::vector<Production*> prods;
+	for(const auto& X : lefts){
+		auto iter_pair = productions.equal_range(X);
+		for(auto iter = iter_pair.first; iter != iter_pair.second; iter++) prods.push_back(&*iter);
+	}
+
+	bool fol_mod = false;
+	do{ //the same as GetFollowTable, but only the terms in the cone are updated
+		fol_mod = false;
+		for(auto p : prods){
+			const std::string& X = p->first;
+			const std::vector<std::string>& Y = p->second;
+			int k = Y.size() - 1;
+			for(int i = 0; i <= k; i++){
+				if(cone.find(Y[i]) == cone.end()) continue;
+				if(_allNullable(Y, i + 1, k))
+					fol_mod = follow.Union(Y[i], follow[X]) ? true : fol_mod;
+
+				for(int j = i + 1; j <= k; j++)
+					if (_allNullable(Y, i + 1, j - 1))
+						fol_mod = follow.UnionExclude(Y[i], first[Y[j]], Epsilon) ? true : fol_mod;
+					else break;
+			}
+		}
+	}while(fol_mod);
+}
+
+bool ContextFreeGrammar::_patchSelectAndLL1Rows(const std::set<std::string>& rows){
+	bool ambiguous = false;
+	for(const auto& A : rows){
+		std::vector<Production*> prods;
+		auto iter_pair = productions.equal_range(A);
+		for(auto iter = iter_pair.first; iter != iter_pair.second; iter++){
+			std::set<std::string> st = _getSentenceFirst(iter->second);
+			if (st.find(Epsilon) != st.end())
+				st.erase(Epsilon), setUnion(st, follow[A]);
+			select[&*iter] = st;
+			prods.push_back(&*iter);
+		}
+
+		//the same order as ConstructLL1Table, the order of the productions in the grammar
+		ll1table.table[A].clear();
+		for(auto p : prods)
+			for(const auto& termi : select[p]) ambiguous = !ll1table.Insert(A, termi, p) || ambiguous;
+	}
+	return ambiguous;
+}
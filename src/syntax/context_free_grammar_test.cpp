@@ -0,0 +1,78 @@
+#include "gtest/gtest.h"
+#include "syntax_specific.h"
+#include "syntax/test_grammar.h"
+
+static std::unique_ptr<ContextFreeGrammar> GrammarFromFile(const std::vector<std::string>& lines){
+	return TestGrammar("context_free_grammar_test.syn", lines, false);
+}
+
+//the production pointers are different between two grammars, so compare the tables by contents
+static std::map<std::pair<std::string, std::string>, std::vector<std::string>> LL1Contents(const ContextFreeGrammar& g){
+	std::map<std::pair<std::string, std::string>, std::vector<std::string>> mp;
+	for(const auto& row : g.ll1table){
+		for(const auto& cell : row.second){
+			std::vector<std::string> prod(1, cell.second->first);
+			prod.insert(prod.end(), cell.second->second.begin(), cell.second->second.end());
+			mp[std::make_pair(row.first, cell.first)] = prod;
+		}
+	}
+	return mp;
+}
+
+static void ExpectSameTables(const ContextFreeGrammar& inc, const ContextFreeGrammar& full){
+	for(const auto& nt : full.nonTerminals){
+		EXPECT_EQ(inc.first.GetFirstSet(nt), full.first.GetFirstSet(nt)) << nt;
+		EXPECT_EQ(inc.nullable.GetValue(nt), full.nullable.GetValue(nt)) << nt;
+		auto iter = full.follow.find(nt);
+		auto iter2 = inc.follow.find(nt);
+		std::set<std::string> empty;
+		EXPECT_EQ(iter2 == inc.follow.end() ? empty : iter2->second,
+				iter == full.follow.end() ? empty : iter->second) << nt;
+	}
+	EXPECT_EQ(LL1Contents(inc), LL1Contents(full));
+}
+
+TEST(ContextFreeGrammarTest, IncrementalAddProduction){
+	std::unique_ptr<ContextFreeGrammar> inc = GrammarFromFile({ "<E>-><T><E1>", "<E1>->+<T><E1>|#", "<T>-><F><T1>",
+					"<T1>->*<F><T1>|#", "<F>->(<E>)|id" });
+	bool ambiguous = true;
+	EXPECT_TRUE(inc->AddProduction("F", { "num" }, &ambiguous));
+	EXPECT_FALSE(ambiguous);
+	EXPECT_FALSE(inc->AddProduction("F", { "num" }));
+	EXPECT_TRUE(inc->AddProduction("E1", { "-", "T", "E1" }));
+
+	std::unique_ptr<ContextFreeGrammar> full = GrammarFromFile({ "<E>-><T><E1>", "<E1>->+<T><E1>|-<T><E1>|#", "<T>-><F><T1>",
+					"<T1>->*<F><T1>|#", "<F>->(<E>)|id|num" });
+	ExpectSameTables(*inc, *full);
+}
+
+TEST(ContextFreeGrammarTest, IncrementalRemoveProduction){
+	std::unique_ptr<ContextFreeGrammar> inc = GrammarFromFile({ "<S>-><A><B>c", "<A>->a|#", "<B>->b|#" });
+	EXPECT_FALSE(inc->RemoveProduction("A", { "b" }));
+	EXPECT_TRUE(inc->RemoveProduction("A", { "#" }));
+
+	std::unique_ptr<ContextFreeGrammar> full = GrammarFromFile({ "<S>-><A><B>c", "<A>->a", "<B>->b|#" });
+	ExpectSameTables(*inc, *full);
+
+	EXPECT_TRUE(inc->AddProduction("A", { "#" }));
+	EXPECT_TRUE(inc->RemoveProduction("B", { "b" }));
+	std::unique_ptr<ContextFreeGrammar> full2 = GrammarFromFile({ "<S>-><A><B>c", "<A>->a|#", "<B>->#" });
+	ExpectSameTables(*inc, *full2);
+}
+
+//<A> is followed by its own FIRST set in <S>-><A><A>, not only by what follows the first <A>
+TEST(ContextFreeGrammarTest, IncrementalRepeatedTerm){
+	std::unique_ptr<ContextFreeGrammar> inc = GrammarFromFile({ "<S>-><A><A>|b", "<A>-><A>a" });
+	bool ambiguous = false;
+	EXPECT_TRUE(inc->AddProduction("A", { "c" }, &ambiguous));
+	EXPECT_TRUE(ambiguous); //<A>-><A>a and <A>->c both begin with c
+
+	std::unique_ptr<ContextFreeGrammar> full = GrammarFromFile({ "<S>-><A><A>|b", "<A>-><A>a|c" });
+	ExpectSameTables(*inc, *full);
+	EXPECT_EQ(inc->follow["A"].count("c"), 1u);
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
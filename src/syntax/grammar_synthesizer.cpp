@@ -0,0 +1,157 @@
+#include <limits>
+#include <set>
+#include <stack>
+#include <utility>
+#include "grammar_synthesizer.h"
+#include "utility/utility_internal.h"
+
+/* std::shuffle and the distributions are implementation defined, only the output of mt19937 is
+ * the same everywhere, so the grammars and sentences are reproducible between platforms.
+ */
+static size_t _randomIndex(std::mt19937& rng, size_t n){
+	return static_cast<size_t>(rng() % n);
+}
+
+//zero padded, so the order of the nonterminals in std::set is the order of the levels
+static std::string _levelName(int level, int levels){
+	std::string num = intToString(level), last = intToString(levels - 1);
+	return "L" + std::string(last.size() - num.size(), '0') + num;
+}
+
+std::string SynthesizeGrammar(const SyntheticGrammarOptions& options){
+	const int levels = options.nonTerminals < 1 ? 1 : options.nonTerminals;
+	const int alters = options.alternatives < 1 ? 1 : options.alternatives;
+	std::mt19937 rng(options.seed);
+
+	std::vector<bool> left_recursive(levels, false);
+	std::vector<int> order(levels);
+	for(int i = 0; i < levels; i++) order[i] = i;
+	for(int i = levels - 1; i > 0; i--) std::swap(order[i], order[_randomIndex(rng, i + 1)]);
+	for(int i = 0; i < levels && i < options.leftRecursive; i++) left_recursive[order[i]] = true;
+
+	const std::string top = "<" + _levelName(0, levels) + ">";
+	std::string syn = "<E>->" + top + "\n";
+	for(int i = 0; i < levels; i++){
+		std::string cur = "<" + _levelName(i, levels) + ">";
+		std::string next = i + 1 == levels ? "<P>" : "<" + _levelName(i + 1, levels) + ">";
+		syn += cur + "->";
+		for(int k = 0; k < alters; k++){
+			std::string op = " o" + intToString(i) + "_" + intToString(k) + " ";
+			if(left_recursive[i]) syn += cur + op + next + "|";
+			else syn += next + op + cur + "|";
+		}
+		syn += next + "\n";
+	}
+
+	syn += "<P>->id|num|(" + top + ")";
+	for(int j = 0; j < options.commonPrefixes; j++){
+		std::string prefix = "k" + intToString(j) + " (" + top + ") ";
+		syn += "|" + prefix + "x" + intToString(j) + "|" + prefix + "y" + intToString(j);
+	}
+	syn += "\n";
+	return syn;
+}
+
+SentenceDeriver::SentenceDeriver(const ContextFreeGrammar& grammar, unsigned seed) : grammar_(grammar), rng_(seed){
+	for(const auto& row : grammar_.ll1table){
+		std::vector<const Production*>& alters = alternatives_[row.first];
+		for(const auto& cell : row.second)
+			if(std::find(alters.begin(), alters.end(), cell.second) == alters.end()) alters.push_back(cell.second);
+	}
+	_computeMinimal();
+	_computeRecursive();
+}
+
+/* height(terminal) = 0, height(A) = min over productions of 1 + max height of the right part, it is
+ * computed by iterating until nothing changes, like the FIRST sets.
+ */
+void SentenceDeriver::_computeMinimal(){
+	const int infinite = std::numeric_limits<int>::max();
+	std::map<std::string, int> height;
+	for(const auto& a : alternatives_) height[a.first] = infinite;
+
+	bool changed = true;
+	while(changed){
+		changed = false;
+		for(const auto& a : alternatives_){
+			for(const Production* p : a.second){
+				int h = 0;
+				for(const auto& t : p->second){
+					auto iter = height.find(t);
+					if(iter == height.end()) continue; //terminal or epsilon
+					h = std::max(h, iter->second);
+				}
+				if(h == infinite || h + 1 >= height[a.first]) continue;
+				height[a.first] = h + 1;
+				minimal_[a.first] = p;
+				changed = true;
+			}
+		}
+	}
+}
+
+bool SentenceDeriver::_isRecursive(const Production* p) const{
+	for(const auto& t : p->second)
+		if(recursive_.find(t) != recursive_.end()) return true;
+	return false;
+}
+
+//A is recursive if A can be reached from the nonterminals in the right parts of A
+void SentenceDeriver::_computeRecursive(){
+	for(const auto& a : alternatives_){
+		std::set<std::string> reached;
+		std::stack<std::string> st;
+		st.push(a.first);
+		while(!st.empty()){
+			auto iter = alternatives_.find(st.top());
+			st.pop();
+			for(const Production* p : iter->second){
+				for(const auto& t : p->second){
+					if(alternatives_.find(t) == alternatives_.end() || !reached.insert(t).second) continue;
+					st.push(t);
+				}
+			}
+		}
+		if(reached.find(a.first) != reached.end()) recursive_.insert(a.first);
+	}
+}
+
+/* Before the expected length is reached, the alternatives are chosen uniformly, but the ones can only
+ * terminate(no recursive nonterminal in the right part) are allowed only if there is another recursive
+ * nonterminal waiting in the stack, so the sentence cannot end too early.
+ */
+std::vector<std::string> SentenceDeriver::Derive(size_t length, int maxDepth){
+	std::vector<std::string> sentence;
+	std::stack<std::pair<std::string, int>> st; //term and its depth
+	st.push(std::make_pair(grammar_.startSymbol, 0));
+	size_t pending = recursive_.count(grammar_.startSymbol); //recursive nonterminals in the stack
+	//guard against the grammars which can loop without producing terminals
+	size_t steps = 0, max_steps = 16 * length + 1024;
+
+	while(!st.empty()){
+		std::pair<std::string, int> top = st.top();
+		st.pop();
+		auto iter = alternatives_.find(top.first);
+		if(iter == alternatives_.end()){
+			if(top.first != ContextFreeGrammar::Epsilon) sentence.push_back(top.first);
+			continue;
+		}
+		if(recursive_.find(top.first) != recursive_.end()) pending--;
+
+		const Production* p = minimal_[top.first];
+		bool grow = sentence.size() + st.size() < length && top.second <= maxDepth && ++steps < max_steps;
+		if(grow){
+			std::vector<const Production*> candidates;
+			for(const Production* alter : iter->second)
+				if(pending > 0 || _isRecursive(alter)) candidates.push_back(alter);
+			if(!candidates.empty()) p = candidates[_randomIndex(rng_, candidates.size())];
+		}
+
+		const std::vector<std::string>& right = p->second;
+		for(size_t i = right.size(); i > 0; i--){
+			st.push(std::make_pair(right[i - 1], i == right.size() ? top.second : top.second + 1));
+			if(recursive_.find(right[i - 1]) != recursive_.end()) pending++;
+		}
+	}
+	return sentence;
+}
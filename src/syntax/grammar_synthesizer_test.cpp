@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+#include "syntax_specific.h"
+#include "grammar_synthesizer.h"
+#include "syntax/test_grammar.h"
+
+//nullptr if the grammar is not LL(1)
+static std::unique_ptr<ContextFreeGrammar> GrammarFromText(const std::string& syn){
+	std::unique_ptr<ContextFreeGrammar> gram = GenerateTestGrammar("grammar_synthesizer_test.syn", { syn });
+	gram->ElimLeftRecur();
+	gram->LeftFactoring();
+	gram->GetFirstTable();
+	gram->GetFollowTable();
+	gram->GetSelectTable();
+	if(gram->ConstructLL1Table()) gram.reset();
+	return gram;
+}
+
+TEST(GrammarSynthesizerTest, Reproducible){
+	SyntheticGrammarOptions options;
+	options.nonTerminals = 12;
+	options.leftRecursive = 5;
+	options.commonPrefixes = 2;
+	options.seed = 7;
+	EXPECT_EQ(SynthesizeGrammar(options), SynthesizeGrammar(options));
+	EXPECT_NE(SynthesizeGrammar(options).find("<L00>"), std::string::npos);
+
+	std::unique_ptr<ContextFreeGrammar> gram = GrammarFromText(SynthesizeGrammar(options));
+	ASSERT_TRUE(gram);
+	SentenceDeriver deriver(*gram, 3), deriver2(*gram, 3);
+	EXPECT_EQ(deriver.Derive(200, 40), deriver2.Derive(200, 40));
+}
+
+TEST(GrammarSynthesizerTest, DerivedSentencesAreAccepted){
+	SyntheticGrammarOptions options;
+	options.nonTerminals = 6;
+	options.alternatives = 3;
+	options.leftRecursive = 3;
+	options.commonPrefixes = 3;
+
+	std::unique_ptr<ContextFreeGrammar> gram = GrammarFromText(SynthesizeGrammar(options));
+	ASSERT_TRUE(gram);
+
+	SentenceDeriver deriver(*gram);
+	for(size_t length : { 1, 10, 100, 5000 }){
+		std::vector<std::string> sen = deriver.Derive(length, 30);
+		EXPECT_GE(sen.size(), length);
+		std::unique_ptr<SyntaxTree> tree = gram->LL1Parsing(sen);
+		EXPECT_TRUE(tree->IsAccepted()) << length;
+	}
+
+	std::vector<std::string> shallow = deriver.Derive(5000, 0);
+	EXPECT_TRUE(std::find(shallow.begin(), shallow.end(), "(") == shallow.end());
+	EXPECT_TRUE(gram->LL1Parsing(shallow)->IsAccepted());
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
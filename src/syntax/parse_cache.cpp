@@ -0,0 +1,101 @@
+#include "parse_cache.h"
+#include "alloc_stats.h"
+
+ParseCache::ParseCache(size_t budgetBytes) : budget_(budgetBytes) {
+}
+
+ParseCache::Tokens ParseCache::TokenIds(const CompiledGrammar& grammar, const CompiledGrammar::Sentence& sentence){
+	Tokens tokens;
+	tokens.reserve(sentence.size());
+	for(const auto& t : sentence) tokens.push_back(grammar.FindSymbol(t));
+	return tokens;
+}
+
+/* Multiply and xor-shift over the ids, the length and the version are mixed in first, so the same ids
+ * of another grammar hash differently.
+ */
+uint64_t ParseCache::Hash(uint64_t version, const Tokens& tokens){
+	const uint64_t k = 0x9E3779B97F4A7C15ull;
+	uint64_t h = (version * k) ^ (tokens.size() + 0x632BE59BD9B4E019ull);
+	for(SymbolId id : tokens){
+		h = (h ^ static_cast<uint32_t>(id)) * k;
+		h ^= h >> 29;
+	}
+	h ^= h >> 32;
+	return h * k;
+}
+
+ParseCache::Tree ParseCache::Find(const CompiledGrammar& grammar, const Tokens& tokens){
+	uint64_t hash = Hash(grammar.Version(), tokens);
+	Shard& shard = _shard(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto iter = shard.index.find(hash);
+	if(iter == shard.index.end() || iter->second->version != grammar.Version() || iter->second->tokens != tokens){
+		misses_.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	shard.lru.splice(shard.lru.begin(), shard.lru, iter->second);
+	hits_.fetch_add(1, std::memory_order_relaxed);
+	return iter->second->tree;
+}
+
+void ParseCache::_erase(Shard& shard, std::list<Entry>::iterator iter){
+	shard.bytes -= iter->bytes;
+	shard.index.erase(iter->hash);
+	shard.lru.erase(iter);
+}
+
+//a colliding entry is replaced, and the least recently used ones are evicted until the new one fits
+void ParseCache::Insert(const CompiledGrammar& grammar, const Tokens& tokens, Tree tree){
+	const size_t shard_budget = budget_ / SHARDS;
+	size_t bytes = sizeof(Entry) + tokens.size() * sizeof(SymbolId) + ResidentBytes(*tree);
+	if(bytes > shard_budget) return;
+
+	uint64_t hash = Hash(grammar.Version(), tokens);
+	Shard& shard = _shard(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto iter = shard.index.find(hash);
+	if(iter != shard.index.end()) _erase(shard, iter->second);
+	while(shard.bytes + bytes > shard_budget){
+		_erase(shard, std::prev(shard.lru.end()));
+		evictions_.fetch_add(1, std::memory_order_relaxed);
+	}
+	shard.lru.push_front(Entry{ hash, grammar.Version(), tokens, std::move(tree), bytes });
+	shard.index[hash] = shard.lru.begin();
+	shard.bytes += bytes;
+}
+
+ParseCache::Tree ParseCache::Parse(const CompiledGrammar& grammar, const Tokens& tokens){
+	Tree tree = Find(grammar, tokens);
+	if(tree) return tree;
+	tree = grammar.Parse(tokens.begin(), tokens.end());
+	Insert(grammar, tokens, tree);
+	return tree;
+}
+
+size_t ParseCache::Entries() const {
+	size_t n = 0;
+	for(const auto& shard : shards_){
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		n += shard.lru.size();
+	}
+	return n;
+}
+
+size_t ParseCache::Bytes() const {
+	size_t n = 0;
+	for(const auto& shard : shards_){
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		n += shard.bytes;
+	}
+	return n;
+}
+
+void ParseCache::Clear(){
+	for(auto& shard : shards_){
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		shard.lru.clear();
+		shard.index.clear();
+		shard.bytes = 0;
+	}
+}
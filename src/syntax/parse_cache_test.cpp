@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <thread>
+#include "gtest/gtest.h"
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "parse_cache.h"
+#include "syntax/test_grammar.h"
+
+static std::unique_ptr<ContextFreeGrammar> ExpressionGrammar(){
+	return TestGrammar("parse_cache_test.syn", { "<E>-><E>+<T>|<T>", "<T>-><T>*<F>|<F>", "<F>->id|(<E>)" });
+}
+
+TEST(ParseCacheTest, HitsShareTheTree){
+	CompiledGrammar compiled(*ExpressionGrammar());
+	ParseCache cache(1 << 20);
+
+	ParseCache::Tokens tokens = ParseCache::TokenIds(compiled, { "id", "+", "id", "*", "id" });
+	ParseCache::Tree first = cache.Parse(compiled, tokens);
+	ASSERT_TRUE(first->IsAccepted());
+	EXPECT_EQ(cache.Misses(), 1u);
+	EXPECT_EQ(cache.Entries(), 1u);
+	EXPECT_GT(cache.Bytes(), 0u);
+
+	ParseCache::Tree second = cache.Parse(compiled, tokens);
+	EXPECT_EQ(second.get(), first.get());
+	EXPECT_EQ(cache.Hits(), 1u);
+
+	//a different sentence of the same length
+	ParseCache::Tree other = cache.Parse(compiled, ParseCache::TokenIds(compiled, { "id", "*", "id", "+", "id" }));
+	EXPECT_NE(other.get(), first.get());
+	EXPECT_EQ(cache.Misses(), 2u);
+
+	//the unknown token is InvalidSymbol, its name is not in the diagnostic
+	ParseCache::Tree rejected = cache.Parse(compiled, ParseCache::TokenIds(compiled, { "id", "+", "x" }));
+	EXPECT_FALSE(rejected->IsAccepted());
+	ASSERT_EQ(rejected->diagnostics.size(), 1u);
+	EXPECT_EQ(rejected->diagnostics[0].position, 2u);
+
+	cache.Clear();
+	EXPECT_EQ(cache.Entries(), 0u);
+	EXPECT_EQ(cache.Bytes(), 0u);
+	EXPECT_TRUE(cache.Find(compiled, tokens) == nullptr);
+}
+
+TEST(ParseCacheTest, GrammarVersions){
+	std::unique_ptr<ContextFreeGrammar> gram = ExpressionGrammar();
+	CompiledGrammar a(*gram), b(*gram);
+	EXPECT_NE(a.Version(), b.Version());
+
+	ParseCache cache(1 << 20);
+	ParseCache::Tokens tokens = ParseCache::TokenIds(a, { "(", "id", ")" });
+	ParseCache::Tree tree = cache.Parse(a, tokens);
+	EXPECT_TRUE(cache.Find(a, tokens) == tree);
+	//the same ids of a reloaded grammar are not found
+	EXPECT_TRUE(cache.Find(b, tokens) == nullptr);
+	EXPECT_NE(ParseCache::Hash(a.Version(), tokens), ParseCache::Hash(b.Version(), tokens));
+}
+
+TEST(ParseCacheTest, EvictsLeastRecentlyUsed){
+	CompiledGrammar compiled(*ExpressionGrammar());
+	//32 sentences of the same length, id op id op ... id
+	std::vector<ParseCache::Tokens> sentences;
+	for(int ops = 0; ops < 32; ops++){
+		ParseCache::Tokens tokens{ compiled.FindSymbol("id") };
+		for(int i = 0; i < 5; i++){
+			tokens.push_back(compiled.FindSymbol(ops & (1 << i) ? "+" : "*"));
+			tokens.push_back(compiled.FindSymbol("id"));
+		}
+		sentences.push_back(tokens);
+	}
+	size_t size = 0;
+	for(const auto& s : sentences){
+		ParseCache probe(1 << 20);
+		probe.Parse(compiled, s);
+		size = std::max(size, probe.Bytes());
+	}
+
+	//every shard holds one tree, so some of the 32 are evicted
+	ParseCache cache(ParseCache::SHARDS * (size + size / 2));
+	for(const auto& s : sentences){
+		cache.Parse(compiled, s);
+		EXPECT_LE(cache.Bytes(), cache.BudgetBytes());
+	}
+	EXPECT_GT(cache.Evictions(), 0u);
+	EXPECT_EQ(cache.Entries() + cache.Evictions(), sentences.size());
+	//the last one is the most recently used
+	EXPECT_TRUE(cache.Find(compiled, sentences.back()) != nullptr);
+
+	//a tree larger than a shard is not cached
+	ParseCache tiny(ParseCache::SHARDS);
+	EXPECT_TRUE(tiny.Parse(compiled, sentences[0])->IsAccepted());
+	EXPECT_EQ(tiny.Entries(), 0u);
+}
+
+TEST(ParseCacheTest, ConcurrentParses){
+	CompiledGrammar compiled(*ExpressionGrammar());
+	ParseCache cache(1 << 20);
+	std::vector<ParseCache::Tokens> sentences;
+	ParseCache::Tokens tokens = ParseCache::TokenIds(compiled, { "id" });
+	for(int i = 0; i < 32; i++){
+		sentences.push_back(tokens);
+		tokens.push_back(compiled.FindSymbol("*"));
+		tokens.push_back(compiled.FindSymbol("id"));
+	}
+
+	std::vector<std::thread> threads;
+	for(int t = 0; t < 4; t++){
+		threads.emplace_back([&compiled, &cache, &sentences]() {
+			for(int round = 0; round < 10; round++)
+				for(const auto& s : sentences) EXPECT_TRUE(cache.Parse(compiled, s)->IsAccepted());
+		});
+	}
+	for(auto& t : threads) t.join();
+	EXPECT_EQ(cache.Hits() + cache.Misses(), 4u * 10 * sentences.size());
+	EXPECT_EQ(cache.Entries(), sentences.size());
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "parser_stats.h"
+
+struct ParserStatsRegistry {
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ParserStatsSlot>> slots; //the slots of the exited threads are kept
+};
+
+static ParserStatsRegistry& _registry(){
+	static ParserStatsRegistry registry;
+	return registry;
+}
+
+//the lock is taken once for each thread
+ParserStatsSlot& ParserStatsSlot::Current(){
+	thread_local ParserStatsSlot* slot = nullptr;
+	if(slot) return *slot;
+	ParserStatsRegistry& registry = _registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.slots.emplace_back(new ParserStatsSlot);
+	slot = registry.slots.back().get();
+	return *slot;
+}
+
+std::string ParserStats::ProductionName(const std::string& lhs, const std::vector<std::string>& rhs){
+	std::string name = lhs + " ->";
+	for(const auto& t : rhs) name += " " + t;
+	return name;
+}
+
+ParserStatsSlot ParserStats::Total(){
+	ParserStatsSlot total;
+	ParserStatsRegistry& registry = _registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for(const auto& slot : registry.slots){
+		total.parses += slot->parses;
+		total.tokens += slot->tokens;
+		total.lookups += slot->lookups;
+		total.expansions += slot->expansions;
+		total.epsilonPops += slot->epsilonPops;
+		total.maxStackDepth = std::max(total.maxStackDepth, slot->maxStackDepth);
+		total.nanoseconds += slot->nanoseconds;
+		for(const auto& p : slot->productions){
+			ParserStatsSlot::Entry& e = total.productions[p.first];
+			e.count += p.second.count;
+			e.name = p.second.name;
+		}
+		for(const auto& c : slot->cells){
+			ParserStatsSlot::Entry& e = total.cells[c.first];
+			e.count += c.second.count;
+			e.name = c.second.name;
+		}
+	}
+	return total;
+}
+
+/* The same production of several grammars(reloaded ones, for example) has one entry for each grammar,
+ * so the entries are merged by name.
+ */
+static ParserStats::Ranking _top(const std::map<std::string, uint64_t>& counts, size_t n){
+	ParserStats::Ranking ranking(counts.begin(), counts.end());
+	std::stable_sort(ranking.begin(), ranking.end(), [](const std::pair<std::string, uint64_t>& a,
+						const std::pair<std::string, uint64_t>& b) { return a.second > b.second; });
+	if(ranking.size() > n) ranking.resize(n);
+	return ranking;
+}
+
+ParserStats::Ranking ParserStats::HotProductions(size_t n){
+	std::map<std::string, uint64_t> counts;
+	for(const auto& p : Total().productions) counts[p.second.name] += p.second.count;
+	return _top(counts, n);
+}
+
+ParserStats::Ranking ParserStats::HotNonTerminals(size_t n){
+	std::map<std::string, uint64_t> counts;
+	for(const auto& p : Total().productions) counts[p.second.name.substr(0, p.second.name.find(' '))] += p.second.count;
+	return _top(counts, n);
+}
+
+ParserStats::Ranking ParserStats::HotCells(size_t n){
+	std::map<std::string, uint64_t> counts;
+	for(const auto& c : Total().cells) counts[c.second.name] += c.second.count;
+	return _top(counts, n);
+}
+
+void ParserStats::Report(std::ostream& out, size_t n){
+	ParserStatsSlot total = Total();
+	double seconds = static_cast<double>(total.nanoseconds) / 1e9;
+	out << total.parses << " parses, " << total.tokens << " tokens";
+	if(seconds > 0) out << ", " << static_cast<uint64_t>(static_cast<double>(total.tokens) / seconds) << " tokens/s";
+	out << std::endl;
+	out << total.lookups << " table lookups, " << total.expansions << " expansions, " << total.epsilonPops
+		<< " epsilon pops, max stack depth " << total.maxStackDepth << std::endl;
+
+	auto print = [&out](const char* title, const Ranking& ranking) {
+		out << title << std::endl;
+		for(const auto& r : ranking) out << "  " << r.second << "\t" << r.first << std::endl;
+	};
+	print("hot productions:", HotProductions(n));
+	print("hot nonterminals:", HotNonTerminals(n));
+	print("hot table cells:", HotCells(n));
+}
+
+void ParserStats::Reset(){
+	ParserStatsRegistry& registry = _registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for(auto& slot : registry.slots){
+		ParserStatsSlot& s = *slot;
+		s.parses = s.tokens = s.lookups = s.expansions = s.epsilonPops = s.maxStackDepth = s.nanoseconds = 0;
+		s.productions.clear();
+		s.cells.clear();
+	}
+}
@@ -0,0 +1,86 @@
+#include <sstream>
+#include "gtest/gtest.h"
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "parser_stats.h"
+#include "syntax/test_grammar.h"
+
+static std::unique_ptr<ContextFreeGrammar> ExpressionGrammar(){
+	return TestGrammar("parser_stats_test.syn", { "<E>-><T><E1>", "<E1>->+<T><E1>|#", "<T>->id|(<E>)" }, false);
+}
+
+#ifdef QCOMPILER_ENABLE_PARSER_STATS
+TEST(ParserStatsTest, Counters){
+	std::unique_ptr<ContextFreeGrammar> gram = ExpressionGrammar();
+	CompiledGrammar compiled(*gram);
+	ParserStats::Reset();
+
+	//E -> T E1, T -> id, E1 -> + T E1, T -> id, E1 -> #
+	std::vector<std::string> sen{ "id", "+", "id" };
+	ASSERT_TRUE(gram->LL1Parsing(sen)->IsAccepted());
+	ASSERT_TRUE(compiled.Parse(sen)->IsAccepted());
+
+	ParserStatsSlot total = ParserStats::Total();
+	EXPECT_EQ(total.parses, 2u);
+	EXPECT_EQ(total.tokens, 6u);
+	EXPECT_EQ(total.expansions, 10u);
+	EXPECT_EQ(total.lookups, 10u);
+	EXPECT_EQ(total.epsilonPops, 2u);
+	EXPECT_EQ(total.maxStackDepth, 4u); //$ E1 T + after E1 -> + T E1
+
+	ParserStats::Ranking hot = ParserStats::HotProductions(1);
+	ASSERT_EQ(hot.size(), 1u);
+	EXPECT_EQ(hot[0].first, "T -> id");
+	EXPECT_EQ(hot[0].second, 4u);
+	ParserStats::Ranking nonterms = ParserStats::HotNonTerminals(10);
+	ASSERT_EQ(nonterms.size(), 3u);
+	EXPECT_EQ(nonterms[0].second, 4u);
+	ParserStats::Ranking cells = ParserStats::HotCells(10);
+	EXPECT_NE(std::find(cells.begin(), cells.end(), std::make_pair(std::string("[E1, $] E1 -> #"), uint64_t(2))), cells.end());
+
+	std::ostringstream report;
+	ParserStats::Report(report, 3);
+	EXPECT_NE(report.str().find("hot productions:"), std::string::npos);
+
+	ParserStats::Reset();
+	EXPECT_EQ(ParserStats::Total().parses, 0u);
+}
+
+static std::unique_ptr<ContextFreeGrammar> ListGrammar(const std::string& item){
+	return TestGrammar("parser_stats_test.syn", { "<L>->" + item + "<L>|#" }, false);
+}
+
+//grammars created and destroyed in turn may reuse the addresses, the counters must not be mixed up
+TEST(ParserStatsTest, GrammarsReusingAddresses){
+	ParserStats::Reset();
+	for(int i = 0; i < 10; i++){
+		std::unique_ptr<ContextFreeGrammar> a = ListGrammar("a");
+		std::unique_ptr<CompiledGrammar> compiled(new CompiledGrammar(*a));
+		ASSERT_TRUE(compiled->Parse(std::vector<std::string>{ "a" })->IsAccepted());
+		ASSERT_TRUE(a->LL1Parsing(std::vector<std::string>{ "a" })->IsAccepted());
+		compiled.reset(), a.reset();
+
+		std::unique_ptr<ContextFreeGrammar> c = ListGrammar("c");
+		compiled.reset(new CompiledGrammar(*c));
+		ASSERT_TRUE(compiled->Parse(std::vector<std::string>(10, "c"))->IsAccepted());
+		ASSERT_TRUE(c->LL1Parsing(std::vector<std::string>(10, "c"))->IsAccepted());
+	}
+	ParserStats::Ranking hot = ParserStats::HotProductions(10);
+	std::map<std::string, uint64_t> counts(hot.begin(), hot.end());
+	EXPECT_EQ(counts["L -> a L"], 20u);
+	EXPECT_EQ(counts["L -> c L"], 200u);
+	ParserStats::Reset();
+}
+#else
+TEST(ParserStatsTest, CompiledOut){
+	std::unique_ptr<ContextFreeGrammar> gram = ExpressionGrammar();
+	ASSERT_TRUE(gram->LL1Parsing(std::vector<std::string>{ "id" })->IsAccepted());
+	EXPECT_EQ(ParserStats::Total().parses, 0u);
+	EXPECT_TRUE(ParserStats::HotProductions(10).empty());
+}
+#endif
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -4,18 +4,17 @@
 #include "factory_template.h"
 #include "syntax/grammar_generator_factory.h"
 #include "utility/file_reader.h"
-#include "utility/file_reader_factory.h"
-#include "utility/q_file_reader.h"
 #include "utility/utility_internal.h"
 #include "factory_template.h"
 
 class QGrammarGenerator final : public GrammarGenerator{
 public:	
-	QGrammarGenerator() : fileReader_(nullptr){
-		FileReaderFactory* factory = FileReaderFactoryRegistry::GetFactory("QFileReader");
-		FileReader* reader = factory->CreateFileReader().release();
-		QFileReader* qreader = dynamic_cast<QFileReader*>(reader);
-		fileReader_.reset(qreader);
+	QGrammarGenerator() : fileReader_(CreateFileReader("QFileReader")){}
+	bool SetFileReader(const std::string& name) override{
+		std::unique_ptr<FileReader> reader = CreateFileReader(name);
+		if(!reader) return false;
+		fileReader_ = std::move(reader);
+		return true;
 	}
 	virtual bool OpenFile(const std::string& file) override{
 		return fileReader_->OpenFile(file);
@@ -25,7 +24,7 @@ public:
 private:
 	void _parseSentence(std::string sentence, std::vector<std::string>& contents,
 		std::vector<bool>& isTerm);
-	std::unique_ptr<QFileReader> fileReader_;
+	std::unique_ptr<FileReader> fileReader_;
 };
 
 /* GrammarGenerate() function reads grammar definition file and generate ContextFreeGrammar object.
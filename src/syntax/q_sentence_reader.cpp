@@ -5,23 +5,22 @@
 #include "factory_template.h"
 #include "syntax/sentence_reader_factory.h"
 #include "utility/file_reader.h"
-#include "utility/file_reader_factory.h"
-#include "utility/q_file_reader.h"
 #include "utility/utility_internal.h"
 
 class QSentenceReader : public SentenceReader{
 public:
-	QSentenceReader() : fileReader_(nullptr){
-		FileReaderFactory* factory = FileReaderFactoryRegistry::GetFactory("QFileReader");
-		FileReader* reader = factory->CreateFileReader().release();
-		QFileReader* qreader = dynamic_cast<QFileReader*>(reader);
-		fileReader_.reset(qreader);
+	QSentenceReader() : fileReader_(CreateFileReader("QFileReader")){}
+	bool SetFileReader(const std::string& name) override{
+		std::unique_ptr<FileReader> reader = CreateFileReader(name);
+		if(!reader) return false;
+		fileReader_ = std::move(reader);
+		return true;
 	}
 	
 	std::vector<std::string> ReadFile(const std::string& file) override;
 
 private:
-	std::unique_ptr<QFileReader> fileReader_;
+	std::unique_ptr<FileReader> fileReader_;
 };
 
 std::vector<std::string> QSentenceReader::ReadFile(const std::string& file){
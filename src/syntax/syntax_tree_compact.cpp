@@ -0,0 +1,133 @@
+#include <memory>
+#include <vector>
+#include "syntax_specific.h"
+
+static bool _isInner(const SyntaxNode* node, const std::string& innerPrefix){
+	return node->type == SyntaxNode::NONTERMINAL && node->term.compare(0, innerPrefix.size(), innerPrefix) == 0;
+}
+
+static bool _isEpsilon(const SyntaxNode* node){
+	return node->term == ContextFreeGrammar::Epsilon;
+}
+
+void SyntaxTree::Compact(const std::string& innerPrefix){
+	std::vector<std::unique_ptr<SyntaxNode>> children;
+	children.swap(head->children);
+
+	for(auto& child : children){
+		if(child->type == SyntaxNode::FINISH) continue;
+		std::unique_ptr<SyntaxNode> node = _compactNode(std::move(child), innerPrefix);
+		if(node) head->children.push_back(std::move(node));
+	}
+	counter = _countNodes(head.get());
+}
+
+/* One nonterminal being compacted: its children are compacted one by one and the non-empty ones are
+ * appended to 'parent'. At first 'parent' is the nonterminal itself, then it is each level of the inner
+ * tail in turn(see _nextTailLevel()).
+ */
+struct CompactFrame {
+	std::string name;
+	std::unique_ptr<SyntaxNode> parent;
+	std::vector<std::unique_ptr<SyntaxNode>> items;
+	size_t next{ 0 };
+	std::unique_ptr<SyntaxNode> tail;
+	bool folding{ false };
+};
+
+/* An inner tail looks like: <A1>->op<B><A1>|#. Each level of the tail takes the current left operand as
+ * its first child, so 'a op1 b op2 c' is folded as op2(op1(a, b), c). If a level does not begin with a
+ * terminal(this comes from left factoring), its children are appended to a node named after the
+ * original nonterminal instead. Returns false if the tail has no more levels.
+ */
+static bool _nextTailLevel(CompactFrame& frame, std::unique_ptr<SyntaxNode>& left, const std::string& innerPrefix){
+	while(frame.tail){
+		std::vector<std::unique_ptr<SyntaxNode>> items;
+		items.swap(frame.tail->children);
+
+		std::unique_ptr<SyntaxNode> next;
+		if(!items.empty() && _isInner(items.back().get(), innerPrefix)){
+			next = std::move(items.back());
+			items.pop_back();
+		}
+		frame.tail = std::move(next);
+		if(items.size() == 1 && _isEpsilon(items[0].get())) continue;
+
+		size_t beg = 0;
+		if(items.size() >= 2 && items[0]->type == SyntaxNode::TERMINAL){
+			frame.parent = std::move(items[0]); //the operator
+			beg = 1;
+		}
+		else frame.parent.reset(new SyntaxNode(frame.name, SyntaxNode::NONTERMINAL));
+
+		if(left) frame.parent->children.push_back(std::move(left));
+		frame.items.swap(items);
+		frame.next = beg;
+		frame.folding = true;
+		return true;
+	}
+	return false;
+}
+
+/* Returns nullptr if the whole subtree derives epsilon. For nonterminal <A>, if the last child is an
+ * inner tail, the children before the tail is the left operand, and the tail is folded into it level by
+ * level. Otherwise, <A> is kept only when it has more than one non-empty child.
+ * Compacted trees of long sentences are very deep, the nonterminals are kept in an explicit stack.
+ */
+std::unique_ptr<SyntaxNode> SyntaxTree::_compactNode(std::unique_ptr<SyntaxNode> node, const std::string& innerPrefix){
+	std::vector<CompactFrame> stack;
+	std::unique_ptr<SyntaxNode> result;
+
+	//returns true if the node is done and in 'result', otherwise a frame is pushed for it
+	auto enter = [&stack, &result, &innerPrefix](std::unique_ptr<SyntaxNode> n) {
+		if(_isEpsilon(n.get())) { result.reset(); return true; }
+		if(n->type != SyntaxNode::NONTERMINAL) { result = std::move(n); return true; }
+
+		CompactFrame frame;
+		frame.name = n->term;
+		frame.items.swap(n->children);
+		if(!frame.items.empty() && _isInner(frame.items.back().get(), innerPrefix)){
+			frame.tail = std::move(frame.items.back());
+			frame.items.pop_back();
+		}
+		frame.parent = std::move(n);
+		stack.push_back(std::move(frame));
+		return false;
+	};
+
+	if(enter(std::move(node))) return result;
+	while(true){
+		CompactFrame& frame = stack.back();
+		if(frame.next < frame.items.size()){
+			if(!enter(std::move(frame.items[frame.next++]))) continue;
+			if(result) stack.back().parent->children.push_back(std::move(result));
+			continue;
+		}
+
+		std::unique_ptr<SyntaxNode> left;
+		std::unique_ptr<SyntaxNode>& parent = frame.parent;
+		if(!frame.folding){
+			if(parent->children.size() == 1) left = std::move(parent->children[0]); //unit chain
+			else if(parent->children.size() > 1) left = std::move(parent);
+		}
+		else if(parent->children.size() == 1 && parent->type == SyntaxNode::NONTERMINAL) left = std::move(parent->children[0]);
+		else if(!parent->children.empty() || parent->type != SyntaxNode::NONTERMINAL) left = std::move(parent);
+		if(_nextTailLevel(frame, left, innerPrefix)) continue;
+
+		stack.pop_back();
+		if(stack.empty()) return left;
+		if(left) stack.back().parent->children.push_back(std::move(left));
+	}
+}
+
+int SyntaxTree::_countNodes(const SyntaxNode* node){
+	int n = 0;
+	std::vector<const SyntaxNode*> st{ node };
+	while(!st.empty()){
+		const SyntaxNode* cur = st.back();
+		st.pop_back();
+		n++;
+		for(const auto& c : cur->children) st.push_back(c.get());
+	}
+	return n;
+}
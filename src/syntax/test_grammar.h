@@ -0,0 +1,34 @@
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "syntax_specific.h"
+
+/* Grammar fixture of the tests. The lines are written to 'file' and generated into a grammar. */
+inline std::unique_ptr<ContextFreeGrammar> GenerateTestGrammar(const std::string& file, const std::vector<std::string>& lines){
+	std::ofstream outfile(file);
+	for(const auto& l : lines) outfile << l << std::endl;
+	outfile.close();
+
+	std::unique_ptr<GrammarGenerator> gen = CreateGrammarGenerator("QGrammarGeneratorFactory");
+	gen->OpenFile(file);
+	std::unique_ptr<ContextFreeGrammar> gram(new ContextFreeGrammar(gen->GrammarGenerate()));
+	return gram;
+}
+
+/* The same, then the grammar is transformed and its FIRST/FOLLOW/SELECT sets and LL(1) table are built.
+ * ll1table points to the productions, so the grammar stays where it is built and is handed out by pointer.
+ */
+inline std::unique_ptr<ContextFreeGrammar> TestGrammar(const std::string& file, const std::vector<std::string>& lines,
+						bool elimLeftRecur = true, bool leftFactoring = false){
+	std::unique_ptr<ContextFreeGrammar> gram = GenerateTestGrammar(file, lines);
+	if(elimLeftRecur) gram->ElimLeftRecur();
+	if(leftFactoring) gram->LeftFactoring();
+	gram->GetFirstTable();
+	gram->GetFollowTable();
+	gram->GetSelectTable();
+	gram->ConstructLL1Table();
+	return gram;
+}
@@ -0,0 +1,217 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "alloc_stats.h"
+#include "idstatebuilder.h"
+#include "syntax_specific.h"
+
+struct AllocStageCounters {
+	std::atomic<const char*> name{ nullptr };
+	std::atomic<uint64_t> allocations{ 0 };
+	std::atomic<uint64_t> bytes{ 0 };
+	std::atomic<uint64_t> live{ 0 };
+	std::atomic<uint64_t> peak{ 0 };
+};
+
+//zero initialized, so the counters can be used by operator new before any constructor has run
+static AllocStageCounters stage_counters[AllocStats::MAX_STAGES];
+static std::atomic<int> stage_count{ 1 }; //stage 0 is out of any stage
+static thread_local int current_stage = 0;
+
+static std::mutex& _stageMutex(){
+	static std::mutex mutex;
+	return mutex;
+}
+
+int AllocStats::StageId(const char* name){
+	std::lock_guard<std::mutex> lock(_stageMutex());
+	int n = stage_count.load();
+	for(int i = 1; i < n; i++)
+		if(std::strcmp(stage_counters[i].name.load(), name) == 0) return i;
+	if(n == MAX_STAGES) return 0;
+	stage_counters[n].name.store(name);
+	stage_count.store(n + 1);
+	return n;
+}
+
+AllocStageScope::AllocStageScope(int stage) : previous_(current_stage) {
+	current_stage = stage;
+}
+
+AllocStageScope::~AllocStageScope() {
+	current_stage = previous_;
+}
+
+#ifdef QCOMPILER_ENABLE_ALLOC_STATS
+
+/* Every block has a header in front of it holding the size and the stage. The header is as large as the
+ * alignment malloc guarantees, so the block handed out keeps that alignment.
+ */
+union AllocHeader {
+	struct {
+		size_t size;
+		int stage;
+	} info;
+	std::max_align_t align;
+};
+
+static void* _countedAlloc(size_t size){
+	void* raw = std::malloc(sizeof(AllocHeader) + (size ? size : 1));
+	if(!raw) return nullptr;
+	AllocHeader* header = static_cast<AllocHeader*>(raw);
+	header->info.size = size;
+	header->info.stage = current_stage;
+
+	AllocStageCounters& c = stage_counters[current_stage];
+	c.allocations.fetch_add(1, std::memory_order_relaxed);
+	c.bytes.fetch_add(size, std::memory_order_relaxed);
+	uint64_t live = c.live.fetch_add(size, std::memory_order_relaxed) + size;
+	uint64_t peak = c.peak.load(std::memory_order_relaxed);
+	while(live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+	return header + 1;
+}
+
+static void _countedFree(void* ptr){
+	if(!ptr) return;
+	AllocHeader* header = static_cast<AllocHeader*>(ptr) - 1;
+	stage_counters[header->info.stage].live.fetch_sub(header->info.size, std::memory_order_relaxed);
+	std::free(header);
+}
+
+void* operator new(size_t size){
+	void* p = _countedAlloc(size);
+	if(!p) throw std::bad_alloc();
+	return p;
+}
+void* operator new[](size_t size){ return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return _countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return _countedAlloc(size); }
+void operator delete(void* ptr) noexcept { _countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { _countedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { _countedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { _countedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { _countedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { _countedFree(ptr); }
+
+bool AllocStats::Enabled(){
+	return true;
+}
+
+#else
+
+bool AllocStats::Enabled(){
+	return false;
+}
+
+#endif
+
+std::vector<AllocStageStats> AllocStats::Stages(){
+	std::vector<AllocStageStats> stages;
+	int n = stage_count.load();
+	for(int i = 0; i < n; i++){
+		const AllocStageCounters& c = stage_counters[i];
+		if(c.allocations.load() == 0 && c.live.load() == 0) continue;
+		AllocStageStats s;
+		s.name = i == 0 ? "(none)" : c.name.load();
+		s.allocations = c.allocations.load();
+		s.bytes = c.bytes.load();
+		s.live = c.live.load();
+		s.peak = c.peak.load();
+		stages.push_back(s);
+	}
+	return stages;
+}
+
+void AllocStats::Report(std::ostream& out){
+	if(!Enabled()){
+		out << "allocation accounting is compiled out, see QCOMPILER_ENABLE_ALLOC_STATS" << std::endl;
+		return;
+	}
+	out << "stage\tallocations\tbytes\tpeak\tlive" << std::endl;
+	for(const auto& s : Stages())
+		out << s.name << "\t" << s.allocations << "\t" << s.bytes << "\t" << s.peak << "\t" << s.live << std::endl;
+}
+
+void AllocStats::Reset(){
+	int n = stage_count.load();
+	for(int i = 0; i < n; i++){
+		AllocStageCounters& c = stage_counters[i];
+		c.allocations.store(0);
+		c.bytes.store(0);
+		c.peak.store(c.live.load());
+	}
+}
+
+//rb-tree node header of std::set and std::map: color and three links
+static const size_t TREE_NODE_BYTES = 4 * sizeof(void*);
+
+static size_t _heapBytes(const std::string& str){
+	return str.capacity() > 15 ? str.capacity() + 1 : 0;
+}
+
+static size_t _setBytes(const std::set<std::string>& st){
+	size_t bytes = 0;
+	for(const auto& s : st) bytes += TREE_NODE_BYTES + sizeof(std::string) + _heapBytes(s);
+	return bytes;
+}
+
+static size_t _vectorBytes(const std::vector<std::string>& vec){
+	size_t bytes = vec.capacity() * sizeof(std::string);
+	for(const auto& s : vec) bytes += _heapBytes(s);
+	return bytes;
+}
+
+template<typename Map, typename ValueBytes>
+static size_t _mapBytes(const Map& mp, ValueBytes value_bytes){
+	size_t bytes = 0;
+	for(const auto& kv : mp)
+		bytes += TREE_NODE_BYTES + sizeof(typename Map::value_type) + _heapBytes(kv.first) + value_bytes(kv.second);
+	return bytes;
+}
+
+size_t ResidentBytes(const DFA& dfa){
+	size_t bytes = sizeof(DFA) + dfa.table_.capacity() * sizeof(std::map<char, int>) + dfa.isTerminal_.capacity() / 8;
+	for(const auto& row : dfa.table_) bytes += row.size() * (TREE_NODE_BYTES + sizeof(std::pair<const char, int>));
+	return bytes;
+}
+
+size_t ResidentBytes(const ContextFreeGrammar& grammar){
+	auto set_bytes = [](const std::set<std::string>& st) { return _setBytes(st); };
+	size_t bytes = sizeof(ContextFreeGrammar) + _heapBytes(grammar.startSymbol);
+	bytes += _setBytes(grammar.nonTerminals) + _setBytes(grammar.terminals);
+	bytes += _mapBytes(grammar.productions, [](const std::vector<std::string>& rhs) { return _vectorBytes(rhs); });
+	bytes += _mapBytes(grammar.first.table, set_bytes) + _mapBytes(grammar.follow.table, set_bytes);
+	for(const auto& s : grammar.select)
+		bytes += TREE_NODE_BYTES + sizeof(ContextFreeGrammar::SelectTable::value_type) + _setBytes(s.second);
+	bytes += _mapBytes(grammar.nullable.table, [](bool) { return size_t(0); });
+	bytes += _mapBytes(grammar.ll1table.table, [](const ContextFreeGrammar::LL1Table::LL1TableRow& row) {
+		return _mapBytes(row, [](const ContextFreeGrammar::Production*) { return size_t(0); });
+	});
+	bytes += _mapBytes(grammar.usedIn, set_bytes);
+	return bytes;
+}
+
+//from a vector stack, the tree of a long sentence is too deep to recurse
+static size_t _nodeBytes(const SyntaxNode* root){
+	size_t bytes = 0;
+	std::vector<const SyntaxNode*> st{ root };
+	while(!st.empty()){
+		const SyntaxNode* node = st.back();
+		st.pop_back();
+		bytes += sizeof(SyntaxNode) + _heapBytes(node->term) + node->children.capacity() * sizeof(node->children[0]);
+		for(const auto& child : node->children) if(child) st.push_back(child.get());
+	}
+	return bytes;
+}
+
+size_t ResidentBytes(const SyntaxTree& tree){
+	size_t bytes = sizeof(SyntaxTree) + _heapBytes(tree.headName);
+	if(tree.head) bytes += _nodeBytes(tree.head.get());
+	bytes += tree.diagnostics.capacity() * sizeof(ParseDiagnostic);
+	for(const auto& d : tree.diagnostics) bytes += _heapBytes(d.token) + _heapBytes(d.expected);
+	return bytes;
+}
@@ -0,0 +1,82 @@
+#include <memory>
+#include <thread>
+#include "gtest/gtest.h"
+#include "alloc_stats.h"
+#include "idstatebuilder.h"
+#include "syntax_specific.h"
+#include "syntax/test_grammar.h"
+
+static std::unique_ptr<ContextFreeGrammar> ExpressionGrammar(){
+	return GenerateTestGrammar("alloc_stats_test.syn", { "<E>-><E>+<T>|<T>", "<T>->id|(<E>)" });
+}
+
+TEST(AllocStatsTest, ResidentBytes){
+	std::unique_ptr<ContextFreeGrammar> gram = ExpressionGrammar();
+	size_t loaded = ResidentBytes(*gram);
+	EXPECT_GT(loaded, sizeof(ContextFreeGrammar));
+	gram->ElimLeftRecur();
+	gram->GetFirstTable();
+	gram->GetFollowTable();
+	gram->GetSelectTable();
+	gram->ConstructLL1Table();
+	EXPECT_GT(ResidentBytes(*gram), loaded);
+
+	std::unique_ptr<SyntaxTree> small = gram->LL1Parsing(std::vector<std::string>{ "id" });
+	std::unique_ptr<SyntaxTree> large = gram->LL1Parsing(std::vector<std::string>{ "id", "+", "(", "id", ")" });
+	EXPECT_GT(ResidentBytes(*large), ResidentBytes(*small));
+
+	//the tree of a long sentence is too deep to be walked recursively
+	std::vector<std::string> sentence{ "id" };
+	for(int i = 0; i < 200000; i++) sentence.insert(sentence.end(), { "+", "id" });
+	std::unique_ptr<SyntaxTree> deep = gram->LL1Parsing(sentence);
+	ASSERT_TRUE(deep->IsAccepted());
+	EXPECT_GT(ResidentBytes(*deep), 200000 * sizeof(SyntaxNode));
+
+	DFA dfa(3);
+	dfa.StateSet(0, 'a', 1);
+	size_t one = ResidentBytes(dfa);
+	dfa.StateSet(1, 'b', 2);
+	EXPECT_GT(ResidentBytes(dfa), one);
+}
+
+#ifdef QCOMPILER_ENABLE_ALLOC_STATS
+static const AllocStageStats* FindStage(const std::vector<AllocStageStats>& stages, const std::string& name){
+	for(const auto& s : stages) if(s.name == name) return &s;
+	return nullptr;
+}
+
+TEST(AllocStatsTest, Stages){
+	EXPECT_TRUE(AllocStats::Enabled());
+	EXPECT_EQ(AllocStats::StageId("alloc_stats_test"), AllocStats::StageId("alloc_stats_test"));
+	AllocStats::Reset();
+
+	std::vector<std::unique_ptr<char[]>> kept;
+	kept.reserve(10);
+	{
+		QC_STAGE("alloc_stats_test");
+		for(int i = 0; i < 10; i++) kept.emplace_back(new char[100]);
+		std::unique_ptr<char[]> temp(new char[5000]);
+	}
+	//freed by another thread, still charged to the stage which allocated it
+	std::thread t([&kept]() { kept.pop_back(); });
+	t.join();
+	std::vector<AllocStageStats> stages = AllocStats::Stages();
+	const AllocStageStats* s = FindStage(stages, "alloc_stats_test");
+	ASSERT_TRUE(s != nullptr);
+	EXPECT_EQ(s->allocations, 11u);
+	EXPECT_EQ(s->bytes, 6000u);
+	EXPECT_EQ(s->live, 900u);
+	EXPECT_EQ(s->peak, 6000u);
+
+	std::unique_ptr<ContextFreeGrammar> gram = ExpressionGrammar();
+	gram->ElimLeftRecur();
+	s = FindStage(AllocStats::Stages(), "ElimLeftRecur");
+	ASSERT_TRUE(s != nullptr);
+	EXPECT_GT(s->allocations, 0u);
+}
+#endif
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
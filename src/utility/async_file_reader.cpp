@@ -0,0 +1,98 @@
+#include <string>
+#include <thread>
+#include "error.h"
+#include "utility/file_reader.h"
+#include "utility/file_reader_factory.h"
+#include "utility/async_file_reader.h"
+
+AsyncFileReader::AsyncFileReader(size_t bufferSize, size_t bufferCount)
+	: bufferSize_(bufferSize == 0 ? 1 : bufferSize), buffers_(bufferCount < 2 ? 2 : bufferCount),
+	filled_(buffers_.size()), free_(buffers_.size()) {
+}
+
+AsyncFileReader::~AsyncFileReader(){
+	_stop();
+}
+
+bool AsyncFileReader::SetFilePath(const std::string& file) {
+	if(fileOpened_) GENERATE_ERRMSG_PUSH(FILE_OPENED, this);
+	else filePath_ = file;
+	return !fileOpened_;
+}
+
+std::string AsyncFileReader::GetFilePath() const {
+	return filePath_;
+}
+
+bool AsyncFileReader::OpenFile(const std::string& file){
+	if(fileOpened_) {
+		GENERATE_ERRMSG_PUSH(FILE_OPENED, this);
+		return false;
+	}
+
+	filePath_ = file;
+	file_.open(filePath_, std::ios::binary);
+	if(!file_) {
+		GENERATE_ERRMSG_PUSH(FILE_CANNOT_OPEN, this);
+		return false;
+	}
+
+	for(size_t i = 0; i < buffers_.size(); i++){
+		buffers_[i].resize(bufferSize_);
+		free_.TryPush(i);
+	}
+	fileOpened_ = true;
+	ioThread_ = std::thread(&AsyncFileReader::_readAhead, this);
+	_resetWindow();
+	return true;
+}
+
+/* Runs in the I/O thread, the only producer of filled_ and consumer of free_. It waits for a free
+ * buffer, and stops when free_ is closed by _stop().
+ */
+void AsyncFileReader::_readAhead(){
+	size_t buffer;
+	while(free_.Pop(buffer)){
+		file_.read(buffers_[buffer].data(), static_cast<std::streamsize>(bufferSize_));
+		//a short read at the end of file sets failbit too, only badbit is an I/O error
+		const bool failed = file_.bad();
+		Chunk chunk{ buffer, failed ? 0 : static_cast<size_t>(file_.gcount()), failed };
+		if(!filled_.Push(chunk) || chunk.length == 0) return;
+	}
+}
+
+//the consumer side, the buffer of the last window is given back before waiting for the next one
+bool AsyncFileReader::_nextWindow(const char*& begin, const char*& end){
+	if(!fileOpened_ || finished_) return false;
+	if(holding_) free_.TryPush(held_), holding_ = false; //never full, there are only buffers_.size() buffers
+
+	Chunk chunk{ 0, 0, false };
+	if(!filled_.Pop(chunk) || chunk.length == 0) {
+		if(chunk.failed) GENERATE_ERRMSG_PUSH(FILE_READ_FAILED, this);
+		finished_ = true;
+		return false;
+	}
+
+	holding_ = true, held_ = chunk.buffer;
+	begin = buffers_[chunk.buffer].data();
+	end = begin + chunk.length;
+	return true;
+}
+
+void AsyncFileReader::_stop(){
+	free_.Close();
+	filled_.Close();
+	if(ioThread_.joinable()) ioThread_.join();
+	if(fileOpened_) file_.close();
+	fileOpened_ = false;
+}
+
+class AsyncFileReaderFactory : public FileReaderFactory{
+public:
+	std::unique_ptr<FileReader> CreateFileReader(){
+		std::unique_ptr<FileReader> reader(new AsyncFileReader);
+		return reader;
+	}
+};
+
+FACTORY_REGISTRAR_DEFINE("AsyncFileReader", FileReader, AsyncFileReaderFactory);
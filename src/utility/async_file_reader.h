@@ -0,0 +1,61 @@
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utility/file_reader.h"
+#include "utility/spsc_queue.h"
+
+/* For the inputs which cannot be mapped(pipes, network file systems), an I/O thread reads the file ahead
+ * into a ring of large buffers, so scanning overlaps with reading. Full buffers are handed to the reader
+ * through one SpscQueue and returned to the I/O thread through another one, an empty chunk marks the
+ * end of file. Both threads block on the queues when there is nothing to do, so an idle reader does not
+ * take any CPU.
+ */
+class AsyncFileReader final : public FileReader {
+public:
+	static const size_t DEFAULT_BUFFER_SIZE{ 1 << 20 };
+	static const size_t DEFAULT_BUFFER_COUNT{ 4 };
+
+	explicit AsyncFileReader(size_t bufferSize = DEFAULT_BUFFER_SIZE, size_t bufferCount = DEFAULT_BUFFER_COUNT);
+	~AsyncFileReader();
+
+	bool SetFilePath(const std::string& file) override;
+
+	std::string GetFilePath() const override;
+
+	bool OpenFile(const std::string& file) override;
+
+	bool IsFileOpened() const { return fileOpened_; }
+
+protected:
+	//waits for the next buffer filled by the I/O thread
+	bool _nextWindow(const char*& begin, const char*& end) override;
+
+private:
+	struct Chunk {
+		size_t buffer;
+		size_t length; //0 means the end of file
+		bool failed;   //the file cannot be read any more, the length is 0
+	};
+
+	void _readAhead();
+	void _stop();
+
+	std::string filePath_;
+	bool fileOpened_{ false };
+	std::ifstream file_;
+
+	const size_t bufferSize_;
+	std::vector<std::vector<char>> buffers_;
+	SpscQueue<Chunk> filled_; //I/O thread -> reader
+	SpscQueue<size_t> free_;  //reader -> I/O thread
+
+	bool holding_{ false }; //the reader is scanning buffers_[held_]
+	size_t held_{ 0 };
+	bool finished_{ false };
+
+	std::thread ioThread_;
+};
@@ -0,0 +1,114 @@
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include "gtest/gtest.h"
+#include "error.h"
+#include "utility/file_reader.h"
+#include "utility/async_file_reader.h"
+#include "utility/spsc_queue.h"
+
+TEST(SpscQueueTest, ProducerAndConsumer){
+	SpscQueue<int> queue(5);
+	EXPECT_EQ(queue.Capacity(), 8u);
+
+	const int count = 200000;
+	std::thread producer([&queue]() {
+		for(int i = 0; i < count; i++)
+			while(!queue.TryPush(i)) std::this_thread::yield();
+	});
+
+	int expect = 0, item;
+	while(expect < count){
+		if(!queue.TryPop(item)) { std::this_thread::yield(); continue; }
+		ASSERT_EQ(item, expect);
+		expect++;
+	}
+	producer.join();
+	EXPECT_FALSE(queue.TryPop(item));
+}
+
+TEST(SpscQueueTest, BlockingPushAndPop){
+	SpscQueue<int> queue(2);
+	const int count = 20000;
+	size_t stalls = 0;
+	std::thread producer([&queue, &stalls]() {
+		bool stalled;
+		for(int i = 0; i < count; i++){
+			ASSERT_TRUE(queue.Push(i, &stalled));
+			stalls += stalled;
+		}
+		queue.Close();
+	});
+
+	int expect = 0, item;
+	while(queue.Pop(item)) EXPECT_EQ(item, expect++);
+	producer.join();
+	EXPECT_EQ(expect, count);
+	EXPECT_LE(stalls, static_cast<size_t>(count));
+
+	//a producer waiting on the full queue gives up when it is closed
+	SpscQueue<int> full(1);
+	ASSERT_TRUE(full.TryPush(0));
+	std::thread waiter([&full]() { EXPECT_FALSE(full.Push(1)); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	full.Close();
+	waiter.join();
+	EXPECT_TRUE(full.Pop(item)); //pushed before Close()
+	EXPECT_FALSE(full.Pop(item));
+}
+
+TEST(AsyncFileReaderTest, SameAsQFileReader){
+	std::string text;
+	for(int i = 0; i < 5000; i++) text += "id + num * ( id ) " + std::to_string(i) + "\n";
+	std::ofstream outfile("async_file_reader_test.txt", std::ios::binary);
+	outfile << text;
+	outfile.close();
+
+	//small buffers, so the ring is reused many times
+	AsyncFileReader reader(1000, 3);
+	std::unique_ptr<FileReader> expect = CreateFileReader("QFileReader");
+	ASSERT_TRUE(reader.OpenFile("async_file_reader_test.txt"));
+	ASSERT_TRUE(expect->OpenFile("async_file_reader_test.txt"));
+	while(!expect->IsFileEnd()){
+		ASSERT_FALSE(reader.IsFileEnd());
+		EXPECT_EQ(reader.ReadLine(), expect->ReadLine());
+	}
+	EXPECT_TRUE(reader.IsFileEnd());
+	EXPECT_EQ(reader.Offset(), text.size());
+	EXPECT_EQ(reader.LineNumber(), expect->LineNumber());
+}
+
+TEST(AsyncFileReaderTest, CloseBeforeTheEnd){
+	std::string text(1 << 20, 'a');
+	std::ofstream outfile("async_file_reader_test.txt", std::ios::binary);
+	outfile << text;
+	outfile.close();
+
+	std::unique_ptr<FileReader> reader = CreateFileReader("AsyncFileReader");
+	ASSERT_TRUE(reader->OpenFile("async_file_reader_test.txt"));
+	EXPECT_EQ(reader->Take(10), "aaaaaaaaaa");
+	reader.reset(); //the I/O thread must be stopped
+
+	std::unique_ptr<FileReader> missing = CreateFileReader("AsyncFileReader");
+	EXPECT_FALSE(missing->OpenFile("async_file_reader_missing.txt"));
+}
+
+#ifndef _WIN32
+//a directory can be opened but not read, the error is reported instead of an empty file
+TEST(AsyncFileReaderTest, ReadError){
+	ErrorSink sink;
+	{
+		ErrorSinkScope scope(sink);
+		AsyncFileReader reader;
+		if(!reader.OpenFile(".")) return;
+		EXPECT_TRUE(reader.IsFileEnd());
+	}
+	ASSERT_FALSE(sink.errors.empty());
+	EXPECT_EQ(sink.errors.back().errNum, FILE_READ_FAILED);
+}
+#endif
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,185 @@
+#include <cstring>
+#include <string>
+#include "error.h"
+#include "utility/file_reader.h"
+#include "utility/file_reader_factory.h"
+#include "utility/compressed_file_reader.h"
+
+#ifdef QCOMPILER_HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef QCOMPILER_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+struct CompressedFileReader::Decoder {
+#ifdef QCOMPILER_HAS_ZLIB
+	z_stream gzip;
+	bool gzipInited{ false };
+#endif
+#ifdef QCOMPILER_HAS_ZSTD
+	ZSTD_DStream* zstd{ nullptr };
+#endif
+	bool streamEnd{ false }; //the last member or frame has been finished
+
+	~Decoder() {
+#ifdef QCOMPILER_HAS_ZLIB
+		if(gzipInited) inflateEnd(&gzip);
+#endif
+#ifdef QCOMPILER_HAS_ZSTD
+		if(zstd != nullptr) ZSTD_freeDStream(zstd);
+#endif
+	}
+};
+
+CompressedFileReader::CompressedFileReader() : in_(BUFFER_SIZE), out_(BUFFER_SIZE) {}
+
+CompressedFileReader::~CompressedFileReader(){
+	_closeFile();
+}
+
+CompressedFileReader::Format CompressedFileReader::DetectFormat(const char* magic, size_t len){
+	const unsigned char* m = reinterpret_cast<const unsigned char*>(magic);
+	if(len >= 2 && m[0] == 0x1f && m[1] == 0x8b) return GZIP;
+	if(len >= 4 && m[0] == 0x28 && m[1] == 0xb5 && m[2] == 0x2f && m[3] == 0xfd) return ZSTD;
+	return PLAIN;
+}
+
+bool CompressedFileReader::SetFilePath(const std::string& file) {
+	if(fileOpened_) GENERATE_ERRMSG_PUSH(FILE_OPENED, this);
+	else filePath_ = file;
+	return !fileOpened_;
+}
+
+std::string CompressedFileReader::GetFilePath() const {
+	return filePath_;
+}
+
+bool CompressedFileReader::OpenFile(const std::string& file){
+	if(fileOpened_) {
+		GENERATE_ERRMSG_PUSH(FILE_OPENED, this);
+		return false;
+	}
+
+	filePath_ = file;
+	file_.open(filePath_, std::ios::binary);
+	if(!file_) {
+		GENERATE_ERRMSG_PUSH(FILE_CANNOT_OPEN, this);
+		return false;
+	}
+
+	inBegin_ = inEnd_ = 0, inputEnd_ = false;
+	_fillInput();
+	format_ = DetectFormat(in_.data(), inEnd_);
+	decoder_.reset(new Decoder);
+
+	bool supported = format_ == PLAIN;
+#ifdef QCOMPILER_HAS_ZLIB
+	if(format_ == GZIP) {
+		std::memset(&decoder_->gzip, 0, sizeof(decoder_->gzip));
+		decoder_->gzipInited = inflateInit2(&decoder_->gzip, 16 + MAX_WBITS) == Z_OK; //16: gzip header
+		supported = decoder_->gzipInited;
+	}
+#endif
+#ifdef QCOMPILER_HAS_ZSTD
+	if(format_ == ZSTD) {
+		decoder_->zstd = ZSTD_createDStream();
+		supported = decoder_->zstd != nullptr && !ZSTD_isError(ZSTD_initDStream(decoder_->zstd));
+	}
+#endif
+	if(!supported) {
+		_closeFile();
+		GENERATE_ERRMSG_PUSH(UNSUPPORTED_COMPRESSION, this);
+		return false;
+	}
+
+	fileOpened_ = true;
+	_resetWindow();
+	return true;
+}
+
+void CompressedFileReader::_closeFile(){
+	decoder_.reset();
+	if(file_.is_open()) file_.close();
+	fileOpened_ = false;
+}
+
+//moves the unused input to the front and reads more, returns false if nothing can be read
+bool CompressedFileReader::_fillInput(){
+	if(inputEnd_) return false;
+	if(inBegin_ != 0) {
+		std::memmove(in_.data(), in_.data() + inBegin_, inEnd_ - inBegin_);
+		inEnd_ -= inBegin_, inBegin_ = 0;
+	}
+	file_.read(in_.data() + inEnd_, static_cast<std::streamsize>(in_.size() - inEnd_));
+	size_t len = static_cast<size_t>(file_.gcount());
+	inEnd_ += len;
+	if(len == 0) inputEnd_ = true;
+	return len != 0;
+}
+
+/* The output of one call may be empty(for example, only a header is consumed), so it loops until some
+ * bytes are produced or the input ends. Concatenated gzip members and zstd frames are all read.
+ */
+bool CompressedFileReader::_nextWindow(const char*& begin, const char*& end){
+	if(!fileOpened_) return false;
+
+	if(format_ == PLAIN) {
+		if(inBegin_ == inEnd_ && !_fillInput()) return false;
+		begin = in_.data() + inBegin_, end = in_.data() + inEnd_;
+		inBegin_ = inEnd_;
+		return true;
+	}
+
+	size_t produced = 0;
+	while(produced == 0) {
+		if(inBegin_ == inEnd_ && !_fillInput()) {
+			if(!decoder_->streamEnd) GENERATE_ERRMSG_PUSH(CORRUPTED_COMPRESSION, this); //truncated
+			return false;
+		}
+		bool failed = false;
+#ifdef QCOMPILER_HAS_ZLIB
+		if(format_ == GZIP) {
+			z_stream& zs = decoder_->gzip;
+			if(decoder_->streamEnd) inflateReset(&zs), decoder_->streamEnd = false; //next member
+			zs.next_in = reinterpret_cast<Bytef*>(in_.data() + inBegin_);
+			zs.avail_in = static_cast<uInt>(inEnd_ - inBegin_);
+			zs.next_out = reinterpret_cast<Bytef*>(out_.data());
+			zs.avail_out = static_cast<uInt>(out_.size());
+			int ret = inflate(&zs, Z_NO_FLUSH);
+			inBegin_ = inEnd_ - zs.avail_in;
+			produced = out_.size() - zs.avail_out;
+			if(ret == Z_STREAM_END) decoder_->streamEnd = true;
+			else if(ret != Z_OK && ret != Z_BUF_ERROR) failed = true;
+		}
+#endif
+#ifdef QCOMPILER_HAS_ZSTD
+		if(format_ == ZSTD) {
+			ZSTD_inBuffer input{ in_.data() + inBegin_, inEnd_ - inBegin_, 0 };
+			ZSTD_outBuffer output{ out_.data(), out_.size(), 0 };
+			size_t ret = ZSTD_decompressStream(decoder_->zstd, &output, &input);
+			inBegin_ += input.pos;
+			produced = output.pos;
+			if(ZSTD_isError(ret)) failed = true;
+			else decoder_->streamEnd = ret == 0; //0 means a frame is finished
+		}
+#endif
+		if(failed) {
+			GENERATE_ERRMSG_PUSH(CORRUPTED_COMPRESSION, this);
+			return false;
+		}
+	}
+
+	begin = out_.data(), end = out_.data() + produced;
+	return true;
+}
+
+class CompressedFileReaderFactory : public FileReaderFactory{
+public:
+	std::unique_ptr<FileReader> CreateFileReader(){
+		std::unique_ptr<FileReader> reader(new CompressedFileReader);
+		return reader;
+	}
+};
+
+FACTORY_REGISTRAR_DEFINE("CompressedFileReader", FileReader, CompressedFileReaderFactory);
@@ -0,0 +1,60 @@
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "utility/file_reader.h"
+
+/* Reads gzip and zstd files by streaming the decompressed data into its window, so a compressed corpus
+ * needs not be decompressed to disk first. The format is detected by the magic bytes, other files are
+ * read as they are. gzip needs zlib(QCOMPILER_HAS_ZLIB) and zstd needs libzstd(QCOMPILER_HAS_ZSTD), if
+ * the library is not built in, OpenFile() fails with UNSUPPORTED_COMPRESSION.
+ */
+class CompressedFileReader final : public FileReader {
+public:
+	enum Format { PLAIN, GZIP, ZSTD };
+
+	static const size_t BUFFER_SIZE{ 1 << 18 };
+
+	CompressedFileReader();
+	~CompressedFileReader();
+
+	bool SetFilePath(const std::string& file) override;
+
+	std::string GetFilePath() const override;
+
+	bool OpenFile(const std::string& file) override;
+
+	bool IsFileOpened() const { return fileOpened_; }
+
+	Format FileFormat() const { return format_; }
+
+	//detected by the first 4 bytes
+	static Format DetectFormat(const char* magic, size_t len);
+
+protected:
+	//decompresses the next part of the file to out_
+	bool _nextWindow(const char*& begin, const char*& end) override;
+
+private:
+	//the streams of the libraries, defined in the .cpp, so the headers of zlib and zstd are not exposed
+	struct Decoder;
+
+	bool _fillInput();
+	void _closeFile();
+
+	std::string filePath_;
+	bool fileOpened_{ false };
+	std::ifstream file_;
+	Format format_{ PLAIN };
+
+	std::vector<char> in_;
+	size_t inBegin_{ 0 };
+	size_t inEnd_{ 0 };
+	bool inputEnd_{ false };
+	std::vector<char> out_;
+
+	std::unique_ptr<Decoder> decoder_;
+};
@@ -0,0 +1,97 @@
+#include <fstream>
+#include "gtest/gtest.h"
+#include "error.h"
+#include "utility/file_reader.h"
+#include "utility/compressed_file_reader.h"
+#ifdef QCOMPILER_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+static std::string Corpus(){
+	std::string text;
+	for(int i = 0; i < 20000; i++) text += "id + num * ( id - " + std::to_string(i) + " )\n";
+	return text;
+}
+
+static std::string ReadAll(FileReader& reader){
+	std::string text;
+	while(!reader.IsFileEnd()) text += reader.ReadLine() + "\n";
+	return text;
+}
+
+TEST(CompressedFileReaderTest, DetectFormat){
+	EXPECT_EQ(CompressedFileReader::DetectFormat("\x1f\x8b\x08\x00", 4), CompressedFileReader::GZIP);
+	EXPECT_EQ(CompressedFileReader::DetectFormat("\x28\xb5\x2f\xfd", 4), CompressedFileReader::ZSTD);
+	EXPECT_EQ(CompressedFileReader::DetectFormat("\x28\xb5", 2), CompressedFileReader::PLAIN);
+	EXPECT_EQ(CompressedFileReader::DetectFormat("id +", 4), CompressedFileReader::PLAIN);
+}
+
+TEST(CompressedFileReaderTest, PlainFile){
+	std::string text = Corpus();
+	std::ofstream outfile("compressed_file_reader_test.txt", std::ios::binary);
+	outfile << text;
+	outfile.close();
+
+	std::unique_ptr<FileReader> reader = CreateFileReader("CompressedFileReader");
+	ASSERT_TRUE(reader->OpenFile("compressed_file_reader_test.txt"));
+	EXPECT_EQ(ReadAll(*reader), text);
+}
+
+#ifdef QCOMPILER_HAS_ZLIB
+TEST(CompressedFileReaderTest, GzipFile){
+	std::string text = Corpus();
+	//two members, 'cat a.gz b.gz' is a valid gzip file too
+	gzFile gz = gzopen("compressed_file_reader_test.gz", "wb");
+	gzwrite(gz, text.data(), static_cast<unsigned>(text.size() / 2));
+	gzclose(gz);
+	gz = gzopen("compressed_file_reader_test.gz", "ab");
+	gzwrite(gz, text.data() + text.size() / 2, static_cast<unsigned>(text.size() - text.size() / 2));
+	gzclose(gz);
+
+	CompressedFileReader reader;
+	ASSERT_TRUE(reader.OpenFile("compressed_file_reader_test.gz"));
+	EXPECT_EQ(reader.FileFormat(), CompressedFileReader::GZIP);
+	EXPECT_EQ(ReadAll(reader), text);
+	EXPECT_EQ(reader.LineNumber(), 20001u);
+}
+
+TEST(CompressedFileReaderTest, TruncatedGzipFile){
+	gzFile gz = gzopen("compressed_file_reader_test.gz", "wb");
+	std::string text = Corpus();
+	gzwrite(gz, text.data(), static_cast<unsigned>(text.size()));
+	gzclose(gz);
+	std::ifstream infile("compressed_file_reader_test.gz", std::ios::binary);
+	std::string data((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+	infile.close();
+	std::ofstream outfile("compressed_file_reader_test.gz", std::ios::binary);
+	outfile << data.substr(0, data.size() / 2);
+	outfile.close();
+
+	size_t errors = GetAllErrors().size();
+	CompressedFileReader reader;
+	ASSERT_TRUE(reader.OpenFile("compressed_file_reader_test.gz"));
+	std::string read = ReadAll(reader);
+	EXPECT_LT(read.size(), text.size());
+	ASSERT_EQ(GetAllErrors().size(), errors + 1);
+	EXPECT_EQ(GetAllErrors().back().errNum, CORRUPTED_COMPRESSION);
+}
+#endif
+
+#ifndef QCOMPILER_HAS_ZSTD
+TEST(CompressedFileReaderTest, UnsupportedZstd){
+	std::ofstream outfile("compressed_file_reader_test.zst", std::ios::binary);
+	outfile << "\x28\xb5\x2f\xfd" << "not really zstd";
+	outfile.close();
+
+	size_t errors = GetAllErrors().size();
+	CompressedFileReader reader;
+	EXPECT_FALSE(reader.OpenFile("compressed_file_reader_test.zst"));
+	ASSERT_EQ(GetAllErrors().size(), errors + 1);
+	EXPECT_EQ(GetAllErrors().back().errNum, UNSUPPORTED_COMPRESSION);
+}
+#endif
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
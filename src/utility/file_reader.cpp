@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "sys_env.h"
+#include "utility/file_reader.h"
+#include "utility/file_reader_factory.h"
+
+std::unique_ptr<FileReader> CreateFileReader(const std::string& name){
+	FileReaderFactory* factory = FileReaderFactoryRegistry::GetFactory(name);
+	if (factory == nullptr) return nullptr;
+	else return factory->CreateFileReader();
+}
+
+void FileReader::_resetWindow(){
+	begin_ = cur_ = end_ = indexed_ = nullptr;
+	windowOffset_ = 0;
+	newlines_ = lastNewline_ = 0;
+	_refill();
+}
+
+//the newlines of the old window must be indexed before it is dropped
+void FileReader::_refill(){
+	_indexNewlines(end_);
+	windowOffset_ += static_cast<size_t>(end_ - begin_);
+
+	const char* begin = nullptr;
+	const char* end = nullptr;
+	while(_nextWindow(begin, end) && begin == end); //skip empty windows
+	begin_ = cur_ = indexed_ = begin;
+	end_ = end;
+}
+
+void FileReader::_indexNewlines() const{
+	_indexNewlines(cur_);
+}
+
+void FileReader::_indexNewlines(const char* to) const{
+	if(indexed_ == to) return;
+	_countChar(_ENTER_, to);
+	_countChar(_NEWLINE_, to);
+	indexed_ = to;
+}
+
+void FileReader::_countChar(char c, const char* to) const{
+	const char* p = indexed_;
+	while(p != to){
+		const char* pos = static_cast<const char*>(std::memchr(p, c, static_cast<size_t>(to - p)));
+		if(pos == nullptr) break;
+		newlines_++;
+		lastNewline_ = std::max(lastNewline_, windowOffset_ + static_cast<size_t>(pos - begin_));
+		p = pos + 1;
+	}
+}
+
+size_t FileReader::SkipUntil(char c){
+	size_t n = 0;
+	while(cur_ != end_){
+		const char* pos = static_cast<const char*>(std::memchr(cur_, c, static_cast<size_t>(end_ - cur_)));
+		const char* stop = pos == nullptr ? end_ : pos;
+		n += static_cast<size_t>(stop - cur_);
+		cur_ = stop;
+		if(pos != nullptr) break;
+		_refill();
+	}
+	return n;
+}
+
+size_t FileReader::SkipWhile(const CharClass& cls){
+	size_t n = 0;
+	while(cur_ != end_){
+		const char* p = cur_;
+		while(p != end_ && cls.Has(*p)) p++;
+		n += static_cast<size_t>(p - cur_);
+		cur_ = p;
+		if(p != end_) break;
+		_refill();
+	}
+	return n;
+}
+
+std::string FileReader::ScanUntil(char c){
+	std::string str;
+	while(cur_ != end_){
+		const char* pos = static_cast<const char*>(std::memchr(cur_, c, static_cast<size_t>(end_ - cur_)));
+		const char* stop = pos == nullptr ? end_ : pos;
+		str.append(cur_, stop);
+		cur_ = stop;
+		if(pos != nullptr) break;
+		_refill();
+	}
+	return str;
+}
+
+std::string FileReader::ScanWhile(const CharClass& cls){
+	std::string str;
+	while(cur_ != end_){
+		const char* p = cur_;
+		while(p != end_ && cls.Has(*p)) p++;
+		str.append(cur_, p);
+		cur_ = p;
+		if(p != end_) break;
+		_refill();
+	}
+	return str;
+}
+
+std::string FileReader::Take(size_t n){
+	std::string str;
+	while(n != 0 && cur_ != end_){
+		size_t len = std::min(n, static_cast<size_t>(end_ - cur_));
+		str.append(cur_, len);
+		cur_ += len, n -= len;
+		if(cur_ == end_) _refill();
+	}
+	return str;
+}
+
+std::string FileReader::TrimmedSubstrBeforeChar(char c){
+	std::string sub = ScanUntil(c);
+
+	size_t beg = sub.find_first_not_of(' ');
+	if (beg == std::string::npos) return "";
+	size_t last = sub.find_last_not_of(' ');
+	return sub.substr(beg, last - beg + 1);
+}
+
+std::string FileReader::ReadLine(){
+	static const CharClass line_chars = CharClass(std::string(1, _ENTER_) + _NEWLINE_).Complement();
+	std::string line = ScanWhile(line_chars);
+	NextChar(); //consume the line ending, nothing happens at the end of file
+	return line;
+}
@@ -1,29 +1,107 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
 #include "factory_template.h"
 
+/* 256 entries table of the chars in a class, used by FileReader::ScanWhile(). */
+struct CharClass {
+	CharClass() {}
+	explicit CharClass(const std::string& chars) { for(char c : chars) Add(c); }
+
+	void Add(char c) { table[static_cast<unsigned char>(c)] = true; }
+	bool Has(char c) const { return table[static_cast<unsigned char>(c)]; }
+	CharClass Complement() const {
+		CharClass cls;
+		for(int i = 0; i < 256; i++) cls.table[i] = !table[i];
+		return cls;
+	}
+
+	bool table[256]{ false };
+};
+
+/* FileReader owns the window of the file which is being read: the bytes in [cur_, end_) are
+ * available, and when they are used up _nextWindow() of the implementation is called to get the next
+ * part of the file. So all the reads(char by char or in bulk) are not virtual and no bookkeeping is
+ * done per char, the line and column numbers are computed from a count of the newlines and the offset of
+ * the last one. The newlines are counted with memchr only when the position is asked for, or when the
+ * window is dropped.
+ */
 class FileReader {
 public:
 	FileReader(){}
 	virtual ~FileReader(){}
 	virtual bool OpenFile(const std::string& file) = 0;
-	virtual char CurrentChar() const = 0;
-	virtual char NextChar() = 0;
 
 	virtual bool SetFilePath(const std::string& file) = 0;
 	virtual std::string GetFilePath() const = 0;
 
-	void LineNumIncrease() { lineNumber_++; }
-	void ColNumIncrease() { colNumber_++; }
-	void LineNumReset() { lineNumber_ = 0; }
-	void ColNumReset() { colNumber_ = 0; }
+	//'\0' at the end of file
+	char CurrentChar() const { return cur_ == end_ ? '\0' : *cur_; }
+	char NextChar() {
+		if(cur_ == end_) return '\0';
+		char c = *cur_++;
+		if(cur_ == end_) _refill();
+		return c;
+	}
+	bool IsFileEnd() const { return cur_ == end_; }
+
+	//the window is refilled as soon as it is used up, this is kept for the callers which load the file explicitly
+	void ReadToBuffer() { if(cur_ == end_) _refill(); }
+
+	/* Bulk reads, the Scan* and Take return the bytes consumed, the Skip* only consume them. They all
+	 * stop at the end of file.
+	 */
+	std::string ScanUntil(char c); //stop before 'c'
+	std::string ScanWhile(const CharClass& cls);
+	std::string Take(size_t n);
+	size_t SkipUntil(char c);
+	size_t SkipWhile(const CharClass& cls);
+
+	//substring before 'c' that trimmed blank
+	std::string TrimmedSubstrBeforeChar(char c);
 
-	size_t LineNumber() const { return lineNumber_; }
-	size_t ColNumber() const { return colNumber_; }
+	//the line ends at '\r' or '\n', which is consumed but not returned
+	std::string ReadLine();
+
+	//offset of the current char from the beginning of file
+	size_t Offset() const { return windowOffset_ + static_cast<size_t>(cur_ - begin_); }
+
+	/* Both '\r' and '\n' begin a new line, the line number begins from 1 and the column number is the count
+	 * of the chars read in the current line.
+	 */
+	size_t LineNumber() const { _indexNewlines(); return newlines_ + 1; }
+	size_t ColNumber() const {
+		_indexNewlines();
+		return newlines_ == 0 ? Offset() : Offset() - lastNewline_ - 1;
+	}
+
+protected:
+	//the implementation gives the next part of the file, returns false at the end of file
+	virtual bool _nextWindow(const char*& begin, const char*& end) = 0;
+
+	//called by OpenFile() of the implementation when the file is opened
+	void _resetWindow();
 
 private:
-	size_t lineNumber_ { 1 };//lineNumber begins from 1 but not 0, this is more friendly to read
-	size_t colNumber_ { 0 };
+	void _refill();
+	//count the newlines in [indexed_, cur_)
+	void _indexNewlines() const;
+	void _indexNewlines(const char* to) const;
+	void _countChar(char c, const char* to) const;
+
+	const char* begin_{ nullptr };
+	const char* cur_{ nullptr };
+	const char* end_{ nullptr };
+	size_t windowOffset_{ 0 };
+
+	mutable const char* indexed_{ nullptr };
+	mutable size_t newlines_{ 0 };
+	mutable size_t lastNewline_{ 0 }; //offset, valid if newlines_ is not 0
 };
 
+/* The name is the one registered by FACTORY_REGISTRAR_DEFINE, such as "QFileReader" and "MMapFileReader".
+ * Returns nullptr if there is no such reader.
+ */
+std::unique_ptr<FileReader> CreateFileReader(const std::string& name);
@@ -0,0 +1,59 @@
+#include <random>
+#include <string>
+#include "gtest/gtest.h"
+#include "gap_buffer.h"
+
+static std::string Text(const GapBuffer<char>& buffer){
+	return buffer.Copy<std::string>();
+}
+
+TEST(GapBufferTest, EditsAtTheGap){
+	GapBuffer<char> buffer;
+	std::string text = "hello world";
+	buffer.Assign(text.begin(), text.end());
+	EXPECT_EQ(buffer.Gap(), text.size());
+
+	buffer.MoveGap(5);
+	buffer.Erase(6);
+	std::string inserted = ", gap";
+	buffer.Insert(inserted.begin(), inserted.end());
+	EXPECT_EQ(Text(buffer), "hello, gap");
+	EXPECT_EQ(buffer.Gap(), 10u);
+	EXPECT_EQ(buffer[1], 'e');
+
+	buffer.MoveGap(0);
+	EXPECT_EQ(std::string(buffer.data(), buffer.Gap()), "");
+	buffer.MoveGap(buffer.size());
+	EXPECT_EQ(std::string(buffer.data(), buffer.Gap()), "hello, gap");
+	buffer.clear();
+	EXPECT_TRUE(buffer.empty());
+}
+
+//the items after the gap are kept from the end, so they do not change when the items before them do
+TEST(GapBufferTest, ItemsRelativeToTheEnd){
+	GapBuffer<size_t> offsets;
+	std::vector<size_t> expected{ 0, 3, 7, 12, 20 };
+	size_t size = 25;
+	offsets.Assign(expected.begin(), expected.end());
+	auto at = [&offsets, &size](size_t i) { return i < offsets.Gap() ? offsets[i] : size - offsets[i]; };
+	auto flip = [&size](size_t& k) { k = size - k; };
+
+	std::mt19937 random(7);
+	for(int n = 0; n < 500; n++){
+		size_t pos = random() % (expected.size() + 1);
+		offsets.MoveGap(pos, flip, flip);
+		//a new item of 1 byte at pos, the later items move by 2 bytes
+		size_t offset = pos == 0 ? 0 : expected[pos - 1] + 1;
+		size += 2;
+		for(size_t i = pos; i < expected.size(); i++) expected[i] += 2;
+		expected.insert(expected.begin() + pos, offset);
+		offsets.Insert(&offset, &offset + 1);
+		ASSERT_EQ(offsets.size(), expected.size());
+		for(size_t i = 0; i < expected.size(); i++) ASSERT_EQ(at(i), expected[i]) << n << " " << i;
+	}
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
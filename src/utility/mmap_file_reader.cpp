@@ -0,0 +1,99 @@
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "error.h"
+#include "utility/file_reader.h"
+#include "utility/file_reader_factory.h"
+#include "utility/mmap_file_reader.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MMapFileReader::SetFilePath(const std::string& file) {
+	if(fileOpened_) GENERATE_ERRMSG_PUSH(FILE_OPENED, this);
+	else filePath_ = file;
+	return !fileOpened_;
+}
+
+std::string MMapFileReader::GetFilePath() const {
+	return filePath_;
+}
+
+bool MMapFileReader::OpenFile(const std::string& file){
+	if(fileOpened_) {
+		GENERATE_ERRMSG_PUSH(FILE_OPENED, this);
+		return false;
+	}
+
+	filePath_ = file;
+#ifndef _WIN32
+	int fd = open(filePath_.c_str(), O_RDONLY);
+	struct stat st;
+	if(fd < 0 || fstat(fd, &st) != 0) {
+		if(fd >= 0) close(fd);
+		GENERATE_ERRMSG_PUSH(FILE_CANNOT_OPEN, this);
+		return false;
+	}
+
+	mappingSize_ = static_cast<size_t>(st.st_size);
+	if(mappingSize_ != 0) { //an empty file cannot be mapped
+		mapping_ = mmap(nullptr, mappingSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapping_ == MAP_FAILED) {
+			close(fd);
+			mapping_ = nullptr, mappingSize_ = 0;
+			GENERATE_ERRMSG_PUSH(FILE_CANNOT_OPEN, this);
+			return false;
+		}
+		madvise(mapping_, mappingSize_, MADV_SEQUENTIAL);
+	}
+	close(fd); //the mapping is still valid after the file is closed
+
+	data_ = static_cast<const char*>(mapping_);
+	size_ = mappingSize_;
+#else
+	std::ifstream infile(filePath_, std::ios::binary);
+	if(!infile) {
+		GENERATE_ERRMSG_PUSH(FILE_CANNOT_OPEN, this);
+		return false;
+	}
+	contents_.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+	data_ = contents_.data();
+	size_ = contents_.size();
+#endif
+
+	fileOpened_ = true;
+	windowGiven_ = false;
+	_resetWindow();
+	return true;
+}
+
+void MMapFileReader::_closeFile(){
+#ifndef _WIN32
+	if(mapping_ != nullptr) munmap(mapping_, mappingSize_);
+#endif
+	mapping_ = nullptr, mappingSize_ = 0;
+	contents_.clear();
+	data_ = nullptr, size_ = 0;
+	fileOpened_ = false;
+}
+
+bool MMapFileReader::_nextWindow(const char*& begin, const char*& end){
+	if(!fileOpened_ || windowGiven_) return false;
+	windowGiven_ = true;
+	begin = data_, end = data_ + size_;
+	return size_ != 0;
+}
+
+class MMapFileReaderFactory : public FileReaderFactory{
+public:
+	std::unique_ptr<FileReader> CreateFileReader(){
+		std::unique_ptr<FileReader> reader(new MMapFileReader);
+		return reader;
+	}
+};
+
+FACTORY_REGISTRAR_DEFINE("MMapFileReader", FileReader, MMapFileReaderFactory);
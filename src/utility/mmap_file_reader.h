@@ -0,0 +1,41 @@
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "utility/file_reader.h"
+
+/* Maps the whole file read-only, all the reads are served from the mapping directly, so there is no
+ * buffer to refill and nothing is copied. On the systems without mmap(), the file is read into memory
+ * once instead.
+ */
+class MMapFileReader final : public FileReader {
+public:
+	~MMapFileReader(){ _closeFile(); }
+
+	bool SetFilePath(const std::string& file) override;
+
+	std::string GetFilePath() const override;
+
+	bool OpenFile(const std::string& file) override;
+
+	bool IsFileOpened() const { return fileOpened_; }
+
+protected:
+	//the whole mapping is the only window
+	bool _nextWindow(const char*& begin, const char*& end) override;
+
+private:
+	void _closeFile();
+
+	std::string filePath_;
+	bool fileOpened_{ false };
+
+	void* mapping_{ nullptr };
+	size_t mappingSize_{ 0 };
+	std::vector<char> contents_; //used if mmap() is not available
+
+	const char* data_{ nullptr };
+	size_t size_{ 0 };
+	bool windowGiven_{ false };
+};
@@ -0,0 +1,47 @@
+#include <fstream>
+#include "gtest/gtest.h"
+#include "utility/file_reader.h"
+
+static void WriteFile(const std::string& name, const std::string& contents){
+	std::ofstream outfile(name, std::ios::binary);
+	outfile << contents;
+}
+
+TEST(MMapFileReaderTest, SameAsQFileReader){
+	std::string text = "  <A> = [a-z] ;\r\n\nid + num\n";
+	for(int i = 0; i < 2000; i++) text += "line " + std::to_string(i) + " of a file longer than a buffer\n";
+	WriteFile("mmap_file_reader_test.txt", text);
+
+	std::unique_ptr<FileReader> expect = CreateFileReader("QFileReader");
+	std::unique_ptr<FileReader> reader = CreateFileReader("MMapFileReader");
+	ASSERT_TRUE(expect && reader);
+	ASSERT_TRUE(expect->OpenFile("mmap_file_reader_test.txt"));
+	ASSERT_TRUE(reader->OpenFile("mmap_file_reader_test.txt"));
+
+	EXPECT_EQ(reader->TrimmedSubstrBeforeChar('='), expect->TrimmedSubstrBeforeChar('='));
+	EXPECT_EQ(reader->NextChar(), expect->NextChar());
+	while(!expect->IsFileEnd()){
+		ASSERT_FALSE(reader->IsFileEnd());
+		EXPECT_EQ(reader->ReadLine(), expect->ReadLine());
+		EXPECT_EQ(reader->LineNumber(), expect->LineNumber());
+		EXPECT_EQ(reader->ColNumber(), expect->ColNumber());
+	}
+	EXPECT_TRUE(reader->IsFileEnd());
+	EXPECT_EQ(reader->CurrentChar(), '\0');
+}
+
+TEST(MMapFileReaderTest, EmptyAndMissingFile){
+	WriteFile("mmap_file_reader_empty.txt", "");
+	std::unique_ptr<FileReader> reader = CreateFileReader("MMapFileReader");
+	ASSERT_TRUE(reader->OpenFile("mmap_file_reader_empty.txt"));
+	EXPECT_TRUE(reader->IsFileEnd());
+	EXPECT_EQ(reader->ReadLine(), "");
+
+	std::unique_ptr<FileReader> missing = CreateFileReader("MMapFileReader");
+	EXPECT_FALSE(missing->OpenFile("mmap_file_reader_missing.txt"));
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,297 @@
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfSample PerfSample::operator-(const PerfSample& other) const{
+	PerfSample diff;
+	diff.available = available & other.available;
+	for(int i = 0; i < PERF_EVENT_COUNT; i++)
+		if(diff.Has(static_cast<PerfEvent>(i)) && value[i] > other.value[i]) diff.value[i] = value[i] - other.value[i];
+	return diff;
+}
+
+//an event is available in the sum only if it is available in both, except when one side is empty
+PerfSample& PerfSample::operator+=(const PerfSample& other){
+	available = available ? available & other.available : other.available;
+	for(int i = 0; i < PERF_EVENT_COUNT; i++) value[i] += other.value[i];
+	return *this;
+}
+
+const char* PerfCounters::EventName(PerfEvent e){
+	static const char* names[PERF_EVENT_COUNT] = { "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses" };
+	return e >= 0 && e < PERF_EVENT_COUNT ? names[e] : "";
+}
+
+#ifdef __linux__
+
+//group is -1 for the leader, only the leader is disabled at first, the others follow it
+static int _openEvent(uint32_t type, uint64_t config, int group){
+	perf_event_attr attr{};
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = group < 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	//this thread on any cpu
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+
+PerfCounters::PerfCounters(){
+	const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+		| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	const std::pair<uint32_t, uint64_t> events[PERF_EVENT_COUNT] = {
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		{ PERF_TYPE_HW_CACHE, l1d_read_miss },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	};
+	//the group is read in the order the events are opened, that is by PerfEvent
+	for(int i = 0; i < PERF_EVENT_COUNT; i++){
+		fds_[i] = _openEvent(events[i].first, events[i].second, leader_);
+		if(fds_[i] < 0) continue;
+		if(leader_ < 0) leader_ = fds_[i];
+		available_ |= 1u << i;
+	}
+}
+
+PerfCounters::~PerfCounters(){
+	for(int fd : fds_)
+		if(fd >= 0) close(fd);
+}
+
+void PerfCounters::Start(){
+	if(leader_ >= 0) ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void PerfCounters::Stop(){
+	if(leader_ >= 0) ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void PerfCounters::Reset(){
+	if(leader_ >= 0) ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+}
+
+PerfSample PerfCounters::Read() const{
+	PerfSample sample;
+	uint64_t data[3 + PERF_EVENT_COUNT]; //number of events, time enabled, time running, the values
+	if(leader_ < 0) return sample;
+	ssize_t bytes = read(leader_, data, sizeof(data));
+	if(bytes < static_cast<ssize_t>(3 * sizeof(uint64_t)) || bytes != static_cast<ssize_t>((3 + data[0]) * sizeof(uint64_t)))
+		return sample;
+	uint64_t n = 0;
+	for(int i = 0; i < PERF_EVENT_COUNT && n < data[0]; i++){
+		if(!Available(static_cast<PerfEvent>(i))) continue;
+		uint64_t value = data[3 + n++];
+		if(data[2] != 0 && data[2] < data[1])
+			value = static_cast<uint64_t>(static_cast<double>(value) * data[1] / data[2]);
+		sample.value[i] = value;
+		sample.available |= 1u << i;
+	}
+	return sample;
+}
+
+static uint64_t _threadCpuNanoseconds(){
+	timespec ts;
+	if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+#else
+
+PerfCounters::PerfCounters(){
+	for(int& fd : fds_) fd = -1;
+}
+
+PerfCounters::~PerfCounters(){
+}
+
+void PerfCounters::Start(){
+}
+
+void PerfCounters::Stop(){
+}
+
+void PerfCounters::Reset(){
+}
+
+PerfSample PerfCounters::Read() const{
+	return PerfSample();
+}
+
+static uint64_t _threadCpuNanoseconds(){
+	return static_cast<uint64_t>(std::clock()) * (1000000000u / CLOCKS_PER_SEC);
+}
+
+#endif
+
+static uint64_t _nanoseconds(){
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+//the stages of one thread, keyed by the pointer to the name
+struct PerfStageSlot {
+	char padBegin[64];
+	std::unordered_map<const char*, PerfStageStats> stages;
+	char padEnd[64];
+};
+
+struct PerfRegistry {
+	std::mutex mutex;
+	std::vector<std::unique_ptr<PerfStageSlot>> slots; //the slots of the exited threads are kept
+};
+
+static PerfRegistry& _registry(){
+	static PerfRegistry registry;
+	return registry;
+}
+
+//the lock is taken once for each thread
+static PerfStageSlot& _threadSlot(){
+	thread_local PerfStageSlot* slot = nullptr;
+	if(slot) return *slot;
+	PerfRegistry& registry = _registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.slots.emplace_back(new PerfStageSlot);
+	slot = registry.slots.back().get();
+	return *slot;
+}
+
+//opened when the thread enters its first stage and kept running until the thread exits
+static PerfCounters& _threadCounters(){
+	thread_local std::unique_ptr<PerfCounters> counters;
+	if(!counters){
+		counters.reset(new PerfCounters);
+		counters->Start();
+	}
+	return *counters;
+}
+
+PerfStageScope::PerfStageScope(const char* name) : name_(name) {
+	begin_ = _threadCounters().Read();
+	beginCpuNanoseconds_ = _threadCpuNanoseconds();
+	beginNanoseconds_ = _nanoseconds();
+}
+
+PerfStageScope::~PerfStageScope() {
+	uint64_t nanoseconds = _nanoseconds() - beginNanoseconds_;
+	uint64_t cpu_nanoseconds = _threadCpuNanoseconds() - beginCpuNanoseconds_;
+	PerfSample counters = _threadCounters().Read() - begin_;
+
+	PerfStageStats& s = _threadSlot().stages[name_];
+	if(s.name.empty()) s.name = name_;
+	s.calls++;
+	s.nanoseconds += nanoseconds;
+	s.cpuNanoseconds += cpu_nanoseconds;
+	s.counters += counters;
+}
+
+bool PerfStats::Enabled(){
+#ifdef QCOMPILER_ENABLE_PERF_COUNTERS
+	return true;
+#else
+	return false;
+#endif
+}
+
+//the same name may be kept at several addresses, so the stages are merged by name
+std::vector<PerfStageStats> PerfStats::Stages(){
+	std::map<std::string, PerfStageStats> merged;
+	PerfRegistry& registry = _registry();
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for(const auto& slot : registry.slots){
+			for(const auto& stage : slot->stages){
+				const PerfStageStats& from = stage.second;
+				PerfStageStats& s = merged[from.name];
+				s.name = from.name;
+				s.calls += from.calls;
+				s.nanoseconds += from.nanoseconds;
+				s.cpuNanoseconds += from.cpuNanoseconds;
+				s.counters += from.counters;
+			}
+		}
+	}
+	std::vector<PerfStageStats> stages;
+	for(const auto& s : merged) stages.push_back(s.second);
+	return stages;
+}
+
+static std::string _escape(const std::string& name){
+	std::string str;
+	for(char c : name){
+		if(c == '"' || c == '\\') str += '\\';
+		str += c;
+	}
+	return str;
+}
+
+void PerfStats::WriteJson(std::ostream& out){
+	std::vector<PerfStageStats> stages = Stages();
+	PerfCounters probe;
+
+	char date[32];
+	std::time_t now = std::time(nullptr);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+	out << "{\n  \"context\": {\n    \"date\": \"" << date << "\",\n    \"num_cpus\": " << std::thread::hardware_concurrency()
+#ifdef NDEBUG
+		<< ",\n    \"library_build_type\": \"release\""
+#else
+		<< ",\n    \"library_build_type\": \"debug\""
+#endif
+		<< ",\n    \"perf_counters\": [";
+	bool first = true;
+	for(int i = 0; i < PERF_EVENT_COUNT; i++){
+		if(!probe.Available(static_cast<PerfEvent>(i))) continue;
+		out << (first ? "" : ", ") << "\"" << PerfCounters::EventName(static_cast<PerfEvent>(i)) << "\"";
+		first = false;
+	}
+	out << "]\n  },\n  \"benchmarks\": [";
+
+	first = true;
+	for(const auto& s : stages){
+		double calls = static_cast<double>(s.calls ? s.calls : 1);
+		std::string name = "stage/" + _escape(s.name);
+		out << (first ? "\n" : ",\n") << "    {\n      \"name\": \"" << name << "\",\n      \"run_name\": \"" << name
+			<< "\",\n      \"run_type\": \"iteration\",\n      \"threads\": 1,\n      \"iterations\": " << s.calls
+			<< ",\n      \"real_time\": " << s.nanoseconds / calls << ",\n      \"cpu_time\": " << s.cpuNanoseconds / calls
+			<< ",\n      \"time_unit\": \"ns\"";
+		for(int i = 0; i < PERF_EVENT_COUNT; i++){
+			PerfEvent e = static_cast<PerfEvent>(i);
+			if(s.counters.Has(e)) out << ",\n      \"" << PerfCounters::EventName(e) << "\": " << s.counters.value[i] / calls;
+		}
+		out << "\n    }";
+		first = false;
+	}
+	out << "\n  ]\n}\n";
+}
+
+bool PerfStats::WriteJson(const std::string& file){
+	if(!Enabled()) return false;
+	std::ofstream outfile(file);
+	if(!outfile) return false;
+	WriteJson(outfile);
+	return static_cast<bool>(outfile);
+}
+
+void PerfStats::Reset(){
+	PerfRegistry& registry = _registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for(auto& slot : registry.slots) slot->stages.clear();
+}
@@ -0,0 +1,100 @@
+#include <sstream>
+#include <thread>
+#include "gtest/gtest.h"
+#include "perf_counters.h"
+
+static volatile uint64_t sink;
+
+static void Work(){
+	uint64_t sum = 0;
+	for(uint64_t i = 0; i < 1000000; i++) sum += i * i;
+	sink = sum;
+}
+
+//the counters may be refused(virtual machines, perf_event_paranoid), that should not be an error
+TEST(PerfCountersTest, CountsOrDegrades){
+	PerfCounters counters;
+	counters.Start();
+	Work();
+	counters.Stop();
+	PerfSample first = counters.Read();
+	for(int i = 0; i < PERF_EVENT_COUNT; i++)
+		EXPECT_EQ(first.Has(static_cast<PerfEvent>(i)), counters.Available(static_cast<PerfEvent>(i)));
+	if(counters.Available(PERF_INSTRUCTIONS)){
+		EXPECT_GT(first.value[PERF_INSTRUCTIONS], 1000000u);
+	}
+
+	//stopped, so nothing more is counted
+	Work();
+	PerfSample second = counters.Read();
+	EXPECT_EQ(second.value[PERF_INSTRUCTIONS], first.value[PERF_INSTRUCTIONS]);
+
+	counters.Reset();
+	EXPECT_EQ(counters.Read().value[PERF_INSTRUCTIONS], 0u);
+	EXPECT_STREQ(PerfCounters::EventName(PERF_LLC_MISSES), "llc_misses");
+}
+
+TEST(PerfCountersTest, SampleArithmetic){
+	PerfSample a, b;
+	a.available = 3u;
+	a.value[PERF_CYCLES] = 10, a.value[PERF_INSTRUCTIONS] = 20;
+	b.available = 1u;
+	b.value[PERF_CYCLES] = 4;
+	PerfSample diff = a - b;
+	EXPECT_TRUE(diff.Has(PERF_CYCLES));
+	EXPECT_FALSE(diff.Has(PERF_INSTRUCTIONS));
+	EXPECT_EQ(diff.value[PERF_CYCLES], 6u);
+
+	PerfSample sum;
+	sum += a;
+	EXPECT_EQ(sum.available, 3u);
+	sum += b;
+	EXPECT_EQ(sum.available, 1u);
+	EXPECT_EQ(sum.value[PERF_CYCLES], 14u);
+}
+
+TEST(PerfCountersTest, StagesJson){
+	PerfStats::Reset();
+	for(int i = 0; i < 2; i++){
+		PerfStageScope scope("perf \"test\"");
+		Work();
+	}
+	std::vector<PerfStageStats> stages = PerfStats::Stages();
+	ASSERT_EQ(stages.size(), 1u);
+	EXPECT_EQ(stages[0].calls, 2u);
+	EXPECT_GT(stages[0].nanoseconds, 0u);
+
+	std::ostringstream json;
+	PerfStats::WriteJson(json);
+	EXPECT_NE(json.str().find("\"benchmarks\": ["), std::string::npos);
+	EXPECT_NE(json.str().find("\"name\": \"stage/perf \\\"test\\\"\""), std::string::npos);
+	EXPECT_NE(json.str().find("\"iterations\": 2"), std::string::npos);
+	EXPECT_EQ(PerfStats::WriteJson(std::string("perf_counters_test.json")), PerfStats::Enabled());
+	PerfStats::Reset();
+	EXPECT_TRUE(PerfStats::Stages().empty());
+}
+
+//every thread counts in its own slot, the slots are merged by name
+TEST(PerfCountersTest, StagesOfThreads){
+	PerfStats::Reset();
+	std::vector<std::thread> threads;
+	for(int t = 0; t < 4; t++)
+		threads.emplace_back([]() {
+			for(int i = 0; i < 3; i++){
+				PerfStageScope scope("perf threads");
+				Work();
+			}
+		});
+	for(auto& t : threads) t.join();
+	std::vector<PerfStageStats> stages = PerfStats::Stages();
+	ASSERT_EQ(stages.size(), 1u);
+	EXPECT_EQ(stages[0].name, "perf threads");
+	EXPECT_EQ(stages[0].calls, 12u);
+	PerfStats::Reset();
+	EXPECT_TRUE(PerfStats::Stages().empty());
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -26,69 +26,22 @@ bool QFileReader::OpenFile(const std::string& file){
 	file_.open(filePath_);
 	if(!file_) {
 		fileOpened_ = false;
-		_resetBuffer();
 		GENERATE_ERRMSG_PUSH(FILE_CANNOT_OPEN, this);
 		return false;
 	}
 	
 	fileOpened_ = true;
-	ReadToBuffer();
+	_resetWindow();
 	return true;
 }
 
-//prober_ will never stop at '\0'
-char QFileReader::CurrentChar() const { return *prober_; }
-
-char QFileReader::NextChar() {
-	char c = CurrentChar();
-	if (c == charEnter_ || c == charNewLine_) LineNumIncrease(), ColNumReset();
-	else ColNumIncrease();
-	prober_++, ReadToBuffer();
-	return c;
-}
-
-void QFileReader::ReadToBuffer(){
-	//only when prober_ reaches the end, we need to load buffer
-	if (prober_ - buffer_ != BUFFER_SIZE()) return;
+bool QFileReader::_nextWindow(const char*& begin, const char*& end){
+	if(!fileOpened_) return false;
 
 	file_.read(buffer_, BUFFER_SIZE());
-	currLen_ = static_cast<size_t>(file_.gcount()); //get the real read bytes
-	buffer_[currLen_] = '\0';
-	prober_ = buffer_;
-}
-
-void QFileReader::_resetBuffer(){
-	currLen_ = 0;
-	prober_ = buffer_ + BUFFER_SIZE();
-}
-
-std::string QFileReader::TrimmedSubstrBeforeChar(char c){
-	std::string sub("");
-	bool done = false;
-	while (!IsFileEnd() && !done) {
-		if (CurrentChar() != c) sub += NextChar();
-		else done = true;
-	}
-
-	const char* ptr = sub.c_str();
-	while (*ptr == charBlank_) ptr++;
-	sub = sub.substr(ptr - sub.c_str());
-	if (sub.empty()) return sub;
-
-	ptr = sub.c_str() + sub.length() - 1;
-	while (ptr >= sub.c_str() && *ptr == charBlank_) ptr--;
-	sub = sub.substr(0, ptr - sub.c_str() + 1);
-	return sub;
-}
-
-std::string QFileReader::ReadLine(){
-	std::string sub("");
-	while(!IsFileEnd()){
-		char c = NextChar();
-		if (c == charEnter_ || c == charNewLine_) break;
-		else sub += c;
-	}
-	return sub;
+	size_t len = static_cast<size_t>(file_.gcount()); //get the real read bytes
+	begin = buffer_, end = buffer_ + len;
+	return len != 0;
 }
 
 class QFileReaderFactory : public FileReaderFactory{
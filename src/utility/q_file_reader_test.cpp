@@ -1,11 +1,71 @@
 
+#include <fstream>
 #include "gtest/gtest.h"
+#include "utility/file_reader.h"
 
 TEST(QFileReaderTest, GeneralTest){
 }
 
+//the text crosses several 8K buffers of QFileReader
+static std::string WriteLongFile(const std::string& name){
+	std::string text;
+	for(int i = 0; i < 3000; i++) text += "key" + std::to_string(i) + " =   value;\r\n\n";
+	std::ofstream outfile(name, std::ios::binary);
+	outfile << text;
+	return text;
+}
+
+TEST(QFileReaderTest, BulkScan){
+	std::string text = WriteLongFile("q_file_reader_test.txt");
+	for(const char* name : { "QFileReader", "MMapFileReader" }){
+		std::unique_ptr<FileReader> reader = CreateFileReader(name);
+		ASSERT_TRUE(reader->OpenFile("q_file_reader_test.txt"));
+
+		const CharClass blank(" ");
+		size_t total = 0, lines = 0;
+		while(!reader->IsFileEnd()){
+			std::string key = reader->ScanUntil('=');
+			EXPECT_EQ(key.compare(0, 3, "key"), 0) << name;
+			EXPECT_EQ(reader->Take(1), "=");
+			EXPECT_EQ(reader->SkipWhile(blank), 3u);
+			EXPECT_EQ(reader->ScanWhile(CharClass(";").Complement()), "value");
+			EXPECT_EQ(reader->SkipUntil('\n'), 2u);
+			EXPECT_EQ(reader->Take(2), "\n\n");
+			total += key.size() + 1 + 3 + 5 + 2 + 2;
+			lines++;
+			EXPECT_EQ(reader->LineNumber(), 3 * lines + 1);
+			EXPECT_EQ(reader->ColNumber(), 0u);
+		}
+		EXPECT_EQ(total, text.size()) << name;
+		EXPECT_EQ(reader->Offset(), text.size());
+		EXPECT_EQ(reader->ScanUntil('='), "");
+		EXPECT_EQ(reader->Take(10), "");
+	}
+}
+
+//line and column are computed lazily, they must be the same as counting char by char
+TEST(QFileReaderTest, LineAndColumn){
+	std::string text = WriteLongFile("q_file_reader_test.txt");
+	std::unique_ptr<FileReader> reader = CreateFileReader("QFileReader");
+	ASSERT_TRUE(reader->OpenFile("q_file_reader_test.txt"));
+
+	size_t line = 1, col = 0;
+	for(size_t i = 0; i < text.size(); i++){
+		if(i % 97 == 0){
+			EXPECT_EQ(reader->LineNumber(), line);
+			EXPECT_EQ(reader->ColNumber(), col);
+		}
+		char c = reader->NextChar();
+		ASSERT_EQ(c, text[i]);
+		if(c == '\r' || c == '\n') line++, col = 0;
+		else col++;
+	}
+	EXPECT_TRUE(reader->IsFileEnd());
+	EXPECT_EQ(reader->LineNumber(), line);
+	EXPECT_EQ(reader->ColNumber(), col);
+}
+
 int main(int argc, char* argv[]){
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
 }
-
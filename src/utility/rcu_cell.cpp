@@ -0,0 +1,55 @@
+#include "rcu_cell.h"
+
+/* All the orders are sequentially consistent: a reader stores its epoch and then loads the pointer, a
+ * writer swaps the pointer and then scans the slots. So either the writer sees the epoch of the reader,
+ * or the reader sees the new pointer.
+ */
+struct EpochGuard::Slot {
+	std::atomic<uint64_t> active{ 0 }; //0 if the owner is not in a critical section
+	std::atomic<bool> used{ false };
+	Slot* next{ nullptr };
+	unsigned depth{ 0 }; //touched by the owner only
+};
+
+static std::atomic<uint64_t> global_epoch{ 1 };
+//slots are never freed, the slot of a thread which has exited is taken by a new thread
+static std::atomic<EpochGuard::Slot*> all_slots{ nullptr };
+
+static EpochGuard::Slot* _acquireSlot(){
+	for(EpochGuard::Slot* s = all_slots.load(); s; s = s->next){
+		bool expected = false;
+		if(!s->used.load() && s->used.compare_exchange_strong(expected, true)) return s;
+	}
+	EpochGuard::Slot* s = new EpochGuard::Slot;
+	s->used.store(true);
+	s->next = all_slots.load();
+	while(!all_slots.compare_exchange_weak(s->next, s)) {}
+	return s;
+}
+
+struct ThreadSlot {
+	EpochGuard::Slot* slot{ _acquireSlot() };
+	~ThreadSlot() { slot->used.store(false); }
+};
+
+EpochGuard::EpochGuard() {
+	thread_local ThreadSlot thread_slot;
+	slot_ = thread_slot.slot;
+	if(slot_->depth++ == 0) slot_->active.store(global_epoch.load());
+}
+
+EpochGuard::~EpochGuard() {
+	if(--slot_->depth == 0) slot_->active.store(0);
+}
+
+uint64_t EpochGuard::Advance() {
+	return global_epoch.fetch_add(1) + 1;
+}
+
+bool EpochGuard::Quiescent(uint64_t epoch) {
+	for(Slot* s = all_slots.load(); s; s = s->next){
+		uint64_t active = s->active.load();
+		if(active != 0 && active < epoch) return false;
+	}
+	return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/* Epoch based reclamation. A reader marks its critical section with an EpochGuard, which only stores the
+ * current epoch to a slot owned by its thread, so readers never take a lock or wait for a writer. A
+ * writer unlinks an object, advances the epoch, and frees the object once no reader is still in a
+ * critical section entered before that epoch. Guards can be nested.
+ */
+class EpochGuard {
+public:
+	EpochGuard();
+	~EpochGuard();
+
+	EpochGuard(const EpochGuard&) = delete;
+	EpochGuard& operator=(const EpochGuard&) = delete;
+
+	//returns the new epoch, the objects unlinked before the call can be freed when Quiescent(epoch) is true
+	static uint64_t Advance();
+	static bool Quiescent(uint64_t epoch);
+
+	struct Slot;
+
+private:
+	Slot* slot_;
+};
+
+/* RCU style cell: readers get the current value with a single atomic load, a writer publishes a new
+ * value with an atomic swap. The old values are kept until the readers which may still see them have
+ * left their EpochGuard, then they are destroyed by Publish() or Reclaim() of a writer.
+ */
+template<typename T>
+class RcuCell {
+public:
+	explicit RcuCell(std::unique_ptr<T> value) : ptr_(value.release()) {}
+	//no reader should be in the cell any more
+	~RcuCell() { delete ptr_.load(); }
+
+	RcuCell(const RcuCell&) = delete;
+	RcuCell& operator=(const RcuCell&) = delete;
+
+	//the pointer is valid until the EpochGuard of the caller is destroyed
+	const T* Get() const { return ptr_.load(); }
+
+	void Publish(std::unique_ptr<T> value) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::unique_ptr<T> old(ptr_.exchange(value.release()));
+		retired_.push_back(std::make_pair(EpochGuard::Advance(), std::move(old)));
+		_reclaim();
+	}
+
+	//destroys the old values no reader can see, returns how many are still kept
+	size_t Reclaim() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return _reclaim();
+	}
+
+private:
+	size_t _reclaim() {
+		auto iter = retired_.begin();
+		while(iter != retired_.end()){
+			if(EpochGuard::Quiescent(iter->first)) iter = retired_.erase(iter);
+			else ++iter;
+		}
+		return retired_.size();
+	}
+
+	std::atomic<T*> ptr_;
+	std::mutex mutex_; //between writers only
+	std::vector<std::pair<uint64_t, std::unique_ptr<T>>> retired_;
+};
@@ -0,0 +1,72 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utility/rcu_cell.h"
+
+static std::atomic<int> alive{ 0 };
+
+struct Tables {
+	explicit Tables(int v) : version(v), check(v * 7) { alive++; }
+	~Tables() { check = -1; alive--; }
+	int version;
+	int check;
+};
+
+TEST(RcuCellTest, OldValueKeptWhileRead){
+	RcuCell<Tables> cell(std::unique_ptr<Tables>(new Tables(1)));
+	{
+		EpochGuard guard;
+		const Tables* old = cell.Get();
+		cell.Publish(std::unique_ptr<Tables>(new Tables(2)));
+		EXPECT_EQ(cell.Get()->version, 2);
+		EXPECT_EQ(old->check, 7); //still alive
+		EXPECT_EQ(cell.Reclaim(), 1u);
+	}
+	EXPECT_EQ(cell.Reclaim(), 0u);
+	EXPECT_EQ(alive.load(), 1);
+
+	//a guard entered after the publication does not hold the old value
+	cell.Publish(std::unique_ptr<Tables>(new Tables(3)));
+	EpochGuard guard;
+	EXPECT_EQ(cell.Get()->version, 3);
+	cell.Publish(std::unique_ptr<Tables>(new Tables(4)));
+	EXPECT_EQ(cell.Reclaim(), 1u); //version 3 may be seen by this guard
+}
+
+TEST(RcuCellTest, ConcurrentReaders){
+	alive.store(0);
+	{
+		RcuCell<Tables> cell(std::unique_ptr<Tables>(new Tables(0)));
+		std::atomic<bool> stop{ false };
+		std::atomic<int> bad{ 0 };
+		std::vector<std::thread> readers;
+		for(int i = 0; i < 3; i++){
+			readers.emplace_back([&]() {
+				int last = 0;
+				while(!stop.load()){
+					EpochGuard guard;
+					const Tables* t = cell.Get();
+					if(t->check != t->version * 7 || t->version < last) bad++;
+					last = t->version;
+					std::this_thread::yield();
+				}
+			});
+		}
+		for(int v = 1; v <= 2000; v++){
+			cell.Publish(std::unique_ptr<Tables>(new Tables(v)));
+			if(v % 100 == 0) std::this_thread::yield();
+		}
+		stop.store(true);
+		for(auto& r : readers) r.join();
+		EXPECT_EQ(bad.load(), 0);
+		EXPECT_EQ(cell.Reclaim(), 0u);
+		EXPECT_EQ(alive.load(), 1);
+	}
+	EXPECT_EQ(alive.load(), 0);
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
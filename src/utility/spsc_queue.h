@@ -0,0 +1,144 @@
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/* Lock free queue between exactly one producer thread and one consumer thread. The capacity is rounded
+ * up to a power of two. head_ is written only by the consumer and tail_ only by the producer, they are
+ * kept in different cache lines so the two threads do not invalidate each other.
+ *
+ * Push() and Pop() block on a condition variable when the queue is full or empty. The mutex is taken
+ * only by a side which has to wait, and by the other side to wake it: after each push or pop, the
+ * waiting count of the other side is checked behind a fence, so a waiter cannot miss the change it waits
+ * for.
+ */
+template<typename T>
+class SpscQueue {
+public:
+	explicit SpscQueue(size_t capacity) : items_(_roundUp(capacity)), mask_(items_.size() - 1) {}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	//producer only, returns false if the queue is full
+	bool TryPush(const T& item) {
+		if(!_push(item)) return false;
+		_wake(popWaiters_, notEmpty_);
+		return true;
+	}
+
+	//consumer only, returns false if the queue is empty
+	bool TryPop(T& item) {
+		if(!_pop(item)) return false;
+		_wake(pushWaiters_, notFull_);
+		return true;
+	}
+
+	/* Producer only, waits while the queue is full. Returns false if the queue is closed while waiting.
+	 * 'stalled' is set if it had to wait.
+	 */
+	bool Push(const T& item, bool* stalled = nullptr) {
+		if(stalled) *stalled = false;
+		if(TryPush(item)) return true;
+		if(stalled) *stalled = true;
+
+		bool pushed = false;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			pushWaiters_.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			while(!(pushed = _push(item)) && !closed_.load(std::memory_order_relaxed)) notFull_.wait(lock);
+			pushWaiters_.fetch_sub(1, std::memory_order_relaxed);
+		}
+		if(pushed) _wake(popWaiters_, notEmpty_);
+		return pushed;
+	}
+
+	/* Consumer only, waits while the queue is empty. Returns false if the queue is closed and empty.
+	 * 'stalled' is set if it had to wait.
+	 */
+	bool Pop(T& item, bool* stalled = nullptr) {
+		if(stalled) *stalled = false;
+		if(TryPop(item)) return true;
+		if(stalled) *stalled = true;
+
+		bool popped = false;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			popWaiters_.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			while(!(popped = _pop(item)) && !closed_.load(std::memory_order_relaxed)) notEmpty_.wait(lock);
+			//the items pushed before Close() are still popped
+			if(!popped) popped = _pop(item);
+			popWaiters_.fetch_sub(1, std::memory_order_relaxed);
+		}
+		if(popped) _wake(pushWaiters_, notFull_);
+		return popped;
+	}
+
+	//either side or another thread, wakes up both sides and makes them give up waiting
+	void Close() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		closed_.store(true, std::memory_order_relaxed);
+		notFull_.notify_all();
+		notEmpty_.notify_all();
+	}
+	bool IsClosed() const { return closed_.load(std::memory_order_relaxed); }
+
+	size_t Capacity() const { return items_.size(); }
+
+private:
+	bool _push(const T& item) {
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		if(tail - head_.load(std::memory_order_acquire) == items_.size()) return false;
+		items_[tail & mask_] = item;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool _pop(T& item) {
+		size_t head = head_.load(std::memory_order_relaxed);
+		if(head == tail_.load(std::memory_order_acquire)) return false;
+		item = std::move(items_[head & mask_]);
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	//pairs with the fence of the waiter: either the waiter sees the change or this sees the waiter
+	void _wake(const std::atomic<int>& waiters, std::condition_variable& cond) {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(waiters.load(std::memory_order_relaxed) == 0) return;
+		std::lock_guard<std::mutex> lock(mutex_);
+		cond.notify_one();
+	}
+
+	static size_t _roundUp(size_t n) {
+		size_t cap = 1;
+		while(cap < n) cap <<= 1;
+		return cap;
+	}
+
+	static const size_t CACHE_LINE_{ 64 };
+
+	std::vector<T> items_;
+	const size_t mask_;
+
+	char pad0_[CACHE_LINE_];
+	std::atomic<size_t> head_{ 0 };
+	char pad1_[CACHE_LINE_ - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> tail_{ 0 };
+	char pad2_[CACHE_LINE_ - sizeof(std::atomic<size_t>)];
+
+	//only for the slow path
+	std::atomic<int> pushWaiters_{ 0 };
+	std::atomic<int> popWaiters_{ 0 };
+	std::atomic<bool> closed_{ false };
+	std::mutex mutex_;
+	std::condition_variable notFull_;
+	std::condition_variable notEmpty_;
+};
@@ -0,0 +1,92 @@
+#include <mutex>
+#include <thread>
+#include "task_scheduler.h"
+
+//the scheduler and the index of the worker running on this thread
+static thread_local const TaskScheduler* current_scheduler = nullptr;
+static thread_local unsigned current_worker = 0;
+
+TaskScheduler::TaskScheduler(unsigned threads){
+	if(threads == 0) threads = std::thread::hardware_concurrency();
+	if(threads == 0) threads = 1;
+
+	for(unsigned i = 0; i < threads; i++) workers_.emplace_back(new Worker);
+	for(unsigned i = 0; i < threads; i++) workers_[i]->thread = std::thread(&TaskScheduler::_run, this, i);
+}
+
+TaskScheduler::~TaskScheduler(){
+	Wait();
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	wakeup_.notify_all();
+	for(auto& w : workers_) w->thread.join();
+}
+
+void TaskScheduler::Submit(Task task){
+	unsigned index = current_scheduler == this ? current_worker
+				: next_.fetch_add(1, std::memory_order_relaxed) % ThreadCount();
+	pending_.fetch_add(1);
+	queued_.fetch_add(1); //before the push, so it never goes below zero when the task is taken at once
+	{
+		std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+		workers_[index]->tasks.push_back(std::move(task));
+	}
+
+	//taking the lock makes sure a worker is either checking queued_ or waiting, the wakeup is not lost
+	{ std::lock_guard<std::mutex> lock(mutex_); }
+	wakeup_.notify_one();
+}
+
+void TaskScheduler::Wait(){
+	std::unique_lock<std::mutex> lock(mutex_);
+	idle_.wait(lock, [this]() { return pending_.load() == 0; });
+}
+
+bool TaskScheduler::_popLocal(unsigned index, Task& task){
+	Worker& w = *workers_[index];
+	std::lock_guard<std::mutex> lock(w.mutex);
+	if(w.tasks.empty()) return false;
+	task = std::move(w.tasks.back());
+	w.tasks.pop_back();
+	return true;
+}
+
+bool TaskScheduler::_steal(unsigned index, Task& task){
+	for(unsigned k = 1; k < ThreadCount(); k++){
+		Worker& victim = *workers_[(index + k) % ThreadCount()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if(victim.tasks.empty()) continue;
+		task = std::move(victim.tasks.front());
+		victim.tasks.pop_front();
+		stolen_.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+void TaskScheduler::_finishOne(){
+	if(pending_.fetch_sub(1) != 1) return;
+	{ std::lock_guard<std::mutex> lock(mutex_); }
+	idle_.notify_all();
+}
+
+void TaskScheduler::_run(unsigned index){
+	current_scheduler = this;
+	current_worker = index;
+
+	for(;;){
+		Task task;
+		if(_popLocal(index, task) || _steal(index, task)){
+			queued_.fetch_sub(1);
+			task();
+			_finishOne();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		wakeup_.wait(lock, [this]() { return stop_ || queued_.load() != 0; });
+		if(stop_ && queued_.load() == 0) return;
+	}
+}
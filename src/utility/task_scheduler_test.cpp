@@ -0,0 +1,51 @@
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "gtest/gtest.h"
+#include "task_scheduler.h"
+
+TEST(TaskSchedulerTest, RunAllTasks){
+	TaskScheduler scheduler(4);
+	EXPECT_EQ(scheduler.ThreadCount(), 4u);
+
+	std::vector<int> done(10000, 0);
+	for(size_t i = 0; i < done.size(); i++) scheduler.Submit([&done, i]() { done[i]++; });
+	scheduler.Wait();
+	for(int d : done) ASSERT_EQ(d, 1);
+
+	//the scheduler can be reused after Wait()
+	std::atomic<int> counter{ 0 };
+	for(int i = 0; i < 100; i++) scheduler.Submit([&counter]() { counter++; });
+	scheduler.Wait();
+	EXPECT_EQ(counter.load(), 100);
+}
+
+//the tasks submitted by a task go to the deque of its worker, the other workers must steal them
+TEST(TaskSchedulerTest, NestedTasksAreStolen){
+	TaskScheduler scheduler(3);
+	std::atomic<int> counter{ 0 };
+	scheduler.Submit([&scheduler, &counter]() {
+		for(int i = 0; i < 200; i++)
+			scheduler.Submit([&counter]() {
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+				counter++;
+			});
+	});
+	scheduler.Wait();
+	EXPECT_EQ(counter.load(), 200);
+	EXPECT_GT(scheduler.StolenCount(), 0u);
+}
+
+TEST(TaskSchedulerTest, DestroyWithPendingTasks){
+	std::atomic<int> counter{ 0 };
+	{
+		TaskScheduler scheduler(2);
+		for(int i = 0; i < 50; i++) scheduler.Submit([&counter]() { counter++; });
+	}
+	EXPECT_EQ(counter.load(), 50);
+}
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
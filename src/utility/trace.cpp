@@ -0,0 +1,112 @@
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "utility/trace.h"
+
+#ifdef QCOMPILER_ENABLE_TRACE
+
+struct TraceEvent {
+	const char* name;
+	std::chrono::steady_clock::time_point begin;
+	std::chrono::steady_clock::time_point end;
+};
+
+/* Buffers are owned by the registry, so the events of an exited thread can still be exported. Once
+ * 'events' is full, 'next' is the oldest event, which is overwritten by the next one.
+ */
+struct TraceBuffer {
+	unsigned tid;
+	std::vector<TraceEvent> events;
+	size_t next{ 0 };
+};
+
+struct TraceRegistry {
+	std::mutex mutex;
+	std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+//timestamps are relative to the start of the process, before any scope can begin
+static const std::chrono::steady_clock::time_point trace_origin = std::chrono::steady_clock::now();
+
+static TraceRegistry& _registry(){
+	static TraceRegistry registry;
+	return registry;
+}
+
+//the lock is taken once for each thread, when it records its first event
+static TraceBuffer* _threadBuffer(){
+	thread_local TraceBuffer* buffer = nullptr;
+	if(buffer) return buffer;
+	TraceRegistry& registry = _registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.buffers.emplace_back(new TraceBuffer);
+	buffer = registry.buffers.back().get();
+	buffer->tid = static_cast<unsigned>(registry.buffers.size());
+	buffer->events.reserve(1024);
+	return buffer;
+}
+
+void TraceScope::_record(const char* name, std::chrono::steady_clock::time_point begin,
+				std::chrono::steady_clock::time_point end){
+	TraceBuffer* buffer = _threadBuffer();
+	if(buffer->events.size() < TRACE_EVENTS_PER_THREAD){
+		buffer->events.push_back(TraceEvent{ name, begin, end });
+		return;
+	}
+	buffer->events[buffer->next] = TraceEvent{ name, begin, end };
+	buffer->next = (buffer->next + 1) % TRACE_EVENTS_PER_THREAD;
+}
+
+static std::string _escape(const char* name){
+	std::string str;
+	for(const char* p = name; *p; p++){
+		if(*p == '"' || *p == '\\') str += '\\';
+		str += *p;
+	}
+	return str;
+}
+
+bool WriteChromeTrace(const std::string& file){
+	std::ofstream outfile(file);
+	if(!outfile) return false;
+
+	TraceRegistry& registry = _registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto micros = [](std::chrono::steady_clock::time_point t) {
+		return std::chrono::duration<double, std::micro>(t - trace_origin).count();
+	};
+
+	outfile << "{\"traceEvents\":[";
+	bool first = true;
+	outfile.setf(std::ios::fixed);
+	outfile.precision(3);
+	for(const auto& buffer : registry.buffers){
+		const size_t n = buffer->events.size();
+		for(size_t i = 0; i < n; i++){
+			const TraceEvent& e = buffer->events[(buffer->next + i) % n]; //from the oldest one
+			outfile << (first ? "\n" : ",\n") << "{\"name\":\"" << _escape(e.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+				<< buffer->tid << ",\"ts\":" << micros(e.begin) << ",\"dur\":" << micros(e.end) - micros(e.begin) << "}";
+			first = false;
+		}
+	}
+	outfile << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return static_cast<bool>(outfile);
+}
+
+void ClearTrace(){
+	TraceRegistry& registry = _registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for(auto& buffer : registry.buffers) buffer->events.clear(), buffer->next = 0;
+}
+
+#else
+
+bool WriteChromeTrace(const std::string&){
+	return false;
+}
+
+void ClearTrace(){
+}
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/* Scoped tracing of the pipeline stages, exported as Chrome trace JSON(chrome://tracing or
+ * https://ui.perfetto.dev). A scope records one complete event(begin time, duration, thread) into a
+ * buffer owned by its thread, so recording takes no lock. The buffer is a ring which keeps the latest
+ * TRACE_EVENTS_PER_THREAD events, so a long running process(qcompiler_serve) does not grow without
+ * bound. Tracing is compiled in only when
+ * QCOMPILER_ENABLE_TRACE is defined(cmake -DQCOMPILER_ENABLE_TRACE=ON), otherwise QC_TRACE_SCOPE
+ * expands to nothing.
+ */
+
+#ifdef QCOMPILER_ENABLE_TRACE
+
+static const size_t TRACE_EVENTS_PER_THREAD{ 1 << 16 };
+
+class TraceScope {
+public:
+	//name should be a string literal, only the pointer is kept
+	explicit TraceScope(const char* name) : name_(name), begin_(std::chrono::steady_clock::now()) {}
+	~TraceScope() { _record(name_, begin_, std::chrono::steady_clock::now()); }
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	static void _record(const char* name, std::chrono::steady_clock::time_point begin,
+					std::chrono::steady_clock::time_point end);
+
+	const char* name_;
+	std::chrono::steady_clock::time_point begin_;
+};
+
+#define QC_TRACE_CONCAT_(a, b) a##b
+#define QC_TRACE_CONCAT(a, b) QC_TRACE_CONCAT_(a, b)
+#define QC_TRACE_SCOPE(name) TraceScope QC_TRACE_CONCAT(qc_trace_scope_, __LINE__)(name)
+
+#else
+
+#define QC_TRACE_SCOPE(name) do{}while(0)
+
+#endif
+
+/* Writes the events of all the threads(including the exited ones) to file, it should be called when the
+ * traced work has finished. The events dropped by the rings are not written. Returns false if the file cannot be written, or tracing is compiled out.
+ */
+bool WriteChromeTrace(const std::string& file);
+//drops the recorded events
+void ClearTrace();
@@ -0,0 +1,61 @@
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "gtest/gtest.h"
+#include "utility/trace.h"
+
+static std::string ReadFile(const std::string& name){
+	std::ifstream infile(name);
+	std::stringstream ss;
+	ss << infile.rdbuf();
+	return ss.str();
+}
+
+#ifdef QCOMPILER_ENABLE_TRACE
+TEST(TraceTest, ChromeTrace){
+	ClearTrace();
+	{
+		QC_TRACE_SCOPE("outer");
+		std::thread t([]() { QC_TRACE_SCOPE("in \"thread\""); });
+		t.join();
+		QC_TRACE_SCOPE("inner");
+	}
+	ASSERT_TRUE(WriteChromeTrace("trace_test.json"));
+	std::string json = ReadFile("trace_test.json");
+	EXPECT_EQ(json.compare(0, 15, "{\"traceEvents\":"), 0);
+	EXPECT_NE(json.find("\"name\":\"outer\",\"ph\":\"X\""), std::string::npos);
+	EXPECT_NE(json.find("\"name\":\"inner\""), std::string::npos);
+	EXPECT_NE(json.find("\"name\":\"in \\\"thread\\\"\""), std::string::npos);
+	//the events of the two threads have different tids
+	size_t outer = json.find("\"tid\":", json.find("outer")), thread = json.find("\"tid\":", json.find("thread"));
+	EXPECT_NE(json.substr(outer, 8), json.substr(thread, 8));
+
+	ClearTrace();
+	ASSERT_TRUE(WriteChromeTrace("trace_test.json"));
+	EXPECT_EQ(ReadFile("trace_test.json").find("outer"), std::string::npos);
+}
+
+//a thread keeps only its latest events
+TEST(TraceTest, RingOfEvents){
+	ClearTrace();
+	for(int i = 0; i < 10; i++) { QC_TRACE_SCOPE("dropped"); }
+	for(size_t i = 0; i < TRACE_EVENTS_PER_THREAD; i++) { QC_TRACE_SCOPE("kept"); }
+	ASSERT_TRUE(WriteChromeTrace("trace_test.json"));
+	std::string json = ReadFile("trace_test.json");
+	EXPECT_EQ(json.find("dropped"), std::string::npos);
+	size_t kept = 0;
+	for(size_t pos = json.find("\"kept\""); pos != std::string::npos; pos = json.find("\"kept\"", pos + 1)) kept++;
+	EXPECT_EQ(kept, TRACE_EVENTS_PER_THREAD);
+	ClearTrace();
+}
+#else
+TEST(TraceTest, CompiledOut){
+	QC_TRACE_SCOPE("nothing");
+	EXPECT_FALSE(WriteChromeTrace("trace_test.json"));
+}
+#endif
+
+int main(int argc, char* argv[]){
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
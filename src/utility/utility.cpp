@@ -51,6 +51,15 @@ void TrimmedPostfix(std::string& str, char blank, char enter) {
 	str = str.substr(0, ptr - str.c_str() + 1);
 }
 
+void SplitTokens(const std::string& str, std::vector<std::string>& tokens, const std::string& separators){
+	size_t pos = str.find_first_not_of(separators);
+	while(pos != std::string::npos){
+		size_t end = str.find_first_of(separators, pos);
+		tokens.push_back(str.substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+		pos = str.find_first_not_of(separators, end);
+	}
+}
+
 bool CharExistInString(const std::string& str, char c) {
 	size_t index = str.find_first_of(c);
 	return index != std::string::npos;
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <vector>
 #include "rgespecific.h"
 
 static const char UTILITY_BLANK = RgeularSemantics::BLANK;
@@ -17,6 +18,10 @@ void TrimmedPrefix(std::string& str, char blank = UTILITY_BLANK, char enter = UT
 
 void TrimmedPostfix(std::string& str, char blank = UTILITY_BLANK, char enter = UTILITY_ENTER);
 
+//appends the tokens of str to tokens, the tokens are separated by any of the chars in separators
+void SplitTokens(const std::string& str, std::vector<std::string>& tokens,
+				const std::string& separators = std::string(1, UTILITY_BLANK));
+
 bool CharExistInString(const std::string& str, char c);
 
 std::string CharToString(char c);
@@ -0,0 +1,118 @@
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "batch_driver.h"
+#include "parse_cache.h"
+#include "task_scheduler.h"
+#include "utility/trace.h"
+#include "parser_stats.h"
+#include "alloc_stats.h"
+#include "perf_counters.h"
+
+/* Parses many files with one grammar, for example:
+ *     qcompiler_batch grammar.syn corpus/ --threads=8 --reader=MMapFileReader
+ * The second argument is a directory or a file listing the inputs. Every non-empty line of an input
+ * is a sentence. Exits with 1 if any file cannot be opened or any sentence is rejected.
+ * --trace=FILE writes the stages of every thread as Chrome trace JSON, when built with QCOMPILER_ENABLE_TRACE.
+ * --stats=N prints the parser counters and the N hottest productions, when built with
+ * QCOMPILER_ENABLE_PARSER_STATS.
+ * --memory prints the estimated size of the grammar, and the allocations of every stage when built with
+ * QCOMPILER_ENABLE_ALLOC_STATS.
+ * --perf=FILE writes the hardware counters of every stage in the JSON format of qcompiler_bench, when built
+ * with QCOMPILER_ENABLE_PERF_COUNTERS.
+ * --cache=MB keeps the syntax trees in an LRU cache of MB megabytes, so a repeated sentence is parsed once.
+ */
+
+static void Usage(){
+	std::cerr << "usage: qcompiler_batch <grammar.syn> <directory|file list> [--threads=N] [--reader=NAME] [--trace=FILE] [--stats=N] [--memory] [--perf=FILE] [--cache=MB] [--quiet]"
+		<< std::endl;
+}
+
+int main(int argc, char* argv[]){
+	if(argc < 3){
+		Usage();
+		return 1;
+	}
+	unsigned threads = 0;
+	std::string reader = "QFileReader";
+	std::string trace, perf;
+	size_t stats = 0, cache_mb = 0;
+	bool quiet = false, memory = false;
+	for(int i = 3; i < argc; i++){
+		std::string arg = argv[i];
+		if(arg.compare(0, 10, "--threads=") == 0) threads = static_cast<unsigned>(std::strtoul(arg.c_str() + 10, nullptr, 10));
+		else if(arg.compare(0, 9, "--reader=") == 0) reader = arg.substr(9);
+		else if(arg.compare(0, 8, "--trace=") == 0) trace = arg.substr(8);
+		else if(arg.compare(0, 7, "--perf=") == 0) perf = arg.substr(7);
+		else if(arg.compare(0, 8, "--stats=") == 0) stats = std::strtoul(arg.c_str() + 8, nullptr, 10);
+		else if(arg.compare(0, 8, "--cache=") == 0) cache_mb = std::strtoul(arg.c_str() + 8, nullptr, 10);
+		else if(arg == "--memory") memory = true;
+		else if(arg == "--quiet") quiet = true;
+		else {
+			Usage();
+			return 1;
+		}
+	}
+
+	std::unique_ptr<GrammarGenerator> gen = CreateGrammarGenerator("QGrammarGeneratorFactory");
+	if(!gen->OpenFile(argv[1])){
+		std::cerr << "cannot open " << argv[1] << std::endl;
+		return 1;
+	}
+	ContextFreeGrammar gram = gen->GrammarGenerate();
+	gram.ElimLeftRecur();
+	gram.LeftFactoring();
+	gram.GetFirstTable();
+	gram.GetFollowTable();
+	gram.GetSelectTable();
+	if(gram.ConstructLL1Table()){
+		std::cerr << argv[1] << " is not LL(1)" << std::endl;
+		return 1;
+	}
+	CompiledGrammar compiled(gram);
+
+	TaskScheduler scheduler(threads);
+	BatchDriver driver(compiled, scheduler);
+	if(!driver.SetFileReader(reader)){
+		std::cerr << "unknown file reader " << reader << std::endl;
+		return 1;
+	}
+	std::unique_ptr<ParseCache> cache;
+	if(cache_mb){
+		cache.reset(new ParseCache(cache_mb << 20));
+		driver.SetParseCache(cache.get());
+	}
+
+	std::vector<BatchFileResult> results = driver.Run(BatchDriver::ListInputs(argv[2]));
+	size_t sentences = 0, tokens = 0, accepted = 0, failed_files = 0;
+	for(const auto& r : results){
+		sentences += r.sentences, tokens += r.tokens, accepted += r.accepted;
+		if(!r.opened) failed_files++;
+		if(quiet) continue;
+		if(!r.opened) { std::cout << r.file << ": cannot open" << std::endl; continue; }
+		std::cout << r.file << ": " << r.accepted << "/" << r.sentences << " sentences accepted" << std::endl;
+		for(const auto& d : r.diagnostics)
+			std::cout << "  line " << d.line << ", token " << d.diagnostic.position << ": unexpected '"
+				<< d.diagnostic.token << "', expected " << d.diagnostic.expected << std::endl;
+	}
+	if(!trace.empty() && !WriteChromeTrace(trace))
+		std::cerr << "cannot write " << trace << ", tracing needs QCOMPILER_ENABLE_TRACE" << std::endl;
+	if(!perf.empty() && !PerfStats::WriteJson(perf))
+		std::cerr << "cannot write " << perf << ", the counters need QCOMPILER_ENABLE_PERF_COUNTERS" << std::endl;
+	if(stats) ParserStats::Report(std::cout, stats);
+	if(memory){
+		std::cout << "grammar: " << ResidentBytes(gram) << " bytes resident" << std::endl;
+		AllocStats::Report(std::cout);
+	}
+	if(cache){
+		std::cout << "cache: " << cache->Hits() << " hits, " << cache->Misses() << " misses, " << cache->Entries()
+			<< " entries, " << cache->Bytes() << " bytes" << std::endl;
+	}
+	std::cout << results.size() << " files, " << sentences << " sentences, " << tokens << " tokens, "
+		<< accepted << " accepted, " << scheduler.ThreadCount() << " threads" << std::endl;
+	return failed_files != 0 || accepted != sentences ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "syntax_specific.h"
+#include "compiled_grammar.h"
+#include "grammar_synthesizer.h"
+
+/* Generates a synthetic grammar and a corpus derived from it, for example:
+ *     qcompiler_gen --nonterminals=64 --left-recursive=32 --common-prefixes=8 --bytes=8000000
+ * writes synthetic.syn and synthetic.stn(one sentence per line), the same options and seed always
+ * give the same files.
+ */
+
+struct GenOptions{
+	SyntheticGrammarOptions grammar;
+	size_t sentences{ 1 };
+	size_t length{ 1000 };
+	size_t bytes{ 0 };
+	int depth{ 64 };
+	std::string grammarFile{ "synthetic.syn" };
+	std::string corpusFile{ "synthetic.stn" };
+	bool check{ false };
+};
+
+static void Usage(){
+	std::cerr << "usage: qcompiler_gen [options]" << std::endl
+		<< "  --nonterminals=N       operator levels of the grammar(8)" << std::endl
+		<< "  --alternatives=N       operators of each level(2)" << std::endl
+		<< "  --left-recursive=N     left recursive levels, the others share a common prefix(8)" << std::endl
+		<< "  --common-prefixes=N    pairs of operands sharing a common prefix(0)" << std::endl
+		<< "  --seed=N               random seed(0)" << std::endl
+		<< "  --sentences=N          sentences in the corpus(1)" << std::endl
+		<< "  --length=N             tokens of each sentence(1000)" << std::endl
+		<< "  --bytes=N              generate sentences until the corpus has N bytes, overrides --sentences" << std::endl
+		<< "  --depth=N              nesting depth limit of the derivation(64)" << std::endl
+		<< "  --grammar=FILE         output grammar(synthetic.syn)" << std::endl
+		<< "  --corpus=FILE          output corpus(synthetic.stn)" << std::endl
+		<< "  --check                parse every sentence and report the rejected ones" << std::endl;
+}
+
+static bool ParseArgs(int argc, char* argv[], GenOptions& options){
+	for(int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+		if(arg == "--check") { options.check = true; continue; }
+		auto pos = arg.find('=');
+		if(arg.compare(0, 2, "--") != 0 || pos == std::string::npos) return false;
+		std::string name = arg.substr(2, pos - 2), value = arg.substr(pos + 1);
+		unsigned long num = std::strtoul(value.c_str(), nullptr, 10);
+
+		if(name == "nonterminals") options.grammar.nonTerminals = static_cast<int>(num);
+		else if(name == "alternatives") options.grammar.alternatives = static_cast<int>(num);
+		else if(name == "left-recursive") options.grammar.leftRecursive = static_cast<int>(num);
+		else if(name == "common-prefixes") options.grammar.commonPrefixes = static_cast<int>(num);
+		else if(name == "seed") options.grammar.seed = static_cast<unsigned>(num);
+		else if(name == "sentences") options.sentences = num;
+		else if(name == "length") options.length = num;
+		else if(name == "bytes") options.bytes = num;
+		else if(name == "depth") options.depth = static_cast<int>(num);
+		else if(name == "grammar") options.grammarFile = value;
+		else if(name == "corpus") options.corpusFile = value;
+		else return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]){
+	GenOptions options;
+	if(!ParseArgs(argc, argv, options)){
+		Usage();
+		return 1;
+	}
+
+	std::ofstream syn(options.grammarFile);
+	syn << SynthesizeGrammar(options.grammar);
+	syn.close();
+
+	std::unique_ptr<GrammarGenerator> gen = CreateGrammarGenerator("QGrammarGeneratorFactory");
+	if(!gen->OpenFile(options.grammarFile)){
+		std::cerr << "cannot open " << options.grammarFile << std::endl;
+		return 1;
+	}
+	ContextFreeGrammar gram = gen->GrammarGenerate();
+	gram.ElimLeftRecur();
+	gram.LeftFactoring();
+	gram.GetFirstTable();
+	gram.GetFollowTable();
+	gram.GetSelectTable();
+	if(gram.ConstructLL1Table()){
+		std::cerr << "the synthetic grammar is not LL(1)" << std::endl;
+		return 1;
+	}
+
+	std::unique_ptr<CompiledGrammar> compiled;
+	if(options.check) compiled.reset(new CompiledGrammar(gram));
+
+	std::ofstream stn(options.corpusFile);
+	SentenceDeriver deriver(gram, options.grammar.seed);
+	size_t bytes = 0, count = 0, tokens = 0, rejected = 0;
+	while(options.bytes ? bytes < options.bytes : count < options.sentences){
+		std::vector<std::string> sen = deriver.Derive(options.length, options.depth);
+		std::string line;
+		for(const auto& t : sen){
+			if(!line.empty()) line += ' ';
+			line += t;
+		}
+		stn << line << '\n';
+		bytes += line.size() + 1;
+		tokens += sen.size();
+		count++;
+		if(compiled && !compiled->Parse(sen)->IsAccepted()) rejected++;
+	}
+	stn.close();
+
+	std::cout << options.grammarFile << ": " << gram.nonTerminals.size() << " nonterminals, "
+		<< gram.productions.size() << " productions after the transformations" << std::endl;
+	std::cout << options.corpusFile << ": " << count << " sentences, " << tokens << " tokens, "
+		<< bytes << " bytes" << std::endl;
+	if(compiled) std::cout << rejected << " sentences rejected" << std::endl;
+	return rejected ? 1 : 0;
+}
@@ -0,0 +1,88 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "language.h"
+#include "parse_service.h"
+#include "task_scheduler.h"
+
+/* Loads the languages once and serves lex/parse requests over a Unix domain socket, for example:
+ *     qcompiler_serve /tmp/qcompiler.sock expr=grammar.syn json=json.syn,json.rge
+ * A language may have a lexical rules file after its grammar. The lexers and grammars of all the
+ * languages are built in parallel at startup. The protocol is described in parse_service.h. SIGHUP reloads the grammars without stopping the service,
+ * SIGINT or SIGTERM stops it. --cache=MB caches the syntax trees of the requests in MB megabytes.
+ */
+
+static ParseService* running_service = nullptr;
+
+static void StopService(int){
+	if(running_service) running_service->Stop();
+}
+
+static void ReloadService(int){
+	if(running_service) running_service->RequestReload();
+}
+
+static void Usage(){
+	std::cerr << "usage: qcompiler_serve <socket path> [--cache=MB] <name>=<grammar.syn>[,<domain.rge>] [<name>=...]" << std::endl;
+}
+
+int main(int argc, char* argv[]){
+	if(argc < 3){
+		Usage();
+		return 1;
+	}
+
+	std::vector<LanguageSpec> specs;
+	size_t cache_mb = 0;
+	for(int i = 2; i < argc; i++){
+		std::string arg = argv[i];
+		if(arg.compare(0, 8, "--cache=") == 0){
+			cache_mb = std::strtoul(arg.c_str() + 8, nullptr, 10);
+			continue;
+		}
+		auto pos = arg.find('=');
+		if(pos == std::string::npos || pos == 0){
+			Usage();
+			return 1;
+		}
+		auto comma = arg.find(',', pos);
+		LanguageSpec spec{ arg.substr(0, pos), arg.substr(pos + 1, comma == std::string::npos ? std::string::npos : comma - pos - 1), "" };
+		if(comma != std::string::npos) spec.lexFile = arg.substr(comma + 1);
+		specs.push_back(spec);
+	}
+
+	ParseService service;
+	if(cache_mb) service.EnableCache(cache_mb << 20);
+	std::vector<std::string> errors;
+	std::vector<std::unique_ptr<Language>> langs;
+	{
+		TaskScheduler scheduler;
+		langs = Language::LoadAll(specs, scheduler, &errors);
+	}
+	for(size_t i = 0; i < langs.size(); i++){
+		if(!langs[i]){
+			std::cerr << errors[i] << std::endl;
+			return 1;
+		}
+		if(!service.AddLanguage(std::move(langs[i]))){
+			std::cerr << "language " << specs[i].name << " is defined twice" << std::endl;
+			return 1;
+		}
+	}
+
+	running_service = &service;
+	std::signal(SIGINT, StopService);
+	std::signal(SIGTERM, StopService);
+#ifdef SIGHUP
+	std::signal(SIGHUP, ReloadService);
+#endif
+	std::cout << "serving " << specs.size() << " languages on " << argv[1] << std::endl;
+	if(!service.Serve(argv[1])){
+		std::cerr << "cannot listen on " << argv[1] << std::endl;
+		return 1;
+	}
+	return 0;
+}